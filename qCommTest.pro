@@ -16,9 +16,16 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # Uncomment to disable deprecated APIs up to a specific Qt version
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000
 
-SOURCES +=     src/main.cpp     src/tcp_server.cpp     src/mainwindow.cpp     src/serial_port.cpp
+SOURCES +=     src/main.cpp     src/tcp_server.cpp     src/mainwindow.cpp     src/serial_port.cpp     src/traffic_capture.cpp     src/replay_port.cpp     src/frame_trace.cpp     src/frame_pool.cpp     src/ring_buffer.cpp     src/test_metrics.cpp     src/metrics_server.cpp     src/scoped_trace.cpp     src/socket_profile.cpp     src/run_stats.cpp     src/benchmark.cpp     src/time_series.cpp     src/live_chart.cpp     src/link_emulator.cpp     src/simd_ops.cpp     src/prbs.cpp     src/ber_test.cpp     src/payload_generator.cpp     src/clock_offset.cpp     src/byte_stuffing.cpp     src/soak_report.cpp     src/log_model.cpp     src/native_serial.cpp     src/serial_bench.cpp     src/port_discovery.cpp     src/stage_latency.cpp     src/test_plan.cpp     src/auto_tune.cpp     src/file_transfer.cpp     src/tx_batcher.cpp     src/frame_log.cpp     src/protocol.cpp
 
-HEADERS +=     src/tcp_server.h     src/mainwindow.h     src/serial_port.h
+HEADERS +=     src/tcp_server.h     src/mainwindow.h     src/serial_port.h     src/mono_clock.h     src/traffic_capture.h     src/replay_port.h     src/frame_trace.h     src/frame_pool.h     src/ring_buffer.h     src/test_metrics.h     src/metrics_server.h     src/scoped_trace.h     src/socket_profile.h     src/run_stats.h     src/benchmark.h     src/time_series.h     src/live_chart.h     src/link_emulator.h     src/simd_ops.h     src/prbs.h     src/ber_test.h     src/payload_generator.h     src/clock_offset.h     src/byte_stuffing.h     src/soak_report.h     src/log_model.h     src/native_serial.h     src/serial_bench.h     src/port_discovery.h     src/stage_latency.h     src/test_plan.h     src/auto_tune.h     src/file_transfer.h     src/tx_batcher.h     src/frame_log.h     src/alloc_counter.h     src/protocol.h
+
+# The allocation counter replaces malloc and operator new for the whole process, test builds only
+# qmake CONFIG+=alloc_check
+alloc_check {
+    DEFINES += QCOMMTEST_ALLOC_CHECK
+    SOURCES += src/alloc_counter.cpp
+}
 
 FORMS +=     src/mainwindow.ui
 
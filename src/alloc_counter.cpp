@@ -0,0 +1,118 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "alloc_counter.h"
+#include <cstdlib>
+#include <new>
+
+static thread_local bool s_counting = false;
+static qint64 s_count = 0;      // Stored only by the thread that counts
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+// Interposed for the whole process, Qt's own calls to malloc land here as well
+extern "C" void *malloc(size_t size)
+{
+    if(s_counting)
+    {
+        s_count++;
+    }
+
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if(s_counting)
+    {
+        s_count++;
+    }
+
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+    if(s_counting)
+    {
+        s_count++;
+    }
+
+    return __libc_realloc(p, size);
+}
+
+static void *RawAlloc(size_t size)
+{
+    return __libc_malloc(size ? size : 1);
+}
+#else
+static void *RawAlloc(size_t size)
+{
+    return std::malloc(size ? size : 1);
+}
+#endif
+
+void *operator new(size_t size)
+{
+    void *p;
+
+    if(s_counting)
+    {
+        s_count++;
+    }
+
+    p = RawAlloc(size);
+
+    if(nullptr == p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+AllocScope::AllocScope(bool count) : m_previous(s_counting)
+{
+    s_counting = count;
+}
+
+AllocScope::~AllocScope()
+{
+    s_counting = m_previous;
+}
+
+qint64 AllocScope::Count()
+{
+    return s_count;
+}
@@ -0,0 +1,56 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <QtGlobal>
+
+/*
+    Heap allocation counter behind --alloc-check, built only with QCOMMTEST_ALLOC_CHECK.
+    The global operator new is replaced, and on glibc malloc, calloc and realloc too,
+    because Qt containers allocate with malloc. Only allocations of the thread inside
+    an AllocScope are counted. Without the option the scopes compile to nothing.
+*/
+class AllocScope
+{
+public:
+#if defined(QCOMMTEST_ALLOC_CHECK)
+    explicit AllocScope(bool count);
+    ~AllocScope();
+    static qint64 Count();
+    static bool Available()
+    {
+        return true;
+    }
+
+private:
+    bool    m_previous;
+#else
+    explicit AllocScope(bool)
+    {
+    }
+    static qint64 Count()
+    {
+        return 0;
+    }
+    static bool Available()
+    {
+        return false;
+    }
+#endif
+};
+
+// Stops counting for the calls into Qt I/O and timers, their buffers are not the engine's
+class AllocPause : public AllocScope
+{
+public:
+    AllocPause() : AllocScope(false)
+    {
+    }
+};
+
+#endif // ALLOC_COUNTER_H
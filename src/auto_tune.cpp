@@ -0,0 +1,318 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "auto_tune.h"
+#include "protocol.h"
+#include <QStringList>
+
+const double TUNE_TOLERANCE     = 0.02;     // Search stops when the bracket is this close, relative
+const int TUNE_MAX_FRAMES       = 1000000;
+const int TUNE_MAX_STEPS        = 20;
+
+template <typename T>
+static bool ParseList(const QString &value, QVector<T> &list)
+{
+    list.clear();
+
+    for(const QString &item : value.split(':', Qt::SkipEmptyParts))
+    {
+        bool ok;
+        qint64 number = item.trimmed().toLongLong(&ok);
+
+        if(!ok || number <= 0)
+        {
+            return false;
+        }
+
+        list.append(static_cast<T>(number));
+    }
+
+    return !list.isEmpty();
+}
+
+bool TuneConfig::Parse(const QString &spec, TuneConfig &config, QString &error)
+{
+    config = TuneConfig();
+
+    for(const QString &item : spec.split(',', Qt::SkipEmptyParts))
+    {
+        QStringList pair = item.split('=');
+        QString key = pair.value(0).trimmed();
+        QString value = pair.value(1).trimmed();
+        bool ok = (2 == pair.size());
+
+        if(ok && "sizes" == key)
+        {
+            ok = ParseList(value, config.sizes);
+        }
+        else if(ok && "windows" == key)
+        {
+            ok = ParseList(value, config.windows);
+        }
+        else if(ok && "bauds" == key)
+        {
+            ok = ParseList(value, config.bauds);
+        }
+        else if(ok && "errors" == key)
+        {
+            config.maxErrorRate = value.toDouble(&ok);
+        }
+        else if(ok && "p99" == key)
+        {
+            config.maxP99 = value.toDouble(&ok);
+        }
+        else if(ok && "frames" == key)
+        {
+            config.frames = value.toInt(&ok);
+        }
+        else if(ok && "steps" == key)
+        {
+            config.steps = value.toInt(&ok);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if(!ok)
+        {
+            error = "Invalid tune parameter " + item;
+            return false;
+        }
+    }
+
+    for(int size : config.sizes)
+    {
+        if(PROTOCOL_MAX_PAYLOAD < size)
+        {
+            error = QString("Tune size %1 too large").arg(size);
+            return false;
+        }
+    }
+
+    for(int window : config.windows)
+    {
+        if(PROTOCOL_MAX_WINDOW < window)
+        {
+            error = QString("Tune window %1 too large").arg(window);
+            return false;
+        }
+    }
+
+    if(config.maxErrorRate < 0 || 1 < config.maxErrorRate || config.maxP99 < 0 ||
+            config.frames < 1 || TUNE_MAX_FRAMES < config.frames || config.steps < 1 || TUNE_MAX_STEPS < config.steps)
+    {
+        error = "Tune parameter out of range";
+        return false;
+    }
+
+    return true;
+}
+
+int TuneConfig::MaxSize() const
+{
+    int size = 0;
+
+    for(int s : sizes)
+    {
+        size = qMax(size, s);
+    }
+
+    return size;
+}
+
+int TuneConfig::MaxWindow() const
+{
+    int window = 0;
+
+    for(int w : windows)
+    {
+        window = qMax(window, w);
+    }
+
+    return window;
+}
+
+//---------------------------------------------------------------
+
+void AutoTune::Start(const TuneConfig &config)
+{
+    int bauds = qMax(1, config.bauds.size());
+
+    m_config = config;
+    m_cells.clear();
+
+    // Baud rate major, one session walks every size and window of one baud rate
+    for(int b = 0; b < bauds; b++)
+    {
+        for(int size : config.sizes)
+        {
+            for(int window : config.windows)
+            {
+                TuneCell cell;
+                cell.baud = config.bauds.value(b);
+                cell.size = size;
+                cell.window = window;
+                m_cells.append(cell);
+            }
+        }
+    }
+
+    m_baud = 0;
+    m_cell = 0;
+    m_rate = 0;
+    m_step = 0;
+    m_active = true;
+}
+
+void AutoTune::Stop()
+{
+    m_active = false;
+}
+
+bool AutoTune::isActive() const
+{
+    return m_active;
+}
+
+qint32 AutoTune::getBaud() const
+{
+    return m_config.bauds.value(m_baud);
+}
+
+PlanPhase AutoTune::Phase() const
+{
+    const TuneCell &cell = m_cells[m_cell];
+    PlanPhase phase;
+    phase.name = QString("%1/w%2").arg(cell.size).arg(cell.window);
+    phase.sizeFrom = cell.size;
+    phase.sizeTo = cell.size;
+    phase.repeat = m_config.frames;
+    phase.window = cell.window;
+    phase.rate = m_rate;
+    phase.maxErrors = static_cast<qint64>(m_config.maxErrorRate * m_config.frames);
+    phase.maxP99 = m_config.maxP99;
+    return phase;
+}
+
+bool AutoTune::Next(const PhaseResult &result)
+{
+    TuneCell &cell = m_cells[m_cell];
+    cell.trials++;
+
+    if(result.passed && (!cell.found || cell.best.throughput < result.throughput))
+    {
+        cell.found = true;
+        cell.best = result;
+        cell.rate = m_rate;
+    }
+
+    if(0 == m_rate)
+    {
+        double achieved = (0 < result.seconds) ? result.frames / result.seconds : 0;
+
+        if(result.passed || achieved <= 0)
+        {
+            NextCell();
+        }
+        else
+        {
+            // Unpaced is over the limits, the answer is below what it managed
+            m_low = 0;
+            m_high = achieved;
+            m_rate = achieved / 2;
+        }
+    }
+    else
+    {
+        if(result.passed)
+        {
+            m_low = m_rate;
+        }
+        else
+        {
+            m_high = m_rate;
+        }
+
+        if(m_config.steps <= ++m_step || m_high - m_low < TUNE_TOLERANCE * m_high)
+        {
+            NextCell();
+        }
+        else
+        {
+            m_rate = (m_low + m_high) / 2;
+        }
+    }
+
+    return m_cell < (m_baud + 1) * CellsPerBaud();
+}
+
+bool AutoTune::NextBaud()
+{
+    m_baud++;
+    return m_baud < m_config.bauds.size();
+}
+
+int AutoTune::CellsPerBaud() const
+{
+    return m_config.sizes.size() * m_config.windows.size();
+}
+
+void AutoTune::NextCell()
+{
+    m_cell++;
+    m_rate = 0;
+    m_step = 0;
+}
+
+QString AutoTune::Report(const QString &device) const
+{
+    QStringList lines;
+    const TuneCell *best = nullptr;
+
+    lines << "Capacity of " + device;
+    lines << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+          .arg(QLatin1String("baud"), 8).arg(QLatin1String("size"), 6).arg(QLatin1String("window"), 6)
+          .arg(QLatin1String("frames/s"), 9).arg(QLatin1String("KB/s"), 9).arg(QLatin1String("p99 us"), 9)
+          .arg(QLatin1String("err %"), 7).arg(QLatin1String("trials"), 6);
+
+    for(const TuneCell &cell : m_cells)
+    {
+        QString baud = cell.baud ? QString::number(cell.baud) : QString("-");
+
+        if(!cell.found)
+        {
+            lines << QString("%1 %2 %3 %4").arg(baud, 8).arg(cell.size, 6).arg(cell.window, 6)
+                  .arg(QString("none within limits, %1 trials").arg(cell.trials), 9);
+            continue;
+        }
+
+        lines << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+              .arg(baud, 8).arg(cell.size, 6).arg(cell.window, 6)
+              .arg(cell.rate ? QString::number(cell.rate, 'f', 0) : QString("max"), 9)
+              .arg(cell.best.throughput, 9, 'f', 1).arg(cell.best.p99, 9, 'f', 1)
+              .arg(cell.best.frames ? 100.0 * cell.best.errors / cell.best.frames : 0, 7, 'f', 3).arg(cell.trials, 6);
+
+        if(nullptr == best || best->best.throughput < cell.best.throughput)
+        {
+            best = &cell;
+        }
+    }
+
+    if(best)
+    {
+        lines << QString("Sustainable %1 KB/s with %2 byte frames, window %3%4%5")
+              .arg(best->best.throughput, 0, 'f', 1).arg(best->size).arg(best->window)
+              .arg(best->baud ? QString(" at %1 baud").arg(best->baud) : QString())
+              .arg(best->rate ? QString(", paced to %1 frames/s").arg(best->rate, 0, 'f', 0) : QString());
+    }
+    else
+    {
+        lines << "No load met the limits";
+    }
+
+    return lines.join('\n');
+}
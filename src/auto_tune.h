@@ -0,0 +1,75 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef AUTO_TUNE_H
+#define AUTO_TUNE_H
+
+#include <QString>
+#include <QVector>
+#include "test_plan.h"
+
+struct TuneConfig
+{
+    QVector<int>    sizes = { 16, 64, 256 };    // [bytes] payload
+    QVector<int>    windows = { 1, 2, 4 };      // Frames in flight
+    QVector<qint32> bauds;                      // Serial only, empty keeps the port setting
+    double          maxErrorRate = 0;           // Errors per frame sent
+    double          maxP99 = 0;                 // [us] 0 for no limit
+    int             frames = 200;               // Per trial
+    int             steps = 6;                  // Binary search steps per size and window
+
+    // key=value list, lists separated by ':'
+    // e.g. sizes=16:64:256,windows=1:4,bauds=115200:921600,errors=0.001,p99=20000,frames=200,steps=6
+    static bool Parse(const QString &spec, TuneConfig &config, QString &error);
+    int MaxSize() const;
+    int MaxWindow() const;
+};
+
+// Best sustainable load found for one size, window and baud rate
+struct TuneCell
+{
+    qint32      baud = 0;
+    int         size = 0;
+    int         window = 0;
+    double      rate = 0;           // [frames/s] offered, 0 when unpaced already passed
+    int         trials = 0;
+    bool        found = false;
+    PhaseResult best;
+};
+
+/*
+    Capacity search. Every size and window combination is first tried unpaced. If that
+    breaks the error rate or p99 limit, the offered rate is binary searched between zero
+    and the rate the unpaced trial achieved. Baud rates are swept one session each.
+*/
+class AutoTune
+{
+public:
+    void Start(const TuneConfig &config);
+    void Stop();
+    bool isActive() const;
+    PlanPhase Phase() const;                    // The trial to run next
+    bool Next(const PhaseResult &result);       // false once every cell of this baud rate is done
+    bool NextBaud();                            // false once every baud rate is done
+    qint32 getBaud() const;                     // 0 without a baud sweep
+    QString Report(const QString &device) const;
+
+private:
+    int CellsPerBaud() const;
+    void NextCell();
+
+    TuneConfig          m_config;
+    bool                m_active = false;
+    int                 m_baud = 0;
+    int                 m_cell = 0;
+    int                 m_step = 0;
+    double              m_rate = 0;     // [frames/s] of the current trial, 0 unpaced
+    double              m_low = 0;      // [frames/s] highest passing rate
+    double              m_high = 0;     // [frames/s] lowest failing rate
+    QVector<TuneCell>   m_cells;
+};
+
+#endif // AUTO_TUNE_H
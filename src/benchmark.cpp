@@ -0,0 +1,281 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "benchmark.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QDebug>
+
+const int BASELINE_VERSION = 1;
+
+void Benchmark::Start(int runs, int warmup)
+{
+    m_runs = runs;
+    m_warmup = warmup;
+    m_seen = 0;
+    m_timedOut = 0;
+    m_results.clear();
+    m_results.reserve(runs);
+    m_active = 0 < runs;
+}
+
+void Benchmark::Stop()
+{
+    m_active = false;
+}
+
+bool Benchmark::isActive() const
+{
+    return m_active;
+}
+
+bool Benchmark::isWarmup() const
+{
+    return m_seen < m_warmup;
+}
+
+int Benchmark::getRun() const
+{
+    return m_seen;
+}
+
+int Benchmark::getCompleted() const
+{
+    return m_results.size();
+}
+
+void Benchmark::setStartupTime(double ms)
+{
+    m_startupMs = ms;
+}
+
+bool Benchmark::AddRun(const RunSummary &run)
+{
+    if(!m_active)
+    {
+        return false;
+    }
+
+    if(!isWarmup() && run.timedOut)
+    {
+        // Its figures cover only part of the session
+        m_timedOut++;
+    }
+    else if(!isWarmup())
+    {
+        m_results.append(run);
+    }
+
+    m_seen++;
+
+    if(m_seen < m_warmup + m_runs)
+    {
+        return false;
+    }
+
+    m_active = false;
+    return true;
+}
+
+const char *Benchmark::MetricName(Bench_Metric_t metric)
+{
+    switch(metric)
+    {
+        case Bench_Metric_t::Throughput:
+            return "throughput_kbps";
+
+        case Bench_Metric_t::P50:
+            return "p50_us";
+
+        case Bench_Metric_t::P99:
+            return "p99_us";
+
+        default:
+            break;
+    }
+
+    return "unknown";
+}
+
+double Benchmark::Value(const RunSummary &run, Bench_Metric_t metric)
+{
+    switch(metric)
+    {
+        case Bench_Metric_t::Throughput:
+            return run.throughput;
+
+        case Bench_Metric_t::P50:
+            return run.p50;
+
+        case Bench_Metric_t::P99:
+            return run.p99;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+SampleStats Benchmark::Stats(Bench_Metric_t metric) const
+{
+    QVector<double> values;
+
+    for(const RunSummary &run : m_results)
+    {
+        values.append(Value(run, metric));
+    }
+
+    return Describe(values);
+}
+
+QString Benchmark::Report() const
+{
+    QStringList lines;
+    lines << FormatComparison(m_results);
+    lines << QString("%1 runs after %2 warm-up, startup %3 ms").arg(m_results.size()).arg(m_warmup).arg(m_startupMs, 0, 'f', 1);
+
+    if(m_timedOut)
+    {
+        lines << QString("%1 runs timed out and are left out of the statistics").arg(m_timedOut);
+    }
+
+    for(int m = 0; m < static_cast<int>(Bench_Metric_t::Count); m++)
+    {
+        SampleStats stats = Stats(static_cast<Bench_Metric_t>(m));
+        lines << QString("%1 mean %2 stddev %3 95% CI [%4, %5]")
+              .arg(QLatin1String(MetricName(static_cast<Bench_Metric_t>(m))), -16)
+              .arg(stats.mean, 0, 'f', 2).arg(stats.stddev, 0, 'f', 2)
+              .arg(stats.mean - stats.ci95, 0, 'f', 2).arg(stats.mean + stats.ci95, 0, 'f', 2);
+    }
+
+    return lines.join('\n');
+}
+
+bool Benchmark::SaveBaseline(const QString &path) const
+{
+    QJsonObject root, metrics;
+    QJsonArray runs;
+    QFile file(path);
+
+    for(int m = 0; m < static_cast<int>(Bench_Metric_t::Count); m++)
+    {
+        SampleStats stats = Stats(static_cast<Bench_Metric_t>(m));
+        QJsonObject metric;
+        metric["mean"] = stats.mean;
+        metric["stddev"] = stats.stddev;
+        metric["n"] = stats.n;
+        metrics[MetricName(static_cast<Bench_Metric_t>(m))] = metric;
+    }
+
+    for(const RunSummary &run : m_results)
+    {
+        QJsonObject values;
+
+        for(int m = 0; m < static_cast<int>(Bench_Metric_t::Count); m++)
+        {
+            values[MetricName(static_cast<Bench_Metric_t>(m))] = Value(run, static_cast<Bench_Metric_t>(m));
+        }
+
+        values["errors"] = run.errors;
+        runs.append(values);
+    }
+
+    root["version"] = BASELINE_VERSION;
+    root["startup_ms"] = m_startupMs;
+    root["metrics"] = metrics;
+    root["runs"] = runs;
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Unable to write baseline" << path << ":" << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+    return true;
+}
+
+Baseline_Result_t Benchmark::CompareBaseline(const QString &path, QString &report) const
+{
+    QFile file(path);
+    QJsonParseError error;
+    QJsonDocument document;
+    QJsonObject metrics;
+    QStringList lines;
+    bool regressed = false;
+    int compared = 0;
+
+    if(m_results.isEmpty())
+    {
+        report = "No completed run to compare";
+        return Baseline_Result_t::Invalid;
+    }
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        report = "Unable to open baseline " + path + " : " + file.errorString();
+        return Baseline_Result_t::Invalid;
+    }
+
+    document = QJsonDocument::fromJson(file.readAll(), &error);
+
+    if(QJsonParseError::NoError != error.error || !document.isObject())
+    {
+        report = "Unable to parse baseline " + path + " : " + error.errorString();
+        return Baseline_Result_t::Invalid;
+    }
+
+    metrics = document.object()["metrics"].toObject();
+
+    for(int m = 0; m < static_cast<int>(Bench_Metric_t::Count); m++)
+    {
+        Bench_Metric_t metric = static_cast<Bench_Metric_t>(m);
+        QJsonObject saved = metrics[MetricName(metric)].toObject();
+        SampleStats base, current = Stats(metric);
+        bool worse, significant;
+
+        if(saved.isEmpty() || !saved["mean"].isDouble())
+        {
+            continue;
+        }
+
+        compared++;
+
+        base.mean = saved["mean"].toDouble();
+        base.stddev = saved["stddev"].toDouble();
+        base.n = saved["n"].toInt();
+
+        if(current.n < 2 || base.n < 2)
+        {
+            // One run has no variance, the t-test could never find a regression
+            report = QString("Baseline %1 : %2 needs at least 2 runs on both sides, got %3 and %4")
+                     .arg(path).arg(QLatin1String(MetricName(metric))).arg(base.n).arg(current.n);
+            return Baseline_Result_t::Invalid;
+        }
+
+        worse = (Bench_Metric_t::Throughput == metric) ? current.mean < base.mean : current.mean > base.mean;
+        significant = SignificantlyDifferent(current, base);
+        regressed |= worse && significant;
+        lines << QString("%1 baseline %2 now %3 (%4%) %5")
+              .arg(QLatin1String(MetricName(metric)), -16)
+              .arg(base.mean, 0, 'f', 2).arg(current.mean, 0, 'f', 2)
+              .arg(base.mean ? 100.0 * (current.mean - base.mean) / base.mean : 0.0, 0, 'f', 1)
+              .arg(QLatin1String(!significant ? "no significant change" : (worse ? "REGRESSION" : "improved")));
+    }
+
+    if(0 == compared)
+    {
+        report = "No metric of baseline " + path + " matches this benchmark";
+        return Baseline_Result_t::Invalid;
+    }
+
+    report = lines.join('\n');
+    return regressed ? Baseline_Result_t::Regressed : Baseline_Result_t::Passed;
+}
@@ -0,0 +1,63 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QVector>
+#include "run_stats.h"
+
+enum class Bench_Metric_t
+{
+    Throughput,     // [KB/s] higher is better
+    P50,            // [us] lower is better
+    P99,            // [us] lower is better
+    Count
+};
+
+enum class Baseline_Result_t
+{
+    Passed,
+    Regressed,      // Significantly worse on at least one metric
+    Invalid         // Missing or unreadable baseline, no common metric or no completed run
+};
+
+/*
+    Repeats the test session, drops the warm-up runs and summarizes the rest.
+    Baseline file : JSON with mean, stddev and n of every metric plus the raw runs.
+*/
+class Benchmark
+{
+public:
+    void Start(int runs, int warmup);
+    void Stop();
+    bool isActive() const;
+    bool isWarmup() const;
+    int getRun() const;
+    void setStartupTime(double ms);
+    bool AddRun(const RunSummary &run);     // true once the last measured run is in, timed out runs are left out
+    QString Report() const;
+    bool SaveBaseline(const QString &path) const;
+    Baseline_Result_t CompareBaseline(const QString &path, QString &report) const;
+    int getCompleted() const;
+
+    static const char *MetricName(Bench_Metric_t metric);
+
+private:
+    SampleStats Stats(Bench_Metric_t metric) const;
+    static double Value(const RunSummary &run, Bench_Metric_t metric);
+
+    bool                m_active = false;
+    int                 m_runs = 0;
+    int                 m_warmup = 0;
+    int                 m_seen = 0;
+    int                 m_timedOut = 0;     // Measured runs that ended on a timeout
+    double              m_startupMs = 0;    // Process start to first event loop pass
+    QVector<RunSummary> m_results;
+};
+
+#endif // BENCHMARK_H
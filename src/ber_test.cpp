@@ -0,0 +1,108 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "ber_test.h"
+#include "simd_ops.h"
+#include <cmath>
+
+const int BER_BURST_GAP         = 8;    // [bytes] clean bytes that end an error burst
+const int BER_SYNC_LOSS_RATIO   = 4;    // More than 1 / ratio of the bits wrong means out of sync
+
+void BerCounter::Reset()
+{
+    m_bits = 0;
+    m_errors = 0;
+    m_bursts = 0;
+    m_resyncs = 0;
+    m_errorFrames = 0;
+}
+
+void BerCounter::Compare(const uchar *expected, const uchar *received, qint64 n, const PrbsGenerator &prbs)
+{
+    simd::BitErrors errors = simd::CountBitErrors(expected, received, n, BER_BURST_GAP);
+
+    // Half the bits wrong is what a misaligned pattern looks like, if the data is still
+    // a valid piece of the sequence the frame is a slip, not a burst of bit errors
+    if(errors.bits > n * 8 / BER_SYNC_LOSS_RATIO && prbs.isSelfConsistent(received, n, n / 64))
+    {
+        m_resyncs++;
+        return;
+    }
+
+    m_bits += n * 8;
+    m_errors += errors.bits;
+    m_bursts += errors.bursts;
+
+    if(errors.bits)
+    {
+        m_errorFrames++;
+    }
+}
+
+qint64 BerCounter::getBits() const
+{
+    return m_bits;
+}
+
+qint64 BerCounter::getErrors() const
+{
+    return m_errors;
+}
+
+qint64 BerCounter::getBursts() const
+{
+    return m_bursts;
+}
+
+qint64 BerCounter::getResyncs() const
+{
+    return m_resyncs;
+}
+
+double BerCounter::getBer() const
+{
+    return m_bits ? (double)m_errors / m_bits : 0;
+}
+
+static double ChiSquareQuantile(double z, double dof)
+{
+    // Wilson-Hilferty approximation
+    double h = 2.0 / (9.0 * dof);
+    double c = 1.0 - h + z * std::sqrt(h);
+    return dof * c * c * c;
+}
+
+void BerCounter::getConfidence(double &low, double &high) const
+{
+    const double z = 1.959964;
+
+    low = 0;
+    high = 0;
+
+    if(0 == m_bits)
+    {
+        return;
+    }
+
+    if(0 == m_errors)
+    {
+        // Exact for zero events, -ln(0.025)
+        high = 3.688879 / m_bits;
+        return;
+    }
+
+    low = ChiSquareQuantile(-z, 2.0 * m_errors) / (2.0 * m_bits);
+    high = ChiSquareQuantile(z, 2.0 * m_errors + 2.0) / (2.0 * m_bits);
+}
+
+QString BerCounter::Report() const
+{
+    double low, high;
+    getConfidence(low, high);
+    return QString("BER %1 (95% CI %2 .. %3), %4 bits, %5 bit errors in %6 bursts, %7 frames with errors, %8 resyncs")
+           .arg(getBer(), 0, 'e', 2).arg(low, 0, 'e', 2).arg(high, 0, 'e', 2)
+           .arg(m_bits).arg(m_errors).arg(m_bursts).arg(m_errorFrames).arg(m_resyncs);
+}
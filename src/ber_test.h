@@ -0,0 +1,35 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef BER_TEST_H
+#define BER_TEST_H
+
+#include <QString>
+#include "prbs.h"
+
+// Bit error counting over echoed PRBS payloads
+class BerCounter
+{
+public:
+    void Reset();
+    void Compare(const uchar *expected, const uchar *received, qint64 n, const PrbsGenerator &prbs);
+    qint64 getBits() const;
+    qint64 getErrors() const;
+    qint64 getBursts() const;
+    qint64 getResyncs() const;
+    double getBer() const;
+    void getConfidence(double &low, double &high) const;   // 95 %, Poisson
+    QString Report() const;
+
+private:
+    qint64  m_bits = 0;
+    qint64  m_errors = 0;
+    qint64  m_bursts = 0;
+    qint64  m_resyncs = 0;
+    qint64  m_errorFrames = 0;
+};
+
+#endif // BER_TEST_H
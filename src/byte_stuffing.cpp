@@ -0,0 +1,216 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "byte_stuffing.h"
+#include "simd_ops.h"
+#include <cstring>
+
+const uchar COBS_DELIMITER      = 0x00;
+const qint64 COBS_MAX_RUN       = 254;  // [bytes] data bytes behind a 0xFF code
+const uchar SLIP_END            = 0xC0;
+const uchar SLIP_ESC            = 0xDB;
+const uchar SLIP_ESC_END        = 0xDC;
+const uchar SLIP_ESC_ESC        = 0xDD;
+
+qint64 ByteStuffing::MaxEncodedSize(Framing_t framing, qint64 n)
+{
+    switch(framing)
+    {
+        case Framing_t::COBS:
+            return n + n / COBS_MAX_RUN + 2;
+
+        case Framing_t::SLIP:
+            return 2 * n + 2;
+
+        default:
+            return n;
+    }
+}
+
+qint64 ByteStuffing::Encode(Framing_t framing, const uchar *src, qint64 n, uchar *dst)
+{
+    switch(framing)
+    {
+        case Framing_t::COBS:
+            return CobsEncode(src, n, dst);
+
+        case Framing_t::SLIP:
+            return SlipEncode(src, n, dst);
+
+        default:
+            memcpy(dst, src, static_cast<size_t>(n));
+            return n;
+    }
+}
+
+qint64 ByteStuffing::Decode(Framing_t framing, const uchar *src, qint64 n, uchar *dst)
+{
+    switch(framing)
+    {
+        case Framing_t::COBS:
+            return CobsDecode(src, n, dst);
+
+        case Framing_t::SLIP:
+            return SlipDecode(src, n, dst);
+
+        default:
+            memcpy(dst, src, static_cast<size_t>(n));
+            return n;
+    }
+}
+
+uchar ByteStuffing::Delimiter(Framing_t framing)
+{
+    return (Framing_t::SLIP == framing) ? SLIP_END : COBS_DELIMITER;
+}
+
+bool ByteStuffing::FromName(const QString &name, Framing_t &framing)
+{
+    const Framing_t all[] = { Framing_t::None, Framing_t::COBS, Framing_t::SLIP };
+
+    for(Framing_t f : all)
+    {
+        if(0 == name.compare(QLatin1String(Name(f)), Qt::CaseInsensitive))
+        {
+            framing = f;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char *ByteStuffing::Name(Framing_t framing)
+{
+    switch(framing)
+    {
+        case Framing_t::COBS:
+            return "cobs";
+
+        case Framing_t::SLIP:
+            return "slip";
+
+        default:
+            return "none";
+    }
+}
+
+qint64 ByteStuffing::CobsEncode(const uchar *src, qint64 n, uchar *dst)
+{
+    qint64 i = 0, o = 0;
+
+    for(;;)
+    {
+        qint64 run = qMin(COBS_MAX_RUN, n - i);
+        qint64 zero = simd::FindByte(src + i, run, COBS_DELIMITER);
+
+        if(0 <= zero)
+        {
+            // Group ends at a zero, the code byte stands in for it
+            dst[o++] = static_cast<uchar>(zero + 1);
+            memcpy(dst + o, src + i, static_cast<size_t>(zero));
+            o += zero;
+            i += zero + 1;
+            continue;
+        }
+
+        dst[o++] = static_cast<uchar>(run + 1);
+        memcpy(dst + o, src + i, static_cast<size_t>(run));
+        o += run;
+        i += run;
+
+        if(n <= i)
+        {
+            break;
+        }
+    }
+
+    dst[o++] = COBS_DELIMITER;
+    return o;
+}
+
+qint64 ByteStuffing::CobsDecode(const uchar *src, qint64 n, uchar *dst)
+{
+    qint64 i = 0, o = 0;
+
+    while(i < n)
+    {
+        qint64 code = src[i++];
+
+        if(0 == code || i + code - 1 > n)
+        {
+            return -1;
+        }
+
+        memcpy(dst + o, src + i, static_cast<size_t>(code - 1));
+        o += code - 1;
+        i += code - 1;
+
+        // Every group but a full one and the last is followed by a zero
+        if(COBS_MAX_RUN + 1 != code && i < n)
+        {
+            dst[o++] = COBS_DELIMITER;
+        }
+    }
+
+    return o;
+}
+
+qint64 ByteStuffing::SlipEncode(const uchar *src, qint64 n, uchar *dst)
+{
+    qint64 i = 0, o = 0;
+
+    // A leading END flushes any line noise collected by the receiver
+    dst[o++] = SLIP_END;
+
+    while(i < n)
+    {
+        qint64 hit = simd::FindEither(src + i, n - i, SLIP_END, SLIP_ESC);
+        qint64 plain = (hit < 0) ? n - i : hit;
+
+        memcpy(dst + o, src + i, static_cast<size_t>(plain));
+        o += plain;
+        i += plain;
+
+        if(i < n)
+        {
+            dst[o++] = SLIP_ESC;
+            dst[o++] = (SLIP_END == src[i]) ? SLIP_ESC_END : SLIP_ESC_ESC;
+            i++;
+        }
+    }
+
+    dst[o++] = SLIP_END;
+    return o;
+}
+
+qint64 ByteStuffing::SlipDecode(const uchar *src, qint64 n, uchar *dst)
+{
+    qint64 i = 0, o = 0;
+
+    while(i < n)
+    {
+        qint64 hit = simd::FindByte(src + i, n - i, SLIP_ESC);
+        qint64 plain = (hit < 0) ? n - i : hit;
+
+        memcpy(dst + o, src + i, static_cast<size_t>(plain));
+        o += plain;
+        i += plain;
+
+        if(i < n)
+        {
+            if(i + 1 >= n || (SLIP_ESC_END != src[i + 1] && SLIP_ESC_ESC != src[i + 1]))
+            {
+                return -1;
+            }
+
+            dst[o++] = (SLIP_ESC_END == src[i + 1]) ? SLIP_END : SLIP_ESC;
+            i += 2;
+        }
+    }
+
+    return o;
+}
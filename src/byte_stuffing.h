@@ -0,0 +1,45 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef BYTE_STUFFING_H
+#define BYTE_STUFFING_H
+
+#include <QtGlobal>
+#include <QString>
+
+enum class Framing_t
+{
+    None = 0,   // Frames are delimited by RX idle gaps
+    COBS,       // Consistent overhead byte stuffing, 0x00 terminated
+    SLIP        // RFC 1055, 0xC0 on both ends
+};
+
+/*
+    Byte stuffing keeps the delimiter out of the frame, so a receiver that lost
+    bytes drops one block and is back in sync at the next delimiter.
+    The delimiter and escape scans use the simd kernels, the copies are memcpy.
+*/
+class ByteStuffing
+{
+public:
+    // Encoded size of n bytes in the worst case, delimiters included
+    static qint64 MaxEncodedSize(Framing_t framing, qint64 n);
+    // Writes the delimiters too, returns the encoded size
+    static qint64 Encode(Framing_t framing, const uchar *src, qint64 n, uchar *dst);
+    // Decodes one block received between two delimiters, -1 if it is malformed
+    static qint64 Decode(Framing_t framing, const uchar *src, qint64 n, uchar *dst);
+    static uchar Delimiter(Framing_t framing);
+    static bool FromName(const QString &name, Framing_t &framing);
+    static const char *Name(Framing_t framing);
+
+private:
+    static qint64 CobsEncode(const uchar *src, qint64 n, uchar *dst);
+    static qint64 CobsDecode(const uchar *src, qint64 n, uchar *dst);
+    static qint64 SlipEncode(const uchar *src, qint64 n, uchar *dst);
+    static qint64 SlipDecode(const uchar *src, qint64 n, uchar *dst);
+};
+
+#endif // BYTE_STUFFING_H
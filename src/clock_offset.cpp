@@ -0,0 +1,91 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "clock_offset.h"
+
+void ClockOffset::Reserve(int count)
+{
+    m_samples.reserve(count);
+}
+
+void ClockOffset::Reset()
+{
+    m_samples.resize(0);
+    m_offset = 0;
+    m_minDelay = -1;
+}
+
+void ClockOffset::Add(qint64 t1, qint64 t3, qint64 t4)
+{
+    TimestampSample sample = { t1, t3, t4 };
+    qint64 delay = t4 - t1;
+
+    if(delay < 0)
+    {
+        return;
+    }
+
+    m_samples.append(sample);
+
+    if(m_minDelay < 0 || delay < m_minDelay)
+    {
+        m_minDelay = delay;
+        m_offset = t3 - t1 - delay / 2;
+    }
+}
+
+int ClockOffset::count() const
+{
+    return m_samples.size();
+}
+
+bool ClockOffset::isValid() const
+{
+    return 0 <= m_minDelay;
+}
+
+qint64 ClockOffset::getOffset() const
+{
+    return m_offset;
+}
+
+qint64 ClockOffset::getMinDelay() const
+{
+    return m_minDelay;
+}
+
+void ClockOffset::OneWay(LatencySamples &forward, LatencySamples &reverse) const
+{
+    forward.Clear();
+    reverse.Clear();
+    forward.Reserve(m_samples.size());
+    reverse.Reserve(m_samples.size());
+
+    for(const TimestampSample &s : m_samples)
+    {
+        qint64 t3 = s.t3 - m_offset;   // Device send time on the host clock
+        forward.Add(qMax<qint64>(0, t3 - s.t1));
+        reverse.Add(qMax<qint64>(0, s.t4 - t3));
+    }
+}
+
+QString ClockOffset::Report() const
+{
+    LatencySamples forward, reverse;
+
+    if(!isValid())
+    {
+        return QString("Clock offset : no timestamped echoes");
+    }
+
+    OneWay(forward, reverse);
+    return QString("Clock offset %1 us (best round trip %2 us, %3 samples)\n"
+                   "One way host->device p50 %4 us, p99 %5 us, max %6 us\n"
+                   "One way device->host p50 %7 us, p99 %8 us, max %9 us")
+           .arg(m_offset / 1000.0, 0, 'f', 1).arg(m_minDelay / 1000.0, 0, 'f', 1).arg(m_samples.size())
+           .arg(forward.Percentile(0.5), 0, 'f', 1).arg(forward.Percentile(0.99), 0, 'f', 1).arg(forward.Max(), 0, 'f', 1)
+           .arg(reverse.Percentile(0.5), 0, 'f', 1).arg(reverse.Percentile(0.99), 0, 'f', 1).arg(reverse.Max(), 0, 'f', 1);
+}
@@ -0,0 +1,50 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef CLOCK_OFFSET_H
+#define CLOCK_OFFSET_H
+
+#include <QString>
+#include <QVector>
+#include "run_stats.h"
+
+// One echoed frame carrying the device send timestamp of the extended header
+struct TimestampSample
+{
+    qint64  t1;     // [ns] host clock, request sent
+    qint64  t3;     // [ns] device clock, echo sent
+    qint64  t4;     // [ns] host clock, echo received
+};
+
+/*
+    NTP-style offset between the device and the host monotonic clocks.
+    The device turnaround is taken as zero, so t2 = t3 and per sample
+        offset = ((t2 - t1) + (t3 - t4)) / 2,   delay = t4 - t1
+    As in the NTP clock filter the sample with the smallest round trip is the one
+    least disturbed by queueing, its offset is used for the whole session.
+    The split assumes that minimum path is symmetric, variations on top of it are
+    attributed to the direction they happen in.
+*/
+class ClockOffset
+{
+public:
+    void Reserve(int count);
+    void Reset();
+    void Add(qint64 t1, qint64 t3, qint64 t4);
+    int count() const;
+    bool isValid() const;
+    qint64 getOffset() const;       // [ns] device clock minus host clock
+    qint64 getMinDelay() const;     // [ns] round trip of the best sample
+    void OneWay(LatencySamples &forward, LatencySamples &reverse) const;
+    QString Report() const;
+
+private:
+    QVector<TimestampSample>    m_samples;
+    qint64                      m_offset = 0;
+    qint64                      m_minDelay = -1;
+};
+
+#endif // CLOCK_OFFSET_H
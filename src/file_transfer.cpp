@@ -0,0 +1,215 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "file_transfer.h"
+#include "mono_clock.h"
+#include "protocol.h"
+#include "simd_ops.h"
+#include <QtEndian>
+
+const int TRANSFER_ACK_CRC      = 4;            // [bytes] ack payload that carries the device CRC
+
+FileTransfer::FileTransfer()
+{
+}
+
+FileTransfer::~FileTransfer()
+{
+    Close();
+}
+
+bool FileTransfer::Open(const QString &path, int frameSize, bool ack, QString &error)
+{
+    Close();
+
+    if(frameSize < 1 || PROTOCOL_MAX_PAYLOAD < frameSize)
+    {
+        error = QString("Transfer frame size must be 1..%1").arg(PROTOCOL_MAX_PAYLOAD);
+        return false;
+    }
+
+    m_file.setFileName(path);
+
+    if(!m_file.open(QIODevice::ReadOnly) || 0 == m_file.size())
+    {
+        error = "Unable to open transfer file " + path + " : " + (m_file.isOpen() ? QString("empty") : m_file.errorString());
+        m_file.close();
+        return false;
+    }
+
+    // Frames are wrapped straight from the mapped pages
+    m_map = m_file.map(0, m_file.size());
+
+    if(nullptr == m_map)
+    {
+        error = "Unable to map transfer file " + path + " : " + m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_frameSize = frameSize;
+    m_ack = ack;
+    m_fileCrc = Crc32(0, m_map, m_size);
+    Rewind();
+    return true;
+}
+
+void FileTransfer::Close()
+{
+    if(m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    if(m_file.isOpen())
+    {
+        m_file.close();
+    }
+}
+
+bool FileTransfer::isOpen() const
+{
+    return nullptr != m_map;
+}
+
+bool FileTransfer::isAck() const
+{
+    return m_ack;
+}
+
+qint64 FileTransfer::getSize() const
+{
+    return m_size;
+}
+
+int FileTransfer::getFrameSize() const
+{
+    return m_frameSize;
+}
+
+qint64 FileTransfer::Frames() const
+{
+    return (m_size + m_frameSize - 1) / m_frameSize;
+}
+
+const char *FileTransfer::FrameData(qint64 frame) const
+{
+    return (const char *)m_map + frame * m_frameSize;
+}
+
+int FileTransfer::FrameSize(qint64 frame) const
+{
+    return static_cast<int>(qMin<qint64>(m_frameSize, m_size - frame * m_frameSize));
+}
+
+void FileTransfer::Rewind()
+{
+    m_rxCrc = 0;
+    m_rxOffset = 0;
+    m_confirmed = 0;
+    m_txPayload = 0;
+    m_txWire = 0;
+    m_rxWire = 0;
+    m_frames = 0;
+    m_badFrames = 0;
+    m_startedAt = 0;
+    m_doneAt = 0;
+}
+
+void FileTransfer::Sent(int size, qint64 wireBytes)
+{
+    if(0 == m_startedAt)
+    {
+        m_startedAt = monotonicNs();
+    }
+
+    m_txPayload += size;
+    m_txWire += wireBytes;
+}
+
+void FileTransfer::Received(qint64 wireBytes)
+{
+    m_rxWire += wireBytes;
+}
+
+qint64 FileTransfer::Verify(const char *data, int size)
+{
+    int expected;
+
+    if(m_rxOffset >= m_size)
+    {
+        return 0;
+    }
+
+    expected = FrameSize(m_rxOffset / m_frameSize);
+
+    if(m_ack)
+    {
+        quint32 crc = Crc32(m_rxCrc, m_map + m_rxOffset, expected);
+        return (TRANSFER_ACK_CRC == size && crc != qFromBigEndian<quint32>((const uchar *)data)) ? 0 : -1;
+    }
+
+    m_rxCrc = Crc32(m_rxCrc, (const uchar *)data, size);
+    return simd::FirstMismatch(m_map + m_rxOffset, (const uchar *)data, qMin(size, expected));
+}
+
+void FileTransfer::Completed(bool ok)
+{
+    int size;
+
+    if(m_rxOffset >= m_size)
+    {
+        return;
+    }
+
+    size = FrameSize(m_rxOffset / m_frameSize);
+
+    if(m_ack)
+    {
+        // The ack CRC covers the file itself, a lost ack does not throw the next ones off
+        m_rxCrc = Crc32(m_rxCrc, m_map + m_rxOffset, size);
+    }
+
+    m_rxOffset += size;
+    m_frames++;
+
+    if(ok)
+    {
+        m_confirmed += size;
+    }
+    else
+    {
+        m_badFrames++;
+    }
+
+    m_doneAt = monotonicNs();
+}
+
+bool FileTransfer::isDone() const
+{
+    return m_size <= m_rxOffset;
+}
+
+QString FileTransfer::Report() const
+{
+    double seconds = (m_startedAt && m_doneAt) ? (m_doneAt - m_startedAt) / 1e9 : 0;
+    QString crc = QString("file CRC-32 %1").arg(m_fileCrc, 8, 16, QChar('0'));
+
+    if(!m_ack)
+    {
+        crc += QString(", echo CRC-32 %1 %2").arg(m_rxCrc, 8, 16, QChar('0'))
+               .arg(QLatin1String(isDone() && m_fileCrc == m_rxCrc ? "match" : "MISMATCH"));
+    }
+
+    return QString("File transfer : %1 / %2 bytes confirmed in %3 frames of %4 bytes, %5 bad, %6 ms\n"
+                   "Goodput %7 KB/s, %8 bytes sent for %9 file bytes (overhead %10 %), %11 bytes received, %12")
+           .arg(m_confirmed).arg(m_size).arg(m_frames).arg(m_frameSize).arg(m_badFrames).arg(seconds * 1000, 0, 'f', 1)
+           .arg(0 < seconds ? m_confirmed / 1024.0 / seconds : 0, 0, 'f', 1)
+           .arg(m_txWire).arg(m_txPayload).arg(m_txWire ? 100.0 * (m_txWire - m_txPayload) / m_txWire : 0, 0, 'f', 2)
+           .arg(m_rxWire).arg(crc);
+}
@@ -0,0 +1,62 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef FILE_TRANSFER_H
+#define FILE_TRANSFER_H
+
+#include <QFile>
+#include <QString>
+
+/*
+    Streams a memory-mapped file in frames of a fixed size, the last one may be shorter.
+    Echo mode checks every echo against the file and rolls a CRC-32 over the echoed bytes.
+    Ack mode takes any frame as the acknowledgement of the oldest one, a 4 byte ack is the
+    device's CRC-32 of the file so far (big endian) and is checked.
+*/
+class FileTransfer
+{
+public:
+    FileTransfer();
+    ~FileTransfer();
+    bool Open(const QString &path, int frameSize, bool ack, QString &error);
+    void Close();
+    bool isOpen() const;
+    bool isAck() const;
+    qint64 getSize() const;
+    int getFrameSize() const;
+    qint64 Frames() const;
+    const char *FrameData(qint64 frame) const;
+    int FrameSize(qint64 frame) const;
+
+    void Rewind();
+    void Sent(int size, qint64 wireBytes);
+    void Received(qint64 wireBytes);
+    qint64 Verify(const char *data, int size);      // Offset of the first bad byte, -1 if the frame is good
+    void Completed(bool ok);
+    bool isDone() const;
+    QString Report() const;
+
+
+private:
+    QFile           m_file;
+    uchar          *m_map = nullptr;
+    qint64          m_size = 0;
+    int             m_frameSize = 0;
+    bool            m_ack = false;
+    quint32         m_fileCrc = 0;
+    quint32         m_rxCrc = 0;
+    qint64          m_rxOffset = 0;         // [bytes] file offset of the oldest frame in flight
+    qint64          m_confirmed = 0;        // [bytes] echoed or acknowledged intact
+    qint64          m_txPayload = 0;        // [bytes] file data sent
+    qint64          m_txWire = 0;           // [bytes] frames sent
+    qint64          m_rxWire = 0;           // [bytes] frames received
+    qint64          m_frames = 0;
+    qint64          m_badFrames = 0;
+    qint64          m_startedAt = 0;        // [ns] first frame sent
+    qint64          m_doneAt = 0;           // [ns] last frame completed
+};
+
+#endif // FILE_TRANSFER_H
@@ -0,0 +1,9 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "frame_log.h"
+
+Q_LOGGING_CATEGORY(lcFrames, "qcommtest.frames", QtInfoMsg)
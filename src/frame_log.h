@@ -0,0 +1,15 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef FRAME_LOG_H
+#define FRAME_LOG_H
+
+#include <QLoggingCategory>
+
+// Per-frame trace lines, off unless --debug-frames, so the frame path formats no strings
+Q_DECLARE_LOGGING_CATEGORY(lcFrames)
+
+#endif // FRAME_LOG_H
@@ -0,0 +1,106 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "frame_pool.h"
+
+const int FRAME_POOL_GROWTH = 4; // [buffers] added when the pool runs dry
+
+FramePool::FramePool()
+{
+}
+
+FramePool::~FramePool()
+{
+    qDeleteAll(m_buffers);
+}
+
+void FramePool::Reset(int bufferSize, int bufferCount)
+{
+    qDeleteAll(m_buffers);
+    m_buffers.clear();
+    m_free.clear();
+    m_capacity.clear();
+    m_bufferSize = bufferSize;
+    m_buffers.reserve(bufferCount + FRAME_POOL_GROWTH);
+    m_free.reserve(bufferCount + FRAME_POOL_GROWTH);
+    m_capacity.reserve(bufferCount + FRAME_POOL_GROWTH);
+
+    for(int i = 0; i < bufferCount; i++)
+    {
+        m_free.append(Allocate());
+    }
+
+    ClearCounters();
+}
+
+QByteArray *FramePool::Allocate()
+{
+    QByteArray *buffer = new QByteArray();
+    // reserve() also keeps the capacity when the buffer is resized to zero
+    buffer->reserve(m_bufferSize);
+    m_buffers.append(buffer);
+    m_capacity.append(buffer->capacity());
+    m_allocations++;
+    return buffer;
+}
+
+QByteArray *FramePool::Acquire()
+{
+    QByteArray *buffer;
+    m_acquired++;
+
+    if(m_free.isEmpty())
+    {
+        if(m_free.capacity() <= m_buffers.size())
+        {
+            m_free.reserve(m_buffers.size() + FRAME_POOL_GROWTH);
+        }
+
+        buffer = Allocate();
+    }
+    else
+    {
+        buffer = m_free.takeLast();
+    }
+
+    buffer->resize(0);
+    return buffer;
+}
+
+void FramePool::Release(QByteArray *buffer)
+{
+    int index = m_buffers.indexOf(buffer);
+
+    if(0 > index)
+    {
+        return;
+    }
+
+    // A frame larger than the reservation made the buffer grow
+    if(buffer->capacity() != m_capacity.at(index))
+    {
+        m_capacity[index] = buffer->capacity();
+        m_allocations++;
+    }
+
+    m_free.append(buffer);
+}
+
+void FramePool::ClearCounters()
+{
+    m_allocations = 0;
+    m_acquired = 0;
+}
+
+qint64 FramePool::getAllocations() const
+{
+    return m_allocations;
+}
+
+qint64 FramePool::getAcquired() const
+{
+    return m_acquired;
+}
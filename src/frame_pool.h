@@ -0,0 +1,37 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <QByteArray>
+#include <QVector>
+
+// Fixed set of frame buffers, reserved once to the largest frame size and reused for every frame
+class FramePool
+{
+public:
+    FramePool();
+    ~FramePool();
+    void Reset(int bufferSize, int bufferCount);
+    QByteArray *Acquire();
+    void Release(QByteArray *);
+    void ClearCounters();
+    qint64 getAllocations() const;
+    qint64 getAcquired() const;
+
+private:
+    QByteArray *Allocate();
+
+    QVector<QByteArray *>   m_buffers;
+    QVector<QByteArray *>   m_free;
+    QVector<int>            m_capacity;
+    int                     m_bufferSize = 0;
+    qint64                  m_allocations = 0;     // Pool growth only, --alloc-check counts the heap
+    qint64                  m_acquired = 0;
+};
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,259 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "frame_trace.h"
+#include <QtEndian>
+#include <QDebug>
+
+const char TRACE_MAGIC[]        = "QFTR";
+const quint16 TRACE_VERSION     = 1;
+const quint16 TRACE_COLUMNS     = 8;
+const int TRACE_HEADER_SIZE     = 64;   // [bytes]
+const int TRACE_RECORD_SIZE     = 4 * 8 + 3 * 4 + 1; // [bytes] sum of all column widths
+
+enum
+{
+    COL_TX_ENQUEUE = 0,
+    COL_TX_COMPLETE,
+    COL_RX_FIRST,
+    COL_RX_COMPLETE,
+    COL_SESSION,
+    COL_INDEX,
+    COL_PAYLOAD_SIZE,
+    COL_STATUS
+};
+
+static void TraceColumns(uchar *base, quint32 capacity, uchar *columns[TRACE_COLUMNS])
+{
+    const int widths[TRACE_COLUMNS] = { 8, 8, 8, 8, 4, 4, 4, 1 };
+    uchar *p = base + TRACE_HEADER_SIZE;
+
+    for(int i = 0; i < TRACE_COLUMNS; i++)
+    {
+        columns[i] = p;
+        p += (qint64)widths[i] * capacity;
+    }
+}
+
+FrameTrace::FrameTrace()
+{
+}
+
+FrameTrace::~FrameTrace()
+{
+    Close();
+}
+
+bool FrameTrace::isOpen() const
+{
+    return nullptr != m_map;
+}
+
+quint32 FrameTrace::getCount() const
+{
+    return m_count;
+}
+
+quint32 FrameTrace::getDropped() const
+{
+    return m_dropped;
+}
+
+bool FrameTrace::Open(const QString &path, quint32 capacity)
+{
+    uchar *columns[TRACE_COLUMNS];
+    qint64 size = TRACE_HEADER_SIZE + (qint64)TRACE_RECORD_SIZE * capacity;
+
+    Close();
+    m_file.setFileName(path);
+
+    if(!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !m_file.resize(size))
+    {
+        qDebug() << "Unable to create frame trace" << path << ":" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, size);
+
+    if(nullptr == m_map)
+    {
+        qDebug() << "Unable to map frame trace" << path << ":" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    memset(m_map, 0, TRACE_HEADER_SIZE);
+    memcpy(m_map, TRACE_MAGIC, 4);
+    qToLittleEndian<quint16>(TRACE_VERSION, &m_map[4]);
+    qToLittleEndian<quint16>(TRACE_COLUMNS, &m_map[6]);
+    qToLittleEndian<quint32>(capacity, &m_map[8]);
+    m_capacity = capacity;
+    m_count = 0;
+    m_dropped = 0;
+    UpdateHeader();
+    TraceColumns(m_map, capacity, columns);
+    m_txEnqueue = columns[COL_TX_ENQUEUE];
+    m_txComplete = columns[COL_TX_COMPLETE];
+    m_rxFirst = columns[COL_RX_FIRST];
+    m_rxComplete = columns[COL_RX_COMPLETE];
+    m_session = columns[COL_SESSION];
+    m_index = columns[COL_INDEX];
+    m_payloadSize = columns[COL_PAYLOAD_SIZE];
+    m_status = columns[COL_STATUS];
+    return true;
+}
+
+void FrameTrace::Close()
+{
+    if(m_map)
+    {
+        UpdateHeader();
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    if(m_file.isOpen())
+    {
+        m_file.close();
+    }
+}
+
+void FrameTrace::UpdateHeader()
+{
+    qToLittleEndian<quint32>(m_count, &m_map[12]);
+    qToLittleEndian<quint32>(m_dropped, &m_map[16]);
+}
+
+void FrameTrace::Append(const FrameRecord &record)
+{
+    if(nullptr == m_map)
+    {
+        return;
+    }
+
+    if(m_count >= m_capacity)
+    {
+        m_dropped++;
+        UpdateHeader();
+        return;
+    }
+
+    // Stores go straight to the mapped pages, nothing is allocated here
+    qToLittleEndian<qint64>(record.txEnqueue, &m_txEnqueue[8 * m_count]);
+    qToLittleEndian<qint64>(record.txComplete, &m_txComplete[8 * m_count]);
+    qToLittleEndian<qint64>(record.rxFirst, &m_rxFirst[8 * m_count]);
+    qToLittleEndian<qint64>(record.rxComplete, &m_rxComplete[8 * m_count]);
+    qToLittleEndian<quint32>(record.session, &m_session[4 * m_count]);
+    qToLittleEndian<quint32>(record.index, &m_index[4 * m_count]);
+    qToLittleEndian<quint32>(record.payloadSize, &m_payloadSize[4 * m_count]);
+    m_status[m_count] = static_cast<uchar>(record.status);
+    m_count++;
+    UpdateHeader();
+}
+
+const char *FrameTrace::StatusName(Frame_Status_t status)
+{
+    switch(status)
+    {
+        case Frame_Status_t::OK:
+            return "ok";
+
+        case Frame_Status_t::CRC:
+            return "crc";
+
+        case Frame_Status_t::Length:
+            return "length";
+
+        case Frame_Status_t::Header:
+            return "header";
+
+        case Frame_Status_t::Timeout:
+            return "timeout";
+
+        case Frame_Status_t::Content:
+            return "content";
+    }
+
+    return "unknown";
+}
+
+bool FrameTrace::Export(const QString &path, bool json, QTextStream &out)
+{
+    QFile file(path);
+    uchar *map;
+    uchar *columns[TRACE_COLUMNS];
+    quint32 capacity, count;
+
+    if(!file.open(QIODevice::ReadOnly) || file.size() < TRACE_HEADER_SIZE)
+    {
+        qDebug() << "Unable to open frame trace" << path;
+        return false;
+    }
+
+    map = file.map(0, file.size());
+
+    if(nullptr == map || 0 != memcmp(map, TRACE_MAGIC, 4) ||
+            TRACE_VERSION != qFromLittleEndian<quint16>(&map[4]))
+    {
+        qDebug() << "Not a frame trace" << path;
+        return false;
+    }
+
+    capacity = qFromLittleEndian<quint32>(&map[8]);
+    count = qMin(capacity, qFromLittleEndian<quint32>(&map[12]));
+
+    if(file.size() < TRACE_HEADER_SIZE + (qint64)TRACE_RECORD_SIZE * capacity)
+    {
+        qDebug() << "Truncated frame trace" << path;
+        return false;
+    }
+
+    TraceColumns(map, capacity, columns);
+
+    if(json)
+    {
+        out << "[\n";
+    }
+    else
+    {
+        out << "session,index,payload_size,tx_enqueue_ns,tx_complete_ns,rx_first_ns,rx_complete_ns,status\n";
+    }
+
+    for(quint32 i = 0; i < count; i++)
+    {
+        quint32 session = qFromLittleEndian<quint32>(&columns[COL_SESSION][4 * i]);
+        quint32 index = qFromLittleEndian<quint32>(&columns[COL_INDEX][4 * i]);
+        quint32 payloadSize = qFromLittleEndian<quint32>(&columns[COL_PAYLOAD_SIZE][4 * i]);
+        qint64 txEnqueue = qFromLittleEndian<qint64>(&columns[COL_TX_ENQUEUE][8 * i]);
+        qint64 txComplete = qFromLittleEndian<qint64>(&columns[COL_TX_COMPLETE][8 * i]);
+        qint64 rxFirst = qFromLittleEndian<qint64>(&columns[COL_RX_FIRST][8 * i]);
+        qint64 rxComplete = qFromLittleEndian<qint64>(&columns[COL_RX_COMPLETE][8 * i]);
+        const char *status = StatusName(static_cast<Frame_Status_t>(columns[COL_STATUS][i]));
+
+        if(json)
+        {
+            out << QString("  {\"session\":%1,\"index\":%2,\"payload_size\":%3,\"tx_enqueue_ns\":%4,"
+                           "\"tx_complete_ns\":%5,\"rx_first_ns\":%6,\"rx_complete_ns\":%7,\"status\":\"%8\"}%9\n")
+                   .arg(session).arg(index).arg(payloadSize).arg(txEnqueue).arg(txComplete)
+                   .arg(rxFirst).arg(rxComplete).arg(QLatin1String(status)).arg(QLatin1String(i + 1 < count ? "," : ""));
+        }
+        else
+        {
+            out << QString("%1,%2,%3,%4,%5,%6,%7,%8\n")
+                   .arg(session).arg(index).arg(payloadSize).arg(txEnqueue).arg(txComplete)
+                   .arg(rxFirst).arg(rxComplete).arg(QLatin1String(status));
+        }
+    }
+
+    if(json)
+    {
+        out << "]\n";
+    }
+
+    out.flush();
+    return true;
+}
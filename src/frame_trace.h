@@ -0,0 +1,75 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+
+enum class Frame_Status_t : quint8
+{
+    OK = 0,
+    CRC,
+    Length,
+    Header,
+    Timeout,
+    Content
+};
+
+struct FrameRecord
+{
+    quint32         session;
+    quint32         index;
+    quint32         payloadSize;
+    qint64          txEnqueue;      // [ns] monotonic
+    qint64          txComplete;     // [ns] monotonic
+    qint64          rxFirst;        // [ns] monotonic
+    qint64          rxComplete;     // [ns] monotonic
+    Frame_Status_t  status;
+};
+
+/*
+    Per-frame trace stored as a memory-mapped, column-oriented file (little endian)
+    Header  : "QFTR" | version16 | columns16 | capacity32 | count32 | dropped32 | reserved
+    Columns : txEnqueue64[capacity] | txComplete64[] | rxFirst64[] | rxComplete64[] |
+              session32[] | index32[] | payloadSize32[] | status8[]
+*/
+class FrameTrace
+{
+public:
+    FrameTrace();
+    ~FrameTrace();
+    bool Open(const QString &path, quint32 capacity);
+    void Close();
+    bool isOpen() const;
+    void Append(const FrameRecord &record);
+    quint32 getCount() const;
+    quint32 getDropped() const;
+
+    static bool Export(const QString &path, bool json, QTextStream &out);
+    static const char *StatusName(Frame_Status_t status);
+
+private:
+    void UpdateHeader();
+
+    QFile           m_file;
+    uchar          *m_map = nullptr;
+    quint32         m_capacity = 0;
+    quint32         m_count = 0;
+    quint32         m_dropped = 0;
+    uchar          *m_txEnqueue = nullptr;
+    uchar          *m_txComplete = nullptr;
+    uchar          *m_rxFirst = nullptr;
+    uchar          *m_rxComplete = nullptr;
+    uchar          *m_session = nullptr;
+    uchar          *m_index = nullptr;
+    uchar          *m_payloadSize = nullptr;
+    uchar          *m_status = nullptr;
+};
+
+#endif // FRAME_TRACE_H
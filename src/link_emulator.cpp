@@ -0,0 +1,253 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "link_emulator.h"
+#include "mono_clock.h"
+#include <QStringList>
+#include <cmath>
+
+bool LinkProfile::Parse(const QString &spec, LinkProfile &profile, QString &error)
+{
+    profile = LinkProfile();
+
+    // key=value list, e.g. bw=1200,delay=40,jitter=10,loss=0.01,flip=1e-6,reorder=0.01,seed=7
+    for(const QString &item : spec.split(',', Qt::SkipEmptyParts))
+    {
+        QStringList pair = item.split('=');
+        QString key = pair.value(0).trimmed();
+        QString value = pair.value(1).trimmed();
+        bool ok = (2 == pair.size());
+
+        if(ok && "bw" == key)
+        {
+            profile.bandwidth = value.toLongLong(&ok);
+        }
+        else if(ok && "burst" == key)
+        {
+            profile.burst = value.toLongLong(&ok);
+        }
+        else if(ok && "delay" == key)
+        {
+            profile.delay = value.toInt(&ok);
+        }
+        else if(ok && "jitter" == key)
+        {
+            profile.jitter = value.toInt(&ok);
+        }
+        else if(ok && "loss" == key)
+        {
+            profile.loss = value.toDouble(&ok);
+        }
+        else if(ok && "flip" == key)
+        {
+            profile.bitFlip = value.toDouble(&ok);
+        }
+        else if(ok && "reorder" == key)
+        {
+            profile.reorder = value.toDouble(&ok);
+        }
+        else if(ok && "seed" == key)
+        {
+            profile.seed = value.toUInt(&ok);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if(!ok)
+        {
+            error = "Invalid link parameter " + item;
+            return false;
+        }
+    }
+
+    if(profile.bandwidth < 0 || profile.delay < 0 || profile.jitter < 0 ||
+            profile.loss < 0 || 1 < profile.loss || profile.bitFlip < 0 || 1 <= profile.bitFlip ||
+            profile.reorder < 0 || 1 < profile.reorder)
+    {
+        error = "Link parameter out of range";
+        return false;
+    }
+
+    return true;
+}
+
+QString LinkProfile::toString() const
+{
+    return QString("bw=%1 B/s, delay=%2+%3 ms, loss=%4, flip=%5, reorder=%6, seed=%7")
+           .arg(bandwidth).arg(delay).arg(jitter).arg(loss).arg(bitFlip).arg(reorder).arg(seed);
+}
+
+//---------------------------------------------------------------
+
+LinkEmulator::LinkEmulator(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<Link_Direction_t>();
+    m_timer_release.setSingleShot(true);
+    m_timer_release.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer_release, &QTimer::timeout, this, &LinkEmulator::onTimeoutRelease);
+}
+
+void LinkEmulator::Configure(const LinkProfile &profile)
+{
+    m_profile = profile;
+    m_rng.seed(profile.seed);
+    m_active = true;
+    Clear();
+}
+
+bool LinkEmulator::isActive() const
+{
+    return m_active;
+}
+
+void LinkEmulator::Clear()
+{
+    m_timer_release.stop();
+
+    for(Lane &lane : m_lanes)
+    {
+        lane = Lane();
+        lane.tokens = m_profile.burst;
+    }
+
+    m_packets = 0;
+    m_lost = 0;
+    m_reordered = 0;
+    m_flippedBits = 0;
+}
+
+double LinkEmulator::Uniform()
+{
+    // Built from the raw generator output so a seed gives the same run on every platform
+    return (m_rng() + 0.5) / 4294967296.0;
+}
+
+qint64 LinkEmulator::FlipBits(QByteArray &data)
+{
+    qint64 bits = (qint64)data.size() * 8;
+    qint64 flipped = 0;
+    double logKeep;
+
+    if(0 == m_profile.bitFlip)
+    {
+        return 0;
+    }
+
+    // Geometric gaps between flipped bits, one draw per error instead of one per bit
+    logKeep = std::log(1.0 - m_profile.bitFlip);
+
+    for(qint64 bit = (qint64)(std::log(Uniform()) / logKeep); bit < bits; bit += 1 + (qint64)(std::log(Uniform()) / logKeep))
+    {
+        data[(int)(bit / 8)] = data[(int)(bit / 8)] ^ (char)(1 << (bit % 8));
+        flipped++;
+    }
+
+    return flipped;
+}
+
+void LinkEmulator::Push(Link_Direction_t direction, const char *data, qint64 size)
+{
+    Lane &lane = m_lanes[static_cast<int>(direction)];
+    qint64 now = monotonicNs();
+    qint64 departure = qMax(now, lane.departedAt);
+    Packet packet;
+
+    m_packets++;
+
+    if(Uniform() < m_profile.loss)
+    {
+        m_lost++;
+        return;
+    }
+
+    if(m_profile.bandwidth)
+    {
+        double depth = qMax<double>(m_profile.burst, size);
+        // Refill up to the bucket depth, then wait for the tokens that are missing
+        lane.tokens = qMin(depth, lane.tokens + (departure - lane.refilledAt) * 1e-9 * m_profile.bandwidth);
+        lane.refilledAt = departure;
+
+        if(lane.tokens < size)
+        {
+            departure += (qint64)((size - lane.tokens) * 1e9 / m_profile.bandwidth);
+            lane.tokens = size;
+            lane.refilledAt = departure;
+        }
+
+        lane.tokens -= size;
+    }
+
+    lane.departedAt = departure;
+    packet.data = QByteArray(data, size);
+    m_flippedBits += FlipBits(packet.data);
+    packet.releaseAt = departure + m_profile.delay * 1000000LL + (qint64)(Uniform() * m_profile.jitter * 1000000LL);
+
+    if(0 < m_profile.reorder && Uniform() < m_profile.reorder)
+    {
+        // Held back long enough for the packets behind it to overtake
+        packet.releaseAt += (m_profile.delay + m_profile.jitter + 1) * 1000000LL;
+        m_reordered++;
+    }
+    else
+    {
+        packet.releaseAt = qMax(packet.releaseAt, lane.arrivedAt);
+        lane.arrivedAt = packet.releaseAt;
+    }
+
+    int i = lane.queue.size();
+
+    while(0 < i && lane.queue[i - 1].releaseAt > packet.releaseAt)
+    {
+        i--;
+    }
+
+    lane.queue.insert(i, packet);
+    Schedule();
+}
+
+void LinkEmulator::Schedule()
+{
+    qint64 next = -1;
+
+    for(const Lane &lane : m_lanes)
+    {
+        if(!lane.queue.isEmpty() && (next < 0 || lane.queue.first().releaseAt < next))
+        {
+            next = lane.queue.first().releaseAt;
+        }
+    }
+
+    if(0 <= next)
+    {
+        m_timer_release.start((int)qMax<qint64>(0, (next - monotonicNs() + 999999) / 1000000));
+    }
+}
+
+void LinkEmulator::onTimeoutRelease()
+{
+    qint64 now = monotonicNs();
+
+    for(int d = 0; d < 2; d++)
+    {
+        Lane &lane = m_lanes[d];
+
+        while(!lane.queue.isEmpty() && lane.queue.first().releaseAt <= now)
+        {
+            Packet packet = lane.queue.takeFirst();
+            emit delivered(static_cast<Link_Direction_t>(d), packet.data);
+        }
+    }
+
+    Schedule();
+}
+
+QString LinkEmulator::Statistics() const
+{
+    return QString("Link : %1 packets, %2 lost, %3 reordered, %4 bits flipped")
+           .arg(m_packets).arg(m_lost).arg(m_reordered).arg(m_flippedBits);
+}
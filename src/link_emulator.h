@@ -0,0 +1,91 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef LINK_EMULATOR_H
+#define LINK_EMULATOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QTimer>
+#include <random>
+
+enum class Link_Direction_t
+{
+    TX = 0,     // Engine to device
+    RX = 1      // Device to engine
+};
+
+struct LinkProfile
+{
+    qint64  bandwidth = 0;      // [bytes/s] token bucket rate, 0 = unlimited
+    qint64  burst = 0;          // [bytes] token bucket depth, 0 = one packet
+    int     delay = 0;          // [ms] fixed one-way delay
+    int     jitter = 0;         // [ms] uniform random delay added on top
+    double  loss = 0;           // Probability a packet is dropped
+    double  bitFlip = 0;        // Probability any single bit is inverted
+    double  reorder = 0;        // Probability a packet is held back and overtaken
+    quint32 seed = 1;
+
+    static bool Parse(const QString &spec, LinkProfile &profile, QString &error);
+    QString toString() const;
+};
+
+/*
+    Shapes traffic between the engine and a transport in user space, so no root or netem is needed.
+    Every pushed packet is delivered later (or never) through the delivered signal.
+*/
+class LinkEmulator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LinkEmulator(QObject *parent = nullptr);
+    void Configure(const LinkProfile &profile);
+    bool isActive() const;
+    void Push(Link_Direction_t direction, const char *data, qint64 size);
+    void Clear();
+    QString Statistics() const;
+
+signals:
+    void delivered(Link_Direction_t direction, const QByteArray &data);
+
+private slots:
+    void onTimeoutRelease();
+
+private:
+    struct Packet
+    {
+        qint64      releaseAt;  // [ns] monotonic
+        QByteArray  data;
+    };
+
+    struct Lane
+    {
+        QList<Packet>   queue;          // Sorted by releaseAt
+        double          tokens = 0;     // [bytes]
+        qint64          refilledAt = 0; // [ns]
+        qint64          departedAt = 0; // [ns] last departure, the link is FIFO
+        qint64          arrivedAt = 0;  // [ns] last in-order arrival
+    };
+
+    double Uniform();
+    qint64 FlipBits(QByteArray &data);
+    void Schedule();
+
+    bool            m_active = false;
+    LinkProfile     m_profile;
+    std::mt19937    m_rng;
+    Lane            m_lanes[2];
+    QTimer          m_timer_release;
+    qint64          m_packets = 0;
+    qint64          m_lost = 0;
+    qint64          m_reordered = 0;
+    qint64          m_flippedBits = 0;
+};
+
+Q_DECLARE_METATYPE(Link_Direction_t)
+
+#endif // LINK_EMULATOR_H
@@ -0,0 +1,139 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "live_chart.h"
+#include "mono_clock.h"
+#include <QPainter>
+#include <QPainterPath>
+
+const int CHART_REFRESH         = 33;   // [ms] about 30 frames per second
+const int CHART_POINTS          = 60;   // Buckets shown at any resolution
+
+LiveChart::LiveChart(QWidget *parent) : QWidget(parent)
+{
+    connect(&m_timer_refresh, &QTimer::timeout, this, QOverload<>::of(&QWidget::update));
+    m_throughput.reserve(CHART_POINTS);
+    m_p50.reserve(CHART_POINTS);
+    m_p99.reserve(CHART_POINTS);
+    m_errors.reserve(CHART_POINTS);
+    setToolTip("Click to change the resolution");
+}
+
+void LiveChart::setSeries(const TimeSeriesRing *series)
+{
+    m_series = series;
+    update();
+}
+
+void LiveChart::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    m_timer_refresh.start(CHART_REFRESH);
+}
+
+void LiveChart::hideEvent(QHideEvent *event)
+{
+    // Nothing is sampled while the tab is not visible
+    m_timer_refresh.stop();
+    QWidget::hideEvent(event);
+}
+
+void LiveChart::mousePressEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    m_level = static_cast<Series_Level_t>((static_cast<int>(m_level) + 1) % SERIES_LEVELS);
+    update();
+}
+
+void LiveChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    qint64 now = monotonicNs();
+    int stripHeight = height() / 3;
+
+    m_throughput.resize(0);
+    m_p50.resize(0);
+    m_p99.resize(0);
+    m_errors.resize(0);
+
+    if(m_series)
+    {
+        // Oldest first, the newest bucket is on the right edge
+        for(int age = CHART_POINTS - 1; 0 <= age; age--)
+        {
+            SeriesPoint point = m_series->getPoint(m_level, now, age);
+            m_throughput.append(point.throughput);
+            m_p50.append(point.p50);
+            m_p99.append(point.p99);
+            m_errors.append(point.errorRate);
+        }
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    DrawStrip(painter, QRect(0, 0, width(), stripHeight),
+              QString("KB/s per %1").arg(QLatin1String(TimeSeriesRing::LevelName(m_level))),
+              m_throughput, QColor(0x4c, 0xaf, 0x50), QVector<double>(), QColor());
+    DrawStrip(painter, QRect(0, stripHeight, width(), stripHeight), "RTT p50 / p99 us",
+              m_p50, QColor(0x21, 0x96, 0xf3), m_p99, QColor(0xff, 0x98, 0x00));
+    DrawStrip(painter, QRect(0, 2 * stripHeight, width(), stripHeight), "Errors %",
+              m_errors, QColor(0xf4, 0x43, 0x36), QVector<double>(), QColor());
+}
+
+void LiveChart::DrawStrip(QPainter &painter, const QRect &area, const QString &title,
+                          const QVector<double> &a, const QColor &colorA,
+                          const QVector<double> &b, const QColor &colorB)
+{
+    double top = 0;
+    QRect plot = area.adjusted(2, 12, -2, -2);
+
+    for(double v : a)
+    {
+        top = qMax(top, v);
+    }
+
+    for(double v : b)
+    {
+        top = qMax(top, v);
+    }
+
+    painter.setPen(QColor(0x50, 0x50, 0x50));
+    painter.drawRect(plot);
+    painter.setPen(palette().color(QPalette::WindowText));
+    painter.drawText(area.adjusted(2, 0, -2, 0), Qt::AlignLeft | Qt::AlignTop, title);
+    painter.drawText(area.adjusted(2, 0, -2, 0), Qt::AlignRight | Qt::AlignTop, QString::number(top, 'f', 1));
+
+    if(0 == top)
+    {
+        return;
+    }
+
+    const QVector<double> *series[2] = { &a, &b };
+    const QColor *colors[2] = { &colorA, &colorB };
+
+    for(int s = 0; s < 2; s++)
+    {
+        QPainterPath path;
+
+        for(int i = 0; i < series[s]->size(); i++)
+        {
+            QPointF p(plot.left() + (double)plot.width() * i / qMax(1, CHART_POINTS - 1),
+                      plot.bottom() - plot.height() * series[s]->at(i) / top);
+
+            if(0 == i)
+            {
+                path.moveTo(p);
+            }
+            else
+            {
+                path.lineTo(p);
+            }
+        }
+
+        painter.setPen(QPen(*colors[s], 1.5));
+        painter.drawPath(path);
+    }
+}
@@ -0,0 +1,43 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef LIVE_CHART_H
+#define LIVE_CHART_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QVector>
+#include "time_series.h"
+
+// Throughput, round trip and error rate over time, click to change the resolution
+class LiveChart : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit LiveChart(QWidget *parent = nullptr);
+    void setSeries(const TimeSeriesRing *series);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
+private:
+    void DrawStrip(QPainter &painter, const QRect &area, const QString &title,
+                   const QVector<double> &a, const QColor &colorA,
+                   const QVector<double> &b, const QColor &colorB);
+
+    const TimeSeriesRing   *m_series = nullptr;
+    Series_Level_t          m_level = Series_Level_t::Second;
+    QTimer                  m_timer_refresh;
+    QVector<double>         m_throughput;   // Reused between frames
+    QVector<double>         m_p50;
+    QVector<double>         m_p99;
+    QVector<double>         m_errors;
+};
+
+#endif // LIVE_CHART_H
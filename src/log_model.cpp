@@ -0,0 +1,162 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "log_model.h"
+#include <QBrush>
+#include <QColor>
+
+const int LOG_FLUSH_INTERVAL    = 16;   // [ms] one UI frame
+
+LogModel::LogModel(int capacity, QObject *parent) : QAbstractListModel(parent)
+{
+    m_entries.resize(qMax(1, capacity));
+    m_pending.reserve(m_entries.size());
+    m_timer_flush.setSingleShot(true);
+    connect(&m_timer_flush, &QTimer::timeout, this, &LogModel::Flush);
+}
+
+void LogModel::Append(Log_Level_t level, const QString &text)
+{
+    LogEntry entry = { level, text };
+
+    if(m_pending.size() == m_entries.size())
+    {
+        // A whole ring worth of lines within one frame, hand them over now
+        Flush();
+    }
+
+    m_pending.append(entry);
+
+    if(!m_timer_flush.isActive())
+    {
+        m_timer_flush.start(LOG_FLUSH_INTERVAL);
+    }
+}
+
+void LogModel::Flush()
+{
+    int capacity = m_entries.size();
+    int incoming = m_pending.size();
+    int overflow = m_count + incoming - capacity;
+
+    m_timer_flush.stop();
+
+    if(0 == incoming)
+    {
+        return;
+    }
+
+    if(0 < overflow)
+    {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_first = (m_first + overflow) % capacity;
+        m_count -= overflow;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_count, m_count + incoming - 1);
+
+    for(int i = 0; i < incoming; i++)
+    {
+        m_entries[(m_first + m_count + i) % capacity] = m_pending[i];
+    }
+
+    m_count += incoming;
+    endInsertRows();
+    // Keeps the reserved storage
+    m_pending.resize(0);
+}
+
+const LogEntry &LogModel::entry(int row) const
+{
+    return m_entries[(m_first + row) % m_entries.size()];
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_count)
+    {
+        return QVariant();
+    }
+
+    const LogEntry &e = entry(index.row());
+
+    switch(role)
+    {
+        case Qt::DisplayRole:
+            return e.text;
+
+        case Qt::ForegroundRole:
+            switch(e.level)
+            {
+                case Log_Level_t::Debug:
+                    return QBrush(QColor(0x80, 0x80, 0x80));
+
+                case Log_Level_t::Warning:
+                    return QBrush(QColor(0xE0, 0xA0, 0x30));
+
+                case Log_Level_t::Error:
+                    return QBrush(QColor(0xE0, 0x40, 0x40));
+
+                default:
+                    return QVariant();
+            }
+
+        default:
+            return QVariant();
+    }
+}
+
+const char *LogModel::LevelName(Log_Level_t level)
+{
+    switch(level)
+    {
+        case Log_Level_t::Debug:
+            return "Debug";
+
+        case Log_Level_t::Info:
+            return "Info";
+
+        case Log_Level_t::Warning:
+            return "Warning";
+
+        case Log_Level_t::Error:
+            return "Error";
+    }
+
+    return "";
+}
+
+//---------------------------------------------------------------
+
+LogFilter::LogFilter(LogModel *model, QObject *parent) : QSortFilterProxyModel(parent), m_model(model)
+{
+    setSourceModel(model);
+}
+
+void LogFilter::setMinimumLevel(Log_Level_t level)
+{
+    m_level = level;
+    invalidateFilter();
+}
+
+void LogFilter::setSearch(const QString &text)
+{
+    m_search = text;
+    invalidateFilter();
+}
+
+bool LogFilter::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    Q_UNUSED(sourceParent);
+    const LogEntry &e = m_model->entry(sourceRow);
+    return e.level >= m_level && (m_search.isEmpty() || e.text.contains(m_search, Qt::CaseInsensitive));
+}
@@ -0,0 +1,74 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef LOG_MODEL_H
+#define LOG_MODEL_H
+
+#include <QAbstractListModel>
+#include <QSortFilterProxyModel>
+#include <QTimer>
+#include <QVector>
+
+enum class Log_Level_t : quint8
+{
+    Debug = 0,      // Per frame chatter
+    Info,
+    Warning,
+    Error
+};
+
+struct LogEntry
+{
+    Log_Level_t level;
+    QString     text;
+};
+
+/*
+    Log lines in a fixed-capacity ring. Lines are queued and handed to the views
+    once per UI frame, one insert (and at most one removal of the oldest rows) per batch.
+*/
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit LogModel(int capacity, QObject *parent = nullptr);
+    void Append(Log_Level_t level, const QString &text);
+    const LogEntry &entry(int row) const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    static const char *LevelName(Log_Level_t level);
+
+private slots:
+    void Flush();
+
+private:
+    QVector<LogEntry>   m_entries;      // Ring storage, sized once
+    QVector<LogEntry>   m_pending;      // Waiting for the next flush, never above the capacity
+    int                 m_first = 0;    // Storage slot of row 0
+    int                 m_count = 0;
+    QTimer              m_timer_flush;
+};
+
+// Level and search filter in front of the model
+class LogFilter : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit LogFilter(LogModel *model, QObject *parent = nullptr);
+    void setMinimumLevel(Log_Level_t level);
+    void setSearch(const QString &text);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    LogModel       *m_model;
+    Log_Level_t     m_level = Log_Level_t::Debug;
+    QString         m_search;
+};
+
+#endif // LOG_MODEL_H
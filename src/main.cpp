@@ -9,6 +9,12 @@
 #include <QFile>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
+#include <QLoggingCategory>
+#include "frame_trace.h"
+#include "scoped_trace.h"
+#include "mono_clock.h"
+#include "serial_bench.h"
+#include "alloc_counter.h"
 
 void setStylesheet()
 {
@@ -28,6 +34,7 @@ void setStylesheet()
 
 int main(int argc, char *argv[])
 {
+    qint64 startedAt = monotonicNs();
     QApplication a(argc, argv);
     QCoreApplication::setApplicationName("qCommTest");
     QCoreApplication::setApplicationVersion("1.0");
@@ -42,16 +49,492 @@ int main(int argc, char *argv[])
                                      QCoreApplication::translate("main", "port"));
     parser.addOption(tcpPortOption);
 
+    QCommandLineOption captureOption(QStringList() << "c" << "capture",
+                                     QCoreApplication::translate("main", "Record all RX/TX traffic to <file>."),
+                                     QCoreApplication::translate("main", "file"));
+    parser.addOption(captureOption);
+
+    QCommandLineOption replayOption(QStringList() << "r" << "replay",
+                                    QCoreApplication::translate("main", "Replay a capture <file> through the test engine and exit."),
+                                    QCoreApplication::translate("main", "file"));
+    parser.addOption(replayOption);
+
+    QCommandLineOption replaySpeedOption(QStringList() << "replay-speed",
+                                         QCoreApplication::translate("main", "Replay speed, original or max (default original)."),
+                                         QCoreApplication::translate("main", "speed"),
+                                         "original");
+    parser.addOption(replaySpeedOption);
+
+    QCommandLineOption frameTraceOption(QStringList() << "t" << "frame-trace",
+                                        QCoreApplication::translate("main", "Record per-frame metrics to a memory-mapped <file>."),
+                                        QCoreApplication::translate("main", "file"));
+    parser.addOption(frameTraceOption);
+
+    QCommandLineOption frameTraceCapacityOption(QStringList() << "frame-trace-capacity",
+                                                QCoreApplication::translate("main", "Maximum number of frames in the trace (default 1000000)."),
+                                                QCoreApplication::translate("main", "frames"),
+                                                "1000000");
+    parser.addOption(frameTraceCapacityOption);
+
+    QCommandLineOption exportTraceOption(QStringList() << "export-trace",
+                                         QCoreApplication::translate("main", "Print a frame trace <file> to stdout and exit."),
+                                         QCoreApplication::translate("main", "file"));
+    parser.addOption(exportTraceOption);
+
+    QCommandLineOption exportFormatOption(QStringList() << "export-format",
+                                          QCoreApplication::translate("main", "Export format, csv or json (default csv)."),
+                                          QCoreApplication::translate("main", "format"),
+                                          "csv");
+    parser.addOption(exportFormatOption);
+
+    QCommandLineOption rxBufferOption(QStringList() << "rx-buffer",
+                                      QCoreApplication::translate("main", "Receive ring buffer capacity in bytes (default 65536)."),
+                                      QCoreApplication::translate("main", "bytes"));
+    parser.addOption(rxBufferOption);
+
+    QCommandLineOption metricsPortOption(QStringList() << "metrics-port",
+                                         QCoreApplication::translate("main", "Serve OpenMetrics counters on http://127.0.0.1:<port>/metrics."),
+                                         QCoreApplication::translate("main", "port"));
+    parser.addOption(metricsPortOption);
+
+    QCommandLineOption socketProfileOption(QStringList() << "socket-profile",
+                                           QCoreApplication::translate("main", "TCP socket options, default, low-latency or bulk (default default)."),
+                                           QCoreApplication::translate("main", "profile"));
+    parser.addOption(socketProfileOption);
+
+    QCommandLineOption compareProfilesOption(QStringList() << "compare-profiles",
+                                             QCoreApplication::translate("main", "Run one session under each profile of the comma separated <list>, print a comparison and exit."),
+                                             QCoreApplication::translate("main", "list"));
+    parser.addOption(compareProfilesOption);
+
+    QCommandLineOption benchmarkOption(QStringList() << "benchmark",
+                                       QCoreApplication::translate("main", "Measure <runs> test sessions, print mean, stddev and 95% confidence intervals and exit."),
+                                       QCoreApplication::translate("main", "runs"));
+    parser.addOption(benchmarkOption);
+
+    QCommandLineOption warmupOption(QStringList() << "warmup",
+                                    QCoreApplication::translate("main", "Sessions discarded before a benchmark (default 1)."),
+                                    QCoreApplication::translate("main", "runs"),
+                                    "1");
+    parser.addOption(warmupOption);
+
+    QCommandLineOption baselineOption(QStringList() << "baseline",
+                                      QCoreApplication::translate("main", "Compare the benchmark with a baseline <file>, exit code 1 on a significant regression, 2 if the baseline cannot be used."),
+                                      QCoreApplication::translate("main", "file"));
+    parser.addOption(baselineOption);
+
+    QCommandLineOption saveBaselineOption(QStringList() << "save-baseline",
+                                          QCoreApplication::translate("main", "Save the benchmark results as a baseline <file>."),
+                                          QCoreApplication::translate("main", "file"));
+    parser.addOption(saveBaselineOption);
+
+    QCommandLineOption linkOption(QStringList() << "link",
+                                  QCoreApplication::translate("main", "Emulate a link between the engine and the transport, e.g. bw=1200,delay=40,jitter=10,loss=0.01,flip=1e-6,reorder=0.01,seed=7."),
+                                  QCoreApplication::translate("main", "spec"));
+    parser.addOption(linkOption);
+
+    QCommandLineOption payloadOption(QStringList() << "payload",
+                                     QCoreApplication::translate("main", "Payload pattern: ramp, zeros, ones, fixed:<byte>, random[:seed], incompressible, prbs7..prbs31 or file:<path> (default ramp)."),
+                                     QCoreApplication::translate("main", "pattern"));
+    parser.addOption(payloadOption);
+
+    QCommandLineOption verifyOption(QStringList() << "verify",
+                                    QCoreApplication::translate("main", "Check that every echo carries the payload that was sent."));
+    parser.addOption(verifyOption);
+
+    QCommandLineOption extHeaderOption(QStringList() << "ext-header",
+                                       QCoreApplication::translate("main", "Accept the extended header (sequence number and send timestamp) when the device offers it."));
+    parser.addOption(extHeaderOption);
+
+    QCommandLineOption framingOption(QStringList() << "framing",
+                                     QCoreApplication::translate("main", "Delimit frames with cobs or slip byte stuffing instead of RX idle gaps."),
+                                     QCoreApplication::translate("main", "mode"));
+    parser.addOption(framingOption);
+
+    QCommandLineOption berOption(QStringList() << "ber",
+                                 QCoreApplication::translate("main", "Bit error rate test with prbs7, prbs15, prbs23 or prbs31 payloads."),
+                                 QCoreApplication::translate("main", "pattern"));
+    parser.addOption(berOption);
+
+    QCommandLineOption soakOption(QStringList() << "soak",
+                                  QCoreApplication::translate("main", "Repeat the size sweep until stopped and log a snapshot every <seconds>."),
+                                  QCoreApplication::translate("main", "seconds"));
+    parser.addOption(soakOption);
+
+    QCommandLineOption planOption(QStringList() << "plan",
+                                  QCoreApplication::translate("main", "Run the phases of a JSON test plan <file> instead of the built-in 1..400 byte sweep."),
+                                  QCoreApplication::translate("main", "file"));
+    parser.addOption(planOption);
+
+    QCommandLineOption planResultOption(QStringList() << "plan-result",
+                                        QCoreApplication::translate("main", "Write the per-phase results of each session as JSON to <file>."),
+                                        QCoreApplication::translate("main", "file"));
+    parser.addOption(planResultOption);
+
+    QCommandLineOption autoTuneOption(QStringList() << "auto-tune",
+                                      QCoreApplication::translate("main", "Search the highest sustainable throughput over sizes, windows and baud rates, e.g. sizes=16:64:256,windows=1:4,errors=0.001,p99=20000, then exit."),
+                                      QCoreApplication::translate("main", "spec"));
+    parser.addOption(autoTuneOption);
+
+    QCommandLineOption fileTransferOption(QStringList() << "file-transfer",
+                                          QCoreApplication::translate("main", "Stream the memory-mapped <file> to the device instead of the size sweep."),
+                                          QCoreApplication::translate("main", "file"));
+    parser.addOption(fileTransferOption);
+
+    QCommandLineOption fileFrameOption(QStringList() << "file-frame",
+                                       QCoreApplication::translate("main", "Payload bytes per file transfer frame (default 1024)."),
+                                       QCoreApplication::translate("main", "bytes"),
+                                       "1024");
+    parser.addOption(fileFrameOption);
+
+    QCommandLineOption fileWindowOption(QStringList() << "file-window",
+                                        QCoreApplication::translate("main", "File transfer frames in flight (default 1)."),
+                                        QCoreApplication::translate("main", "frames"),
+                                        "1");
+    parser.addOption(fileWindowOption);
+
+    QCommandLineOption fileAckOption(QStringList() << "file-ack",
+                                     QCoreApplication::translate("main", "The device acknowledges file transfer frames instead of echoing them."));
+    parser.addOption(fileAckOption);
+
+    QCommandLineOption txBatchOption(QStringList() << "tx-batch",
+                                     QCoreApplication::translate("main", "Coalesce TX frames into one write up to a limit, e.g. frames=8,bytes=4096,us=500."),
+                                     QCoreApplication::translate("main", "spec"));
+    parser.addOption(txBatchOption);
+
+    QCommandLineOption allocCheckOption(QStringList() << "alloc-check",
+                                        QCoreApplication::translate("main", "Count the heap allocations of the frame path after a warm-up, a replay that allocates exits with 2."));
+    parser.addOption(allocCheckOption);
+
+    QCommandLineOption debugFramesOption(QStringList() << "debug-frames",
+                                         QCoreApplication::translate("main", "Log every frame sent and received, off by default as it formats strings per frame."));
+    parser.addOption(debugFramesOption);
+
+    QCommandLineOption serialBackendOption(QStringList() << "serial-backend",
+                                           QCoreApplication::translate("main", "Serial port backend, qt or native termios2 (default qt)."),
+                                           QCoreApplication::translate("main", "backend"));
+    parser.addOption(serialBackendOption);
+
+    QCommandLineOption serialVminOption(QStringList() << "serial-vmin",
+                                        QCoreApplication::translate("main", "VMIN of the native backend, bytes that wake a read (default 1)."),
+                                        QCoreApplication::translate("main", "bytes"),
+                                        "1");
+    parser.addOption(serialVminOption);
+
+    QCommandLineOption serialVtimeOption(QStringList() << "serial-vtime",
+                                         QCoreApplication::translate("main", "VTIME of the native backend in tenths of a second (default 0)."),
+                                         QCoreApplication::translate("main", "deciseconds"),
+                                         "0");
+    parser.addOption(serialVtimeOption);
+
+    QCommandLineOption serialBenchOption(QStringList() << "serial-bench",
+                                         QCoreApplication::translate("main", "Echo <frames> frames over a pty with each serial backend, print a comparison and exit."),
+                                         QCoreApplication::translate("main", "frames"));
+    parser.addOption(serialBenchOption);
+
+    QCommandLineOption traceEventsOption(QStringList() << "trace-events",
+                                         QCoreApplication::translate("main", "Record scoped trace points and write them as Chrome trace-event JSON to <file> on exit."),
+                                         QCoreApplication::translate("main", "file"));
+    parser.addOption(traceEventsOption);
+
     parser.process(a);
 
+    if (parser.isSet(exportTraceOption)) {
+        QTextStream out(stdout);
+        return FrameTrace::Export(parser.value(exportTraceOption), "json" == parser.value(exportFormatOption), out) ? 0 : 1;
+    }
+
+    if (parser.isSet(traceEventsOption)) {
+        ScopedTrace::Enable();
+    }
+
+    // VMIN and VTIME are single termios bytes, used by the native backend and the serial bench
+    bool vminOk, vtimeOk;
+    int vmin = parser.value(serialVminOption).toInt(&vminOk);
+    int vtime = parser.value(serialVtimeOption).toInt(&vtimeOk);
+
+    if (!vminOk || vmin < 0 || 255 < vmin || !vtimeOk || vtime < 0 || 255 < vtime) {
+        printf("Invalid serial VMIN %s, VTIME %s, expected 0..255\n",
+               qPrintable(parser.value(serialVminOption)), qPrintable(parser.value(serialVtimeOption)));
+        return 1;
+    }
+
+    if (parser.isSet(serialBenchOption)) {
+        bool ok;
+        int frames = parser.value(serialBenchOption).toInt(&ok);
+
+        if (!ok || frames < 1) {
+            printf("Invalid serial bench frame count %s\n", qPrintable(parser.value(serialBenchOption)));
+            return 1;
+        }
+
+        SerialBench bench(frames, vmin, vtime);
+        QObject::connect(&bench, &SerialBench::finished, &a, [&a](int exitCode) {
+            a.exit(exitCode);
+        });
+        QTimer::singleShot(0, &bench, &SerialBench::Start);
+        return a.exec();
+    }
+
     MainWindow m;
-    setStylesheet();
+
+    // Style sheet parsing is the largest part of the startup, nobody sees it headless
+    if (!MainWindow::isHeadless()) {
+        setStylesheet();
+    }
+
+    if (parser.isSet(framingOption)) {
+        Framing_t framing;
+
+        if (!ByteStuffing::FromName(parser.value(framingOption), framing)) {
+            printf("Unknown framing %s\n", qPrintable(parser.value(framingOption)));
+            return 1;
+        }
+
+        m.setFraming(framing);
+    }
+
+    // After the framing, the ring has to hold the largest frame as it arrives on the wire
+    if (parser.isSet(rxBufferOption)) {
+        bool ok;
+        qint64 size = parser.value(rxBufferOption).toLongLong(&ok);
+
+        if (!ok || !m.setRxBufferSize(size)) {
+            printf("Invalid receive buffer size %s, the largest frame needs %lld bytes\n",
+                   qPrintable(parser.value(rxBufferOption)), (long long)m.getLargestFrame());
+            return 1;
+        }
+    }
+
+    if (parser.isSet(metricsPortOption)) {
+        bool ok;
+        int port = parser.value(metricsPortOption).toInt(&ok);
+
+        if (!ok || port < 1 || 65535 < port) {
+            printf("Invalid metrics port %s, expected 1..65535\n", qPrintable(parser.value(metricsPortOption)));
+            return 1;
+        }
+
+        if (!m.startMetricsServer(port)) {
+            return 1;
+        }
+    }
+
+    if (parser.isSet(serialBackendOption)) {
+        Serial_Backend_t backend;
+
+        if (!serial_port::BackendFromName(parser.value(serialBackendOption), backend)) {
+            printf("Unknown serial backend %s\n", qPrintable(parser.value(serialBackendOption)));
+            return 1;
+        }
+
+        m.setSerialBackend(backend, vmin, vtime);
+    }
+
+    if (parser.isSet(socketProfileOption)) {
+        Socket_Profile_t profile;
+
+        if (!SocketProfileFromName(parser.value(socketProfileOption), profile)) {
+            printf("Unknown socket profile %s\n", qPrintable(parser.value(socketProfileOption)));
+            return 1;
+        }
+
+        m.setSocketProfile(profile);
+    }
+
+    if (parser.isSet(compareProfilesOption)) {
+        QList<Socket_Profile_t> profiles;
+
+        if (!SocketProfilesFromList(parser.value(compareProfilesOption), profiles)) {
+            printf("Invalid socket profile list %s\n", qPrintable(parser.value(compareProfilesOption)));
+            return 1;
+        }
+
+        QObject::connect(&m, &MainWindow::comparisonFinished, &a, [&a]() {
+            a.exit(0);
+        });
+        m.startProfileComparison(profiles);
+    }
+
+    if (parser.isSet(payloadOption) && !m.setPayload(parser.value(payloadOption))) {
+        return 1;
+    }
+
+    if (parser.isSet(planOption) && !m.loadPlan(parser.value(planOption))) {
+        return 1;
+    }
+
+    if (parser.isSet(planResultOption)) {
+        m.setPlanResult(parser.value(planResultOption));
+    }
+
+    if (parser.isSet(autoTuneOption)) {
+        TuneConfig config;
+        QString error;
+
+        if (!TuneConfig::Parse(parser.value(autoTuneOption), config, error)) {
+            printf("%s\n", qPrintable(error));
+            return 1;
+        }
+
+        QObject::connect(&m, &MainWindow::autoTuneFinished, &a, [&a]() {
+            a.exit(0);
+        });
+
+        if (!m.startAutoTune(config)) {
+            return 1;
+        }
+    }
+
+    if (parser.isSet(fileTransferOption)) {
+        bool frameOk, windowOk;
+        int frameSize = parser.value(fileFrameOption).toInt(&frameOk);
+        int window = parser.value(fileWindowOption).toInt(&windowOk);
+
+        // The ranges are checked by the transfer itself
+        if (!frameOk || !windowOk) {
+            printf("Invalid file transfer frame size %s, window %s\n",
+                   qPrintable(parser.value(fileFrameOption)), qPrintable(parser.value(fileWindowOption)));
+            return 1;
+        }
+
+        if (!m.startFileTransfer(parser.value(fileTransferOption), frameSize, window, parser.isSet(fileAckOption))) {
+            return 1;
+        }
+    }
+
+    if (parser.isSet(verifyOption)) {
+        m.setVerify(true);
+    }
+
+    if (parser.isSet(allocCheckOption)) {
+        if (!AllocScope::Available()) {
+            printf("--alloc-check is not compiled in, configure with -DQCOMMTEST_ALLOC_CHECK=ON\n");
+            return 1;
+        }
+
+        m.setAllocCheck(true);
+    }
+
+    if (parser.isSet(debugFramesOption)) {
+        QLoggingCategory::setFilterRules(QStringLiteral("qcommtest.frames.debug=true"));
+    }
+
+    if (parser.isSet(extHeaderOption)) {
+        m.setExtendedHeader(true);
+    }
+
+    if (parser.isSet(berOption)) {
+        Prbs_t type;
+
+        if (!PrbsGenerator::FromName(qPrintable(parser.value(berOption)), type)) {
+            printf("Unknown PRBS pattern %s\n", qPrintable(parser.value(berOption)));
+            return 1;
+        }
+
+        m.startBerMode(type);
+    }
+
+    if (parser.isSet(txBatchOption)) {
+        BatchPolicy policy;
+        QString error;
+
+        if (!BatchPolicy::Parse(parser.value(txBatchOption), policy, error)) {
+            printf("%s\n", qPrintable(error));
+            return 1;
+        }
+
+        m.setTxBatch(policy);
+    }
+
+    if (parser.isSet(linkOption)) {
+        LinkProfile profile;
+        QString error;
+
+        if (!LinkProfile::Parse(parser.value(linkOption), profile, error)) {
+            printf("%s\n", qPrintable(error));
+            return 1;
+        }
+
+        m.startLinkEmulation(profile);
+    }
+
+    if (parser.isSet(benchmarkOption)) {
+        bool runsOk, warmupOk;
+        int runs = parser.value(benchmarkOption).toInt(&runsOk);
+        int warmup = parser.value(warmupOption).toInt(&warmupOk);
+
+        if (!runsOk || runs < 1 || !warmupOk || warmup < 0) {
+            printf("Invalid benchmark run count %s, warm-up %s\n", qPrintable(parser.value(benchmarkOption)), qPrintable(parser.value(warmupOption)));
+            return 1;
+        }
+
+        if (runs < 2 && (parser.isSet(baselineOption) || parser.isSet(saveBaselineOption))) {
+            printf("A baseline needs at least 2 benchmark runs, the t-test has no variance from one\n");
+            return 1;
+        }
+
+        QObject::connect(&m, &MainWindow::benchmarkFinished, &a, [&a](Baseline_Result_t result) {
+            // A baseline that could not be used must not pass as "no regression"
+            a.exit(Baseline_Result_t::Passed == result ? 0 : (Baseline_Result_t::Regressed == result ? 1 : 2));
+        });
+        m.startBenchmark(runs, warmup, parser.value(baselineOption), parser.value(saveBaselineOption));
+    }
+
+    if (parser.isSet(soakOption)) {
+        bool ok;
+        int seconds = parser.value(soakOption).toInt(&ok);
+
+        if (!ok || seconds < 1) {
+            printf("Invalid soak snapshot interval %s, expected seconds\n", qPrintable(parser.value(soakOption)));
+            return 1;
+        }
+
+        m.startSoak(seconds);
+    }
+
+    if (parser.isSet(frameTraceOption)) {
+        bool ok;
+        quint32 capacity = parser.value(frameTraceCapacityOption).toUInt(&ok);
+
+        if (!ok || 0 == capacity) {
+            printf("Invalid frame trace capacity %s\n", qPrintable(parser.value(frameTraceCapacityOption)));
+            return 1;
+        }
+
+        if (!m.startFrameTrace(parser.value(frameTraceOption), capacity)) {
+            return 1;
+        }
+    }
+
+    if (parser.isSet(captureOption) && !m.startCapture(parser.value(captureOption))) {
+        return 1;
+    }
 
     if (parser.isSet(tcpPortOption)) {
         int port = parser.value(tcpPortOption).toInt();
         m.startTcpServer(port);
     }
 
+    if (parser.isSet(replayOption)) {
+        QObject::connect(&m, &MainWindow::replayFinished, &a, [&a, &m](bool matched) {
+            a.exit(!matched ? 1 : (m.allocCheckPassed() ? 0 : 2));
+        });
+
+        if (!m.startReplay(parser.value(replayOption), "max" != parser.value(replaySpeedOption))) {
+            return 1;
+        }
+    }
+
     m.show();
-    return a.exec();
+    QTimer::singleShot(0, &m, [&m, startedAt]() {
+        m.setStartupTime(monotonicNs() - startedAt);
+    });
+    int ret = a.exec();
+
+    if (parser.isSet(traceEventsOption)) {
+        ScopedTrace::Dump(parser.value(traceEventsOption));
+    }
+
+    return ret;
 }
@@ -8,6 +8,12 @@
 #include "ui_mainwindow.h"
 #include "tcp_server.h"
 #include "serial_port.h"
+#include "mono_clock.h"
+#include "protocol.h"
+#include "simd_ops.h"
+#include "scoped_trace.h"
+#include "frame_log.h"
+#include "alloc_counter.h"
 #include <QtWidgets>
 
 const char *LOGO                = ":/qss_icons/rc/logo.png";
@@ -18,24 +24,48 @@ const char *MOOD_TESTING        = ":/qss_icons/rc/mood/mood_testing.gif";
 const char *MOOD_RESULT_SUCCESS = ":/qss_icons/rc/mood/mood_result_success.gif";
 const char *MOOD_RESULT_FAIL    = ":/qss_icons/rc/mood/mood_result_error.gif";
 
-const int TEST_INDEX_MAX        = 400;  // This must be changed in test code too
-const int TEST_FRAME_TIMEOUT    = 500;  // [ms]
-
 const int PROTOCOL_OVERHEAD     = 7;    // [bytes]
+const char HEADER_CLASSIC       = 0x00;
+const char HEADER_EXTENDED      = 0x01; // seq32 | ts64 follow the length
+const int EXT_HEADER_SIZE       = 12;   // [bytes]
+const char PROTOCOL_VERSION_EXT = 0x02; // Second start frame byte offering the extended header
+const int FRAME_POOL_BUFFERS    = 6;    // RX block, decoded RX frame, TX payload, TX frame, stuffed TX frame and a spare
+const int LOG_MAX_LINES         = 10000;    // Log ring capacity, older lines are dropped
+const int PLAN_RESERVE_MAX      = 1 << 20;  // Latency samples reserved up front, longer plans grow on the way
+const int UI_REFRESH_MS         = 100;      // Counter widgets refresh period
+const int ALLOC_WARMUP_FRAMES   = 16;       // Echoes before --alloc-check starts counting
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
+    m_headless = isHeadless();
     Form_Init();
     TcpServer_Init();
     SerialPort_Init();
+    Replay_Init();
     connect(&m_timer_test, &QTimer::timeout, this, &MainWindow::onTimeoutTest);
     m_timer_test.setSingleShot(true);
     m_timer_test.stop();
     ui->test_data_size->clear();
     m_testStartAt = 0;
     m_testFinishAt = 0;
+    memset(&m_frame, 0, sizeof(m_frame));
+    connect(&m_timer_pace, &QTimer::timeout, this, &MainWindow::onTimeoutPace);
+    m_timer_pace.setSingleShot(true);
+    m_timer_pace.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer_batch, &QTimer::timeout, this, &MainWindow::onTimeoutBatch);
+    m_timer_batch.setSingleShot(true);
+    m_timer_batch.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer_ui, &QTimer::timeout, this, &MainWindow::UpdateCounters);
+    m_timer_ui.start(UI_REFRESH_MS);
+    ui->chart->setSeries(&m_series);
+    m_link = new LinkEmulator(this);
+    m_payload = new RampPayload();
+    m_plan = TestPlan::Default();
+    ApplyPlan();
+    m_linkRxBuffer.Resize(m_tcpServer->getRxBuffer().capacity());    // Bursts delivered by the link emulator
+    connect(m_link, &LinkEmulator::delivered, this, &MainWindow::onLinkDelivered);
     SetTestStarted(false);
     SetMoodIcon(Icon_t::Disconnected);
 }
@@ -57,9 +87,28 @@ void MainWindow::Form_Init()
     addAction(quitAction);
     setContextMenuPolicy(Qt::ActionsContextMenu);
     ui->setupUi(this);
-    ui->rx_progress->setMaximum(TEST_INDEX_MAX);
-    ui->tx_progress->setMaximum(TEST_INDEX_MAX);
-    ui->error_progress->setMaximum(TEST_INDEX_MAX);
+    m_log = new LogModel(LOG_MAX_LINES, this);
+    m_logFilter = new LogFilter(m_log, this);
+    ui->log_view->setModel(m_logFilter);
+
+    for(int level = 0; level <= static_cast<int>(Log_Level_t::Error); level++)
+    {
+        ui->log_level->addItem(LogModel::LevelName(static_cast<Log_Level_t>(level)));
+    }
+
+    // Follows the newest line only while the view is scrolled to the bottom
+    connect(m_logFilter, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]()
+    {
+        QScrollBar *bar = ui->log_view->verticalScrollBar();
+        m_logFollow = bar->value() == bar->maximum();
+    });
+    connect(m_logFilter, &QAbstractItemModel::rowsInserted, this, [this]()
+    {
+        if(m_logFollow)
+        {
+            ui->log_view->scrollToBottom();
+        }
+    });
     connect(ui->closebutton, &QPushButton::clicked, this, &QWidget::close);
 }
 
@@ -121,22 +170,40 @@ MainWindow::~MainWindow()
     delete usageAction;
     delete aboutAction;
     delete quitAction;
-    delete movie;
     delete m_tcpServer;
     delete m_serialPort;
+    delete m_replayPort;
+    delete m_capture;
+    delete m_metricsServer;
+    delete m_payload;
+    qDeleteAll(m_phasePayloads);
     delete ui;
 }
 
 void MainWindow::onLogMessage(const QString &log)
+{
+    AddLog(Log_Level_t::Info, log);
+}
+
+void MainWindow::Log(const QString &log, Log_Level_t level)
+{
+    AddLog(level, "Test : " + log);
+}
+
+void MainWindow::AddLog(Log_Level_t level, const QString &log)
 {
     qDebug() << log;
-    ui->log_textedit->append(log);
-    ui->log_textedit->verticalScrollBar()->setValue(ui->log_textedit->verticalScrollBar()->maximum());
+    m_log->Append(level, log);
+}
+
+void MainWindow::on_log_level_currentIndexChanged(int index)
+{
+    m_logFilter->setMinimumLevel(static_cast<Log_Level_t>(qMax(0, index)));
 }
 
-void MainWindow::Log(const QString &log)
+void MainWindow::on_log_search_textChanged(const QString &text)
 {
-    onLogMessage("Test : " + log);
+    m_logFilter->setSearch(text);
 }
 
 void MainWindow::on_tabWidget_currentChanged(int index)
@@ -161,7 +228,13 @@ void MainWindow::SerialPort_Init()
     m_serialPort = new serial_port(this);
     connect(m_serialPort, &serial_port::dataReceived, this, &MainWindow::onSerialDataReceived);
     connect(m_serialPort, &serial_port::logMessage, this, &MainWindow::onLogMessage);
-    SerialPort_Refresh();
+    connect(m_serialPort, &serial_port::portLost, this, &MainWindow::onSerialPortLost);
+    connect(m_serialPort, &serial_port::txDone, this, &MainWindow::onTxDone);
+    m_portDiscovery = new PortDiscovery(this);
+    connect(m_portDiscovery, &PortDiscovery::logMessage, this, &MainWindow::onLogMessage);
+    connect(m_portDiscovery, &PortDiscovery::scanFinished, this, &MainWindow::onSerialPortsScanned);
+    ui->serial_port_name->setModel(m_portDiscovery->getModel());
+    m_portDiscovery->Start();
     ui->baud_rate->addItem(QStringLiteral("9600"), QSerialPort::Baud9600);
     ui->baud_rate->addItem(QStringLiteral("19200"), QSerialPort::Baud19200);
     ui->baud_rate->addItem(QStringLiteral("38400"), QSerialPort::Baud38400);
@@ -191,31 +264,31 @@ void MainWindow::SerialPort_Init()
 
 void MainWindow::SerialPort_Refresh()
 {
-    auto list = m_serialPort->Scan();
-    ui->serial_port_name->clear();
+    // The known ports stay listed, the scan only adds and removes rows
+    m_portDiscovery->Refresh();
+}
 
-    if(list.size())
+void MainWindow::onSerialPortsScanned(int count)
+{
+    if(0 == count)
     {
-        ui->serial_port_name->addItems(list);
+        ui->serial_status->setText("No ports found!");
     }
-    else
+    else if(ui->serial_status->text() == "No ports found!")
     {
-        ui->serial_status->setText("No ports found!");
+        ui->serial_status->clear();
     }
 }
 
 bool MainWindow::SerialPort_Start()
 {
     bool ret = false;
-    QString selected_port = ui->serial_port_name->currentText();
+    QString selected_port = ui->serial_port_name->currentData(PortModel::NameRole).toString();
 
     if(m_serialPort->Open(selected_port))
     {
-        m_serialPort->Configure(static_cast<QSerialPort::BaudRate>(ui->baud_rate->itemData(ui->baud_rate->currentIndex()).toInt()),
-                                static_cast<QSerialPort::DataBits>(ui->data_bits->itemData(ui->data_bits->currentIndex()).toInt()),
-                                static_cast<QSerialPort::FlowControl>(ui->flow_control->itemData(ui->flow_control->currentIndex()).toInt()),
-                                static_cast<QSerialPort::Parity>(ui->parity->itemData(ui->parity->currentIndex()).toInt()),
-                                static_cast<QSerialPort::StopBits>(ui->stop_bits->itemData(ui->stop_bits->currentIndex()).toInt()));
+        // A baud rate sweep overrides the selection
+        SerialPort_Configure(m_tune.getBaud() ? m_tune.getBaud() : ui->baud_rate->itemData(ui->baud_rate->currentIndex()).toInt());
         ret = true;
     }
     else
@@ -226,6 +299,15 @@ bool MainWindow::SerialPort_Start()
     return ret;
 }
 
+void MainWindow::SerialPort_Configure(qint32 rate)
+{
+    m_serialPort->Configure(rate,
+                            static_cast<QSerialPort::DataBits>(ui->data_bits->itemData(ui->data_bits->currentIndex()).toInt()),
+                            static_cast<QSerialPort::FlowControl>(ui->flow_control->itemData(ui->flow_control->currentIndex()).toInt()),
+                            static_cast<QSerialPort::Parity>(ui->parity->itemData(ui->parity->currentIndex()).toInt()),
+                            static_cast<QSerialPort::StopBits>(ui->stop_bits->itemData(ui->stop_bits->currentIndex()).toInt()));
+}
+
 void MainWindow::SerialPort_Stop()
 {
     m_serialPort->Close();
@@ -233,9 +315,17 @@ void MainWindow::SerialPort_Stop()
 
 void MainWindow::onSerialDataReceived()
 {
-    QByteArray dataBuffer;
-    dataBuffer = m_serialPort->Read();
-    Test(Channel_t::Serial, dataBuffer);
+    Receive(Channel_t::Serial, m_serialPort->Read());
+}
+
+void MainWindow::onSerialPortLost(const QString &error)
+{
+    // A session in progress ends on its frame timeout
+    Log("Serial port lost : " + error, Log_Level_t::Error);
+    ui->serial_status->setText("Serial port lost");
+    SerialPort_SetEnabled(true);
+    ui->serial_open->setText("Open");
+    SetMoodIcon(Icon_t::Disconnected);
 }
 
 void MainWindow::SerialPort_SetEnabled(bool enabled)
@@ -300,6 +390,7 @@ void MainWindow::TcpServer_Init()
     connect(m_tcpServer, &TcpServer::clientConnected, this, &MainWindow::onTcpClientConnected);
     connect(m_tcpServer, &TcpServer::clientDisconnected, this, &MainWindow::onTcpClientDisconnected);
     connect(m_tcpServer, &TcpServer::logMessage, this, &MainWindow::onLogMessage);
+    connect(m_tcpServer, &TcpServer::txDone, this, &MainWindow::onTxDone);
 }
 
 bool MainWindow::TcpServer_Start(int serverport)
@@ -314,12 +405,9 @@ void MainWindow::TcpServer_Stop()
 
 void MainWindow::onTcpDataReceivedFromClient()
 {
-    QByteArray dataBuffer;
-
     if(m_tcpServer->isClientConnected())
     {
-        dataBuffer = m_tcpServer->Read();
-        Test(Channel_t::TCP, dataBuffer);
+        Receive(Channel_t::TCP, m_tcpServer->Read());
     }
 }
 
@@ -376,424 +464,2118 @@ void MainWindow::startTcpServer(int port)
 //---------------------------------------------------------------
 
 
-
 //---------------------------------------------------------------
 
-void MainWindow::PrintResults()
+void MainWindow::Replay_Init()
 {
-    Log(QString("Duration : %1 ms").arg(m_testFinishAt - m_testStartAt));
-    Log(QString("Communication time : %1 ms").arg(m_testElapsedTime));
-    Log(QString("Transferred data size %1 bytes").arg(m_data_size));
+    m_capture = new TrafficCapture();
+    connect(m_capture, &TrafficCapture::logMessage, this, &MainWindow::onLogMessage);
+    m_replayPort = new ReplayPort();
+    connect(m_replayPort, &ReplayPort::dataReceived, this, &MainWindow::onReplayDataReceived);
+    connect(m_replayPort, &ReplayPort::finished, this, &MainWindow::onReplayFinished);
+    connect(m_replayPort, &ReplayPort::logMessage, this, &MainWindow::onLogMessage);
+    connect(m_replayPort, &ReplayPort::txDone, this, &MainWindow::onTxDone);
+}
 
-    if(m_testElapsedTime)
+bool MainWindow::startCapture(const QString &path)
+{
+    bool ret = m_capture->Start(path);
+
+    if(ret)
     {
-        Log(QString("Data rate %1 KBps").arg(m_data_size / m_testElapsedTime));
+        m_tcpServer->setCapture(m_capture);
+        m_serialPort->setCapture(m_capture);
     }
+
+    return ret;
 }
 
-void MainWindow::onTimeoutTest()
+bool MainWindow::startReplay(const QString &path, bool realtime)
 {
-    m_timer_test.stop();
+    if(!m_replayPort->Open(path))
+    {
+        ui->test_status->setText("Replay failed");
+        return false;
+    }
+
     SetTestStarted(false);
-    m_testFinishAt = QDateTime::currentMSecsSinceEpoch();
-    ui->test_status->setText("Test timed out");
-    Log("Timeout");
-    PrintResults();
-    SetMoodIcon(Icon_t::TestFailed);
+    SetMoodIcon(Icon_t::Connecting);
+    ui->test_status->setText("Replaying capture");
+    m_replayPort->Start(realtime);
+    return true;
 }
 
-bool MainWindow::Send(Channel_t channel, QByteArray dataBuffer)
+bool MainWindow::startFrameTrace(const QString &path, quint32 capacity)
 {
-    bool ret = false;
+    bool ret = m_frameTrace.Open(path, capacity);
 
-    switch(channel)
+    if(ret)
     {
-        case Channel_t::Serial:
-            ret = m_serialPort->Write(Protocol_Wrap(dataBuffer));
-            break;
-
-        case Channel_t::TCP:
-            ret = m_tcpServer->Write(Protocol_Wrap(dataBuffer));
-            break;
-
-        default:
-            break;
+        Log(QString("Frame trace %1 (%2 frames)").arg(path).arg(capacity));
+    }
+    else
+    {
+        Log("Unable to create frame trace " + path, Log_Level_t::Error);
     }
 
     return ret;
 }
 
-qint64 MainWindow::PacketTimeout(Channel_t channel)
+bool MainWindow::setRxBufferSize(qint64 size)
 {
-    qint64 timeout = PROTOCOL_OVERHEAD + m_testIndex;
-
-    switch(channel)
+    if(size < getLargestFrame())
     {
-        case Channel_t::Serial:
-            timeout = m_serialPort->getBaudTimeout(timeout);
-            break;
-
-        case Channel_t::TCP:
-            timeout = m_tcpServer->getTimeout(timeout);
-            break;
-
-        default:
-            break;
+        Log(QString("Receive buffer of %1 bytes is below the largest frame of %2 bytes").arg(size).arg(getLargestFrame()), Log_Level_t::Error);
+        return false;
     }
 
-    timeout += TEST_FRAME_TIMEOUT;
-    return timeout;
+    m_tcpServer->setReadBufferSize(size);
+    m_serialPort->setReadBufferSize(size);
+    m_replayPort->setReadBufferSize(size);
+    m_linkRxBuffer.Resize(size);
+    return true;
 }
 
-qint64 MainWindow::ElapsedTime(Channel_t channel)
+qint64 MainWindow::getLargestFrame() const
 {
-    qint64 time = 0;
+    return LargestFrame(m_maxPayload);
+}
 
-    switch(channel)
-    {
-        case Channel_t::Serial:
-            time = m_serialPort->getReceivedTime() - m_serialPort->getSentTime();
-            break;
+qint64 MainWindow::LargestFrame(int payload) const
+{
+    qint64 frame = PROTOCOL_OVERHEAD + EXT_HEADER_SIZE + payload;
 
-        case Channel_t::TCP:
-            time = m_tcpServer->getReceivedTime() - m_tcpServer->getSentTime();
-            break;
+    // Worst case of byte stuffing is SLIP, every byte escaped plus the delimiters
+    return (Framing_t::None == m_framing) ? frame : 2 * frame + 2;
+}
 
-        default:
-            break;
+bool MainWindow::FitsRxBuffer(int payload, const QString &what)
+{
+    // Under --link frames are reassembled in the emulator's delivery ring as well
+    qint64 capacity = qMin(RxBuffer(m_testChannel).capacity(), m_linkRxBuffer.capacity());
+
+    // A frame larger than the ring is dropped piecewise and never completes
+    if(capacity < LargestFrame(payload))
+    {
+        Log(QString("%1 : the largest frame of %2 bytes does not fit the %3 byte receive buffer, raise --rx-buffer")
+            .arg(what).arg(LargestFrame(payload)).arg(capacity), Log_Level_t::Error);
+        return false;
     }
 
-    return time;
+    return true;
 }
 
-void MainWindow::SetTestStarted(bool value)
+void MainWindow::setSerialBackend(Serial_Backend_t backend, int vmin, int vtime)
 {
-    m_testStarted = value;
-    m_testIndex = 0;
-    m_testStep = Test_Step_t::step_Idle;
+    m_serialPort->setBackend(backend, vmin, vtime);
 }
 
-void MainWindow::SetMoodIcon(Icon_t icon)
+bool MainWindow::startMetricsServer(int port)
 {
-    if(ui->moodicon->movie() != nullptr)
-    {
-        if(ui->moodicon->movie()->isValid())
-        {
-            ui->moodicon->movie()->stop();
-        }
-    }
-
-    if(movie)
+    if(nullptr == m_metricsServer)
     {
-        delete movie;
-        movie = nullptr;
+        m_metricsServer = new MetricsServer(&m_metrics);
+        connect(m_metricsServer, &MetricsServer::logMessage, this, &MainWindow::onLogMessage);
     }
 
-    switch(icon)
-    {
-        case Icon_t::Disconnected:
-            ui->moodicon->setPixmap(QPixmap(MOOD_DISCONNECTED));
-            break;
+    return m_metricsServer->Start(port);
+}
 
-        case Icon_t::Connecting:
-            movie = new QMovie(MOOD_CONNECTING);
-            ui->moodicon->setMovie(movie);
-            movie->start();
-            ui->test_status->setText("Waiting for a connection");
-            break;
+void MainWindow::setSocketProfile(Socket_Profile_t profile)
+{
+    m_tcpServer->setSocketProfile(profile);
+}
 
-        case Icon_t::Testing:
-            movie = new QMovie(MOOD_TESTING);
-            ui->moodicon->setMovie(movie);
-            movie->start();
-            break;
+void MainWindow::startProfileComparison(const QList<Socket_Profile_t> &profiles)
+{
+    m_compareProfiles = profiles;
+    m_compareRun = 0;
+    m_compareResults.clear();
+    m_tcpServer->setSocketProfile(profiles[0]);
+    Log(QString("Comparing %1 socket profiles, one session each").arg(profiles.size()));
+}
 
-        case Icon_t::TestSuccess:
-            movie = new QMovie(MOOD_RESULT_SUCCESS);
-            ui->moodicon->setMovie(movie);
-            movie->start();
-            break;
+bool MainWindow::setPayload(const QString &spec)
+{
+    QString error;
+    PayloadGenerator *payload = PayloadGenerator::Create(spec, error);
 
-        case Icon_t::TestFailed:
-            movie = new QMovie(MOOD_RESULT_FAIL);
-            ui->moodicon->setMovie(movie);
-            movie->start();
-            break;
+    if(nullptr == payload)
+    {
+        Log(error, Log_Level_t::Error);
+        return false;
     }
+
+    delete m_payload;
+    m_payload = payload;
+    Log("Payload " + m_payload->Name());
+    return true;
 }
 
-void MainWindow::Clean_Counters()
+void MainWindow::setVerify(bool verify)
 {
-    ui->rx_count->display(0);
-    ui->rx_progress->setValue(0);
-    ui->tx_count->display(0);
-    ui->tx_progress->setValue(0);
-    ui->error_count->display(0);
-    ui->error_progress->setValue(0);
-    m_data_size = 0;
-    ui->test_data_size->clear();
-    m_testElapsedTime = 0;
+    m_verify = verify;
+    Log(QString("Echo content verification %1, %2 kernels").arg(QLatin1String(verify ? "on" : "off")).arg(QLatin1String(simd::Name())));
 }
 
-void MainWindow::Inc_Error()
+void MainWindow::setAllocCheck(bool enabled)
 {
-    ui->error_count->display(ui->error_count->intValue() + 1);
-    ui->error_progress->setValue(ui->error_progress->value() + 1);
+    m_allocCheck = enabled;
+    Log(QString("Frame path allocation check %1").arg(QLatin1String(enabled ? "on" : "off")));
 }
 
-void MainWindow::Inc_RX()
+bool MainWindow::allocCheckPassed() const
 {
-    ui->rx_count->display(ui->rx_count->intValue() + 1);
-    ui->rx_progress->setValue(ui->rx_progress->value() + 1);
+    return !m_allocCheck || 0 == m_allocations;
 }
 
-void MainWindow::Inc_TX()
+void MainWindow::setExtendedHeader(bool allowed)
 {
-    ui->tx_count->display(ui->tx_count->intValue() + 1);
-    ui->tx_progress->setValue(ui->tx_progress->value() + 1);
+    m_extAllowed = allowed;
+    Log(QString("Extended header %1").arg(QLatin1String(allowed ? "accepted when offered" : "off")));
 }
 
-void MainWindow::Test(Channel_t channel, QByteArray dataBuffer)
+void MainWindow::setFraming(Framing_t framing)
 {
-    bool ret = false;
-    QByteArray data;
-    int data_size;
-    data = Protocol_Unwrap(dataBuffer);
-    data_size = data.size();
+    m_framing = framing;
+    Log(QString("Framing %1, %2 kernels").arg(QLatin1String(ByteStuffing::Name(framing))).arg(QLatin1String(simd::Name())));
+}
 
-    if(data_size)
+void MainWindow::startSoak(int reportSeconds)
+{
+    m_soak = true;
+    m_soakStartedAt = monotonicNs();
+    m_soakRssStart = -1;
+    m_sweeps = 0;
+    m_soakTimeouts = 0;
+    m_series.ResetTotal(m_soakStartedAt);
+    connect(&m_timer_soak, &QTimer::timeout, this, &MainWindow::SoakSnapshot);
+    m_timer_soak.start(qMax(1, reportSeconds) * 1000);
+    Log(QString("Soak mode, the size sweep repeats until stopped, snapshot every %1 s").arg(qMax(1, reportSeconds)));
+}
+
+bool MainWindow::loadPlan(const QString &path)
+{
+    TestPlan plan;
+    QString error;
+    QVector<PayloadGenerator *> payloads;
+
+    if(!plan.Load(path, error))
     {
-        switch(m_testStep)
-        {
-            case Test_Step_t::step_Idle:
-                if(1 == data_size && 0x00 == data.at(0))
-                {
-                    Clean_Counters();
-                    SetTestStarted(true);
-                    m_testStartAt = QDateTime::currentMSecsSinceEpoch();
-                    Log("Started");
-                    ui->test_status->setText("Testing...");
-                    m_testStep = Test_Step_t::step_Test;
-                    m_testIndex = 1;
-                    SetMoodIcon(Icon_t::Testing);
-                }
-                else
-                {
-                    Log("Wrong start request received");
-                    Inc_Error();
-                    break;
-                }
+        Log(error, Log_Level_t::Error);
+        return false;
+    }
 
-                [[fallthrough]];
+    if(!FitsRxBuffer(plan.MaxSize(), "Test plan " + plan.getName()))
+    {
+        return false;
+    }
 
-            case Test_Step_t::step_Test:
-                if(m_testStarted && m_testIndex)
-                {
-                    qint32 i;
+    for(int i = 0; i < plan.count(); i++)
+    {
+        PayloadGenerator *payload = nullptr;
 
-                    // Measurement
-                    //------------------------------------------------------------
-                    if(1 < m_testIndex)
-                    {
-                        m_testElapsedTime += ElapsedTime(channel);
-                    }
+        if(!plan.phase(i).payload.isEmpty() && nullptr == (payload = PayloadGenerator::Create(plan.phase(i).payload, error)))
+        {
+            Log(QString("Test plan phase \"%1\" : %2").arg(plan.phase(i).name).arg(error), Log_Level_t::Error);
+            qDeleteAll(payloads);
+            return false;
+        }
 
-                    //------------------------------------------------------------
-                    // RX
-                    //------------------------------------------------------------
-                    Inc_RX();
-                    Log("RX");
+        payloads.append(payload);
+    }
 
-                    //------------------------------------------------------------
+    qDeleteAll(m_phasePayloads);
+    m_phasePayloads = payloads;
+    m_plan = plan;
+    ApplyPlan();
+    Log(QString("Test plan %1 : %2 phases, %3 frames").arg(m_plan.getName()).arg(m_plan.count()).arg(m_plan.TotalFrames()));
+    return true;
+}
 
-                    // Check Index
-                    //------------------------------------------------------------
-                    if(1 < m_testIndex)
-                    {
-                        data_size++;
-                    }
+void MainWindow::setPlanResult(const QString &path)
+{
+    m_planResultPath = path;
+}
 
-                    if(m_testIndex != data_size)
-                    {
-                        Log("Wrong Index");
-                        Inc_Error();
-                    }
+bool MainWindow::startAutoTune(const TuneConfig &config)
+{
+    PlanPhase envelope;
 
-                    Log(QString("Index %1 / %2").arg(m_testIndex).arg(data_size));
-                    //------------------------------------------------------------
-                    // TX
-                    //------------------------------------------------------------
-                    QByteArray dataToSend;
-                    dataToSend.resize(m_testIndex);
-                    for (qint32 k = 0; k < m_testIndex; ++k) {
-                        dataToSend[k] = (char)(m_testIndex - k);
-                    }
+    if(!FitsRxBuffer(config.MaxSize(), "Auto-tune"))
+    {
+        return false;
+    }
 
-                    ret = Send(channel, dataToSend);
+    // The buffers are sized once for the largest trial, every trial then replaces the single phase
+    envelope.sizeFrom = config.MaxSize();
+    envelope.sizeTo = envelope.sizeFrom;
+    // Enough for the longest search of one baud rate, the samples of a session are kept until it ends
+    envelope.repeat = static_cast<int>(qMin<qint64>((qint64)config.frames * (config.steps + 1) *
+                                                    config.sizes.size() * config.windows.size(), 0x7FFFFFFF));
+    envelope.window = config.MaxWindow();
+    qDeleteAll(m_phasePayloads);
+    m_phasePayloads.clear();
+    m_plan = TestPlan::FromPhase("auto-tune", envelope);
+    ApplyPlan();
+    m_tune.Start(config);
+    m_plan.setPhase(0, m_tune.Phase());
+    Log(QString("Auto-tune : %1 sizes, %2 windows, %3 baud rates, %4 frames per trial, errors %5, p99 %6 us")
+        .arg(config.sizes.size()).arg(config.windows.size()).arg(qMax(1, config.bauds.size())).arg(config.frames)
+        .arg(config.maxErrorRate).arg(config.maxP99));
+    return true;
+}
 
-                    if(ret)
-                    {
-                        m_timer_test.start(PacketTimeout(channel));
-                        Inc_TX();
-                        Log("TX");
-                    }
-                    else
-                    {
-                        Log("Send failed");
-                        Inc_Error();
-                    }
+bool MainWindow::startFileTransfer(const QString &path, int frameSize, int window, bool ack)
+{
+    PlanPhase phase;
+    QString error;
 
-                    //------------------------------------------------------------
-                    // Next index
-                    //------------------------------------------------------------
-                    m_testIndex++;
+    if(window < 1 || PROTOCOL_MAX_WINDOW < window)
+    {
+        Log(QString("Transfer window must be 1..%1").arg(PROTOCOL_MAX_WINDOW), Log_Level_t::Error);
+        return false;
+    }
 
-                    //------------------------------------------------------------
+    if(!FitsRxBuffer(frameSize, "File transfer"))
+    {
+        return false;
+    }
 
-                    // Check for finish
-                    //------------------------------------------------------------
-                    if(TEST_INDEX_MAX < m_testIndex)
-                    {
-                        m_timer_test.stop();
-                        SetTestStarted(false);
-                        m_testFinishAt = QDateTime::currentMSecsSinceEpoch();
+    if(!m_transfer.Open(path, frameSize, ack, error))
+    {
+        Log(error, Log_Level_t::Error);
+        return false;
+    }
 
-                        if(0 == ui->error_count->intValue())
-                        {
-                            Log("Finished successfully");
-                            ui->test_status->setText("Test finished successfully");
-                            SetMoodIcon(Icon_t::TestSuccess);
-                        }
-                        else
-                        {
-                            Log("Finished with errors");
-                            ui->test_status->setText("Test finished with errors");
-                            SetMoodIcon(Icon_t::TestFailed);
-                        }
+    // One phase with a frame per chunk of the file, the payloads come from the mapping
+    phase.name = "file";
+    phase.sizeFrom = frameSize;
+    phase.sizeTo = frameSize;
+    phase.repeat = static_cast<int>(qMin<qint64>(m_transfer.Frames(), 0x7FFFFFFF));
+    phase.window = window;
+    qDeleteAll(m_phasePayloads);
+    m_phasePayloads.clear();
+    m_plan = TestPlan::FromPhase("file transfer", phase);
+    ApplyPlan();
+    Log(QString("File transfer %1 : %2 bytes in %3 frames of %4 bytes, window %5, device %6")
+        .arg(path).arg(m_transfer.getSize()).arg(m_transfer.Frames()).arg(frameSize).arg(window)
+        .arg(QLatin1String(ack ? "acknowledges" : "echoes")));
+    return true;
+}
 
-                        PrintResults();
-                        m_testStep = Test_Step_t::step_Idle;
-                    }
+void MainWindow::setTxBatch(const BatchPolicy &policy)
+{
+    m_batcher.setPolicy(policy);
+    m_batcher.Reserve(m_frameBufferSize);
+    Log(QString("TX batching up to %1 frames, %2 bytes, %3 us").arg(policy.frames).arg(policy.bytes).arg(policy.linger));
+}
 
-                    //------------------------------------------------------------
-                    ui->test_data_size->setText(QString("%1 KB").arg(m_data_size / 1024));
-                }
-                else
-                {
-                    Log("Wrong state");
-                    Inc_Error();
-                }
+void MainWindow::ApplyPlan()
+{
+    qint64 frames = m_plan.TotalFrames();
+    int reserve = static_cast<int>(qMin<qint64>(frames + 1, PLAN_RESERVE_MAX));
+    int progress = static_cast<int>(qMin<qint64>(frames, 0x7FFFFFFF));
+
+    // Everything a session needs is sized here, the test itself does not allocate
+    m_phasePayloads.resize(m_plan.count());
+    m_maxPayload = m_plan.MaxSize();
+    m_frameBufferSize = 2 * (PROTOCOL_OVERHEAD + EXT_HEADER_SIZE + m_maxPayload) + 2;
+    m_framePool.Reset(m_frameBufferSize, FRAME_POOL_BUFFERS);
+    m_inFlight.resize(m_plan.MaxWindow());
+    m_inFlightHead = 0;
+    m_inFlightCount = 0;
+    m_expected.reserve(m_maxPayload * m_plan.MaxWindow());
+    m_batcher.Reserve(m_frameBufferSize);
+    m_latency.Reserve(reserve);
+    m_stages.Reserve(reserve);
+    m_clock.Reserve(reserve);
+    m_resyncLatency.Reserve(reserve);
+    m_phaseLatency.Reserve(reserve);
+    m_planResults.reserve(m_plan.count());
+    m_phase = 0;
+    ui->rx_progress->setMaximum(progress);
+    ui->tx_progress->setMaximum(progress);
+    ui->error_progress->setMaximum(progress);
+}
 
-                break;
+void MainWindow::SweepDone()
+{
+    m_sweeps++;
+    Log(QString("Sweep %1 done").arg(m_sweeps));
+    // Per sweep samples, the long windows come from the time series
+    m_latency.Clear();
+    m_stages.Clear();
+    m_clock.Reset();
+    m_resyncLatency.Clear();
+    m_planResults.clear();
+    m_rxProgressAt = m_rxCount;
+    m_txProgressAt = m_txCount;
+}
 
-            default:
-                Log("Wrong case");
-                m_testStep = Test_Step_t::step_Idle;
-                m_testIndex = 0;
-                break;
-        }
-    }
-    else
+void MainWindow::SoakSnapshot()
+{
+    qint64 now = monotonicNs();
+    qint64 rss = ResidentSetBytes();
+
+    if(m_soakRssStart < 0)
     {
-        Log("Not a valid packet");
-        Inc_Error();
+        m_soakRssStart = rss;
     }
+
+    Log(QString("Soak snapshot after %1 s, session %2, %3 sweeps, %4 timeouts, RSS %5 KB (first snapshot %6 KB)")
+        .arg((now - m_soakStartedAt) / 1000000000LL).arg(m_session).arg(m_sweeps).arg(m_soakTimeouts)
+        .arg(rss / 1024).arg(m_soakRssStart / 1024));
+    Log(FormatSoakWindow("last 1 min", m_series.getWindow(Series_Level_t::Second, now, 60)));
+    Log(FormatSoakWindow("last 1 h", m_series.getWindow(Series_Level_t::TenSeconds, now, 360)));
+    Log(FormatSoakWindow("total", m_series.getTotal(now)));
 }
 
-QByteArray MainWindow::Protocol_Wrap(QByteArray dataBuffer)
+void MainWindow::startBerMode(Prbs_t type)
 {
-    QByteArray data;
-    quint32 crc;
-    crc = crc32(dataBuffer.data(), dataBuffer.size());
-    data.reserve(dataBuffer.size() + PROTOCOL_OVERHEAD);
-    data.append((char)0x00);
-    data.append((dataBuffer.size() >> 8) & 0xFF);
-    data.append(dataBuffer.size() & 0xFF);
-    data.append(dataBuffer);
-    data.append((crc >> 24) & 0xFF);
-    data.append((crc >> 16) & 0xFF);
-    data.append((crc >> 8) & 0xFF);
-    data.append((crc) & 0xFF);
-    //qDebug() << "Protocol : Wrap -" << QString(data.toHex());
-    m_data_size += data.size();
-    return data;
+    m_berMode = true;
+    m_prbsType = type;
+    m_prbs.Reset(type);
+    Log(QString("BER mode %1, %2 kernels").arg(QLatin1String(PrbsGenerator::Name(type))).arg(QLatin1String(simd::Name())));
 }
 
-QByteArray MainWindow::Protocol_Unwrap(QByteArray dataBuffer)
+void MainWindow::startLinkEmulation(const LinkProfile &profile)
 {
-    QByteArray data;
-    quint16 length;
-    quint32 crc, crcp;
-    char *b = dataBuffer.data();
-    //qDebug() << "Protocol : Unwrap -" << QString(dataBuffer.toHex());
-    m_data_size += dataBuffer.size();
+    m_link->Configure(profile);
+    Log("Link emulation " + profile.toString());
+}
 
-    if(PROTOCOL_OVERHEAD < dataBuffer.size())
+void MainWindow::onLinkDelivered(Link_Direction_t direction, const QByteArray &data)
+{
+    if(Link_Direction_t::TX == direction)
     {
-        if(0x00 == b[0])
+        if(!Write(m_linkChannel, data))
         {
-            length = qFromBigEndian<quint16>((uchar *)&b[1]);
+            Log("Send failed", Log_Level_t::Error);
+            m_metrics.SendError();
+        }
 
-            if(length)
+        return;
+    }
+
+    m_linkRxNs = monotonicNs();
+    m_linkRxBuffer.write(data.constData(), data.size());
+    Receive(m_linkChannel, m_linkRxBuffer);
+}
+
+void MainWindow::startBenchmark(int runs, int warmup, const QString &baseline, const QString &saveBaseline)
+{
+    m_benchmark.Start(runs, warmup);
+    m_baseline = baseline;
+    m_saveBaseline = saveBaseline;
+    Log(QString("Benchmark of %1 runs after %2 warm-up").arg(runs).arg(warmup));
+}
+
+void MainWindow::BenchmarkRunDone(bool timedOut)
+{
+    QString label = QString(m_benchmark.isWarmup() ? "warm-up %1" : "run %1").arg(m_benchmark.getRun() + 1);
+    QString report;
+    RunSummary run = Summarize(label);
+    Baseline_Result_t result = Baseline_Result_t::Passed;
+    run.timedOut = timedOut;
+
+    if(!m_benchmark.AddRun(run))
+    {
+        Log(QString("Benchmark %1 %2").arg(label).arg(QLatin1String(timedOut ? "timed out" : "done")));
+        return;
+    }
+
+    Log("Benchmark results\n" + m_benchmark.Report());
+
+    if(!m_baseline.isEmpty())
+    {
+        result = m_benchmark.CompareBaseline(m_baseline, report);
+        Log("Baseline comparison\n" + report, Baseline_Result_t::Invalid == result ? Log_Level_t::Error : Log_Level_t::Info);
+    }
+    else if(0 == m_benchmark.getCompleted())
+    {
+        Log("Benchmark without a completed run", Log_Level_t::Error);
+        result = Baseline_Result_t::Invalid;
+    }
+
+    if(!m_saveBaseline.isEmpty() && m_benchmark.SaveBaseline(m_saveBaseline))
+    {
+        Log("Baseline saved to " + m_saveBaseline);
+    }
+
+    emit benchmarkFinished(result);
+}
+
+void MainWindow::onReplayDataReceived()
+{
+    Receive(Channel_t::Replay, m_replayPort->Read());
+}
+
+void MainWindow::onReplayFinished()
+{
+    if(m_allocCheck && m_testStarted)
+    {
+        // The capture ended mid session, PrintResults did not count it
+        CountAllocations();
+    }
+
+    m_timer_test.stop();
+    m_replayPort->Close();
+    emit replayFinished(0 == m_replayPort->getMismatchCount());
+}
+
+//---------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------
+
+void MainWindow::PrintResults()
+{
+    Log(QString("Duration : %1 ms").arg(m_testFinishAt - m_testStartAt));
+    Log(QString("Communication time : %1 ms").arg(m_testElapsedTime));
+    Log(QString("Transferred data size %1 bytes").arg(m_data_size));
+
+    if(m_testElapsedTime)
+    {
+        Log(QString("Data rate %1 KBps").arg(m_data_size / m_testElapsedTime));
+    }
+
+    if(m_latency.count())
+    {
+        Log(QString("Round trip p50 %1 us, p90 %2 us, p99 %3 us, max %4 us")
+            .arg(m_latency.Percentile(0.5), 0, 'f', 1).arg(m_latency.Percentile(0.9), 0, 'f', 1)
+            .arg(m_latency.Percentile(0.99), 0, 'f', 1).arg(m_latency.Max(), 0, 'f', 1));
+    }
+
+    if(m_stages.count())
+    {
+        Log("Round trip stages\n" + m_stages.Report());
+    }
+
+    Log(QString("Frame pool growth %1 in %2 uses").arg(m_framePool.getAllocations()).arg(m_framePool.getAcquired()));
+
+    if(m_allocCheck)
+    {
+        CountAllocations();
+    }
+    RingBuffer &rxBuffer = RxBuffer(m_testChannel);
+    Log(QString("RX buffer high water %1 / %2 bytes, %3 wrap-arounds, %4 bytes dropped")
+        .arg(rxBuffer.highWaterMark()).arg(rxBuffer.capacity()).arg(rxBuffer.wrapArounds()).arg(rxBuffer.overflows()));
+
+    if(m_link->isActive())
+    {
+        Log(m_link->Statistics());
+    }
+
+    if(m_batcher.isEnabled())
+    {
+        Log(m_batcher.Report());
+    }
+
+    if(m_berMode)
+    {
+        Log(QString("%1 %2").arg(QLatin1String(PrbsGenerator::Name(m_prbsType))).arg(m_ber.Report()));
+    }
+
+    if(m_resyncLatency.count() || m_resyncSkipped)
+    {
+        Log(QString("Resync : %1 recoveries, %2 bytes skipped, recovery p50 %3 us, max %4 us")
+            .arg(m_resyncLatency.count()).arg(m_resyncSkipped)
+            .arg(m_resyncLatency.Percentile(0.5), 0, 'f', 1).arg(m_resyncLatency.Max(), 0, 'f', 1));
+    }
+
+    if(Framing_t::None != m_framing && m_framingFrameBytes)
+    {
+        Log(QString("Framing %1 : %2 frame bytes took %3 wire bytes, overhead %4 %, %5 malformed blocks")
+            .arg(QLatin1String(ByteStuffing::Name(m_framing))).arg(m_framingFrameBytes).arg(m_framingWireBytes)
+            .arg(100.0 * (m_framingWireBytes - m_framingFrameBytes) / m_framingFrameBytes, 0, 'f', 2).arg(m_framingErrors));
+    }
+
+    if(m_extHeader)
+    {
+        Log(m_clock.Report());
+        Log(QString("Sequence errors %1").arg(m_seqErrors));
+    }
+
+    if(m_transfer.isOpen())
+    {
+        Log(m_transfer.Report());
+    }
+
+    if(m_planResults.size())
+    {
+        Log("Test plan " + m_plan.getName() + "\n" + TestPlan::FormatResults(m_planResults));
+
+        if(!m_planResultPath.isEmpty() && !TestPlan::SaveResults(m_planResultPath, m_plan.getName(), m_planResults))
+        {
+            Log("Unable to write plan results to " + m_planResultPath, Log_Level_t::Error);
+        }
+    }
+
+    // Queued to the writer thread, the file is unbuffered so the run is on disk once that thread has written it
+    m_capture->Flush();
+}
+
+RunSummary MainWindow::Summarize(const QString &label)
+{
+    RunSummary run;
+    run.label = label;
+    run.frames = m_rxCount;
+    run.errors = m_errorCount;
+    run.throughput = m_testElapsedTime ? (double)m_data_size / m_testElapsedTime : 0;
+    run.p50 = m_latency.Percentile(0.5);
+    run.p90 = m_latency.Percentile(0.9);
+    run.p99 = m_latency.Percentile(0.99);
+    run.max = m_latency.Max();
+    return run;
+}
+
+void MainWindow::SessionDone(bool timedOut)
+{
+    if(m_benchmark.isActive())
+    {
+        BenchmarkRunDone(timedOut);
+    }
+
+    if(m_tune.isActive())
+    {
+        TuneSessionDone();
+    }
+
+    if(m_compareProfiles.isEmpty())
+    {
+        return;
+    }
+
+    m_compareResults.append(Summarize(GetSocketProfile(m_compareProfiles[m_compareRun]).name));
+    m_compareRun++;
+
+    if(m_compareRun < m_compareProfiles.size())
+    {
+        // The device starts the next session, it runs under the next profile
+        m_tcpServer->setSocketProfile(m_compareProfiles[m_compareRun]);
+        return;
+    }
+
+    Log("Profile comparison\n" + FormatComparison(m_compareResults));
+    m_compareRun = 0;
+    m_compareResults.clear();
+    m_tcpServer->setSocketProfile(m_compareProfiles[0]);
+    emit comparisonFinished();
+}
+
+void MainWindow::onTimeoutTest()
+{
+    qint64 now = monotonicNs();
+
+    if(now < m_testDeadline)
+    {
+        // A frame sent since the timer was started pushed the deadline out
+        m_timer_test.start(static_cast<int>((m_testDeadline - now + 999999) / 1000000));
+        return;
+    }
+
+    int lost = m_inFlightCount;
+    m_timer_test.stop();
+    m_timer_pace.stop();
+
+    while(m_inFlightCount)
+    {
+        FrameDone(m_testChannel, Frame_Status_t::Timeout);
+    }
+
+    // Whatever is still being skipped belongs to this session
+    m_resyncAt = 0;
+    m_resyncPending = 0;
+
+    if(m_testStarted && m_soak)
+    {
+        // A burn-in rides through, the lost frames count as errors of the current window
+        for(int i = 0; i < lost; i++)
+        {
+            Inc_Error();
+        }
+
+        m_soakTimeouts++;
+        Log(QString("Timeout, %1 frames lost, soak goes on").arg(lost), Log_Level_t::Warning);
+        SendWindow(m_testChannel);
+        return;
+    }
+
+    if(m_testStarted)
+    {
+        PhaseDone(true);
+
+        // A trial that stalls only fails itself, the search goes on
+        if(m_tune.isActive() && TuneTrialDone())
+        {
+            SendWindow(m_testChannel);
+            return;
+        }
+    }
+
+    SetTestStarted(false);
+    m_testFinishAt = QDateTime::currentMSecsSinceEpoch();
+    ui->test_status->setText("Test timed out");
+    Log("Timeout", Log_Level_t::Error);
+    PrintResults();
+    SetMoodIcon(Icon_t::TestFailed);
+    SessionDone(true);
+}
+
+bool MainWindow::Send(Channel_t channel, const QByteArray &dataBuffer)
+{
+    TRACE_SCOPE("Send");
+    bool ret = false;
+    QByteArray *frame = m_framePool.Acquire();
+    m_frame.session = m_session;
+    m_frame.index = m_testIndex;
+    m_frame.payloadSize = dataBuffer.size();
+    m_frame.txEnqueue = monotonicNs();
+    Protocol_Wrap(dataBuffer, *frame);
+
+    if(Framing_t::None != m_framing)
+    {
+        // From here on frame holds the stuffed bytes that go on the wire
+        QByteArray *wrapped = frame;
+        frame = m_framePool.Acquire();
+        frame->resize(ByteStuffing::MaxEncodedSize(m_framing, wrapped->size()));
+        frame->resize(ByteStuffing::Encode(m_framing, (const uchar *)wrapped->constData(), wrapped->size(), (uchar *)frame->data()));
+        m_framingFrameBytes += wrapped->size();
+        m_framingWireBytes += frame->size();
+        m_framePool.Release(wrapped);
+    }
+
+    if(m_link->isActive())
+    {
+        // Written to the transport when the emulated link delivers it
+        m_linkChannel = channel;
+        m_link->Push(Link_Direction_t::TX, frame->constData(), frame->size());
+        ret = true;
+    }
+    else
+    {
+        ret = Write(channel, *frame);
+    }
+
+    if(ret)
+    {
+        InFlightFrame &sent = m_inFlight[(m_inFlightHead + m_inFlightCount) % m_inFlight.size()];
+        sent.index = m_frame.index;
+        sent.size = m_frame.payloadSize;
+        sent.seq = m_txSeq;
+        sent.txEnqueue = m_frame.txEnqueue;
+        // A frame held in the TX batch is stamped by FlushBatch, when it is really written
+        sent.txWritten = (m_link->isActive() || m_batcher.isEmpty()) ? monotonicNs() : 0;
+        // The write behind the link emulator is not the frame's own, its completion is not taken
+        sent.txWrite = (m_link->isActive() || !sent.txWritten) ? 0 : m_writes;
+        sent.txComplete = (sent.txWrite && m_writeDone == sent.txWrite) ? m_writeDoneNs : 0;
+        sent.wireBytes = frame->size();
+        m_inFlightCount++;
+
+        if(m_transfer.isOpen())
+        {
+            m_transfer.Sent(dataBuffer.size(), frame->size());
+        }
+
+        m_metrics.TX(frame->size());
+        m_metrics.setInFlight(m_inFlightCount);
+        m_metrics.setTxBufferLevel(BytesToWrite(channel));
+    }
+    else
+    {
+        m_metrics.SendError();
+    }
+
+    m_framePool.Release(frame);
+    return ret;
+}
+
+bool MainWindow::Write(Channel_t channel, const QByteArray &frame)
+{
+    // Replay matches every write against a recorded frame, it is never batched
+    if(!m_batcher.isEnabled() || Channel_t::Replay == channel)
+    {
+        return WritePort(channel, frame);
+    }
+
+    if(!m_batcher.Fits(frame.size()) && !FlushBatch())
+    {
+        return false;
+    }
+
+    m_batchChannel = channel;
+    m_batcher.Append(frame);
+
+    if(m_batcher.isFull())
+    {
+        // The frame is part of the batch now, a failed write is counted for all of them by FlushBatch
+        FlushBatch();
+    }
+    else if(!m_timer_batch.isActive())
+    {
+        // Without a linger the batch goes out once the current send burst is over
+        m_timer_batch.start(static_cast<int>((m_batcher.getPolicy().linger + 999) / 1000));
+    }
+
+    return true;
+}
+
+bool MainWindow::FlushBatch()
+{
+    bool ret;
+
+    m_timer_batch.stop();
+
+    if(m_batcher.isEmpty())
+    {
+        return true;
+    }
+
+    int frames = m_batcher.getFrames();
+    qint64 now;
+    ret = WritePort(m_batchChannel, m_batcher.getBatch());
+    now = monotonicNs();
+    m_batcher.Written(ret);
+
+    // The frames of the batch still waiting for their stamp are the newest in flight
+    for(int i = m_inFlightCount - 1; 0 <= i; i--)
+    {
+        InFlightFrame &sent = m_inFlight[(m_inFlightHead + i) % m_inFlight.size()];
+
+        if(sent.txWritten)
+        {
+            break;
+        }
+
+        sent.txWritten = now;
+        sent.txWrite = m_writes;
+        sent.txComplete = (m_writeDone == m_writes) ? m_writeDoneNs : 0;
+    }
+
+    if(!ret)
+    {
+        Log(QString("Batch write failed, %1 frames lost").arg(frames), Log_Level_t::Error);
+
+        for(int i = 0; i < frames; i++)
+        {
+            Inc_Error();
+            m_metrics.SendError();
+        }
+    }
+
+    return ret;
+}
+
+void MainWindow::onTimeoutBatch()
+{
+    FlushBatch();
+}
+
+void MainWindow::onTxDone(qint64 ns)
+{
+    // A transport waits for the previous write before the next one, so a completion is always the latest write's
+    m_writeDone = m_writes;
+    m_writeDoneNs = ns;
+
+    for(int i = 0; i < m_inFlightCount; i++)
+    {
+        InFlightFrame &sent = m_inFlight[(m_inFlightHead + i) % m_inFlight.size()];
+
+        if(m_writeDone == sent.txWrite)
+        {
+            sent.txComplete = ns;
+        }
+    }
+}
+
+bool MainWindow::WritePort(Channel_t channel, const QByteArray &frame)
+{
+    AllocPause allocPause;  // Buffers of the Qt devices are not the engine's
+    bool ret = false;
+
+    // Numbered first, replay completes the write before it returns
+    m_writes++;
+
+    switch(channel)
+    {
+        case Channel_t::Serial:
+            ret = m_serialPort->Write(frame);
+            break;
+
+        case Channel_t::TCP:
+            ret = m_tcpServer->Write(frame);
+            break;
+
+        case Channel_t::Replay:
+            ret = m_replayPort->Write(frame);
+            break;
+
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+qint64 MainWindow::PacketTimeout(Channel_t channel, qint32 size)
+{
+    qint64 timeout = ByteStuffing::MaxEncodedSize(m_framing, PROTOCOL_OVERHEAD + (m_extHeader ? EXT_HEADER_SIZE : 0) + size);
+
+    switch(channel)
+    {
+        case Channel_t::Serial:
+            timeout = m_serialPort->getBaudTimeout(timeout);
+            break;
+
+        case Channel_t::TCP:
+            timeout = m_tcpServer->getTimeout(timeout);
+            break;
+
+        case Channel_t::Replay:
+            timeout = m_replayPort->getTimeout(timeout);
+            break;
+
+        default:
+            break;
+    }
+
+    timeout += m_plan.phase(m_phase).frameTimeout;
+
+    if(m_batcher.isEnabled())
+    {
+        timeout += (m_batcher.getPolicy().linger + 999) / 1000;
+    }
+
+    return timeout;
+}
+
+qint64 MainWindow::BytesToWrite(Channel_t channel)
+{
+    switch(channel)
+    {
+        case Channel_t::Serial:
+            return m_serialPort->getBytesToWrite();
+
+        case Channel_t::TCP:
+            return m_tcpServer->getBytesToWrite();
+
+        default:
+            return 0;
+    }
+}
+
+qint64 MainWindow::ElapsedTime(Channel_t channel)
+{
+    qint64 time = 0;
+
+    switch(channel)
+    {
+        case Channel_t::Serial:
+            time = m_serialPort->getReceivedTime() - m_serialPort->getSentTime();
+            break;
+
+        case Channel_t::TCP:
+            time = m_tcpServer->getReceivedTime() - m_tcpServer->getSentTime();
+            break;
+
+        case Channel_t::Replay:
+            time = m_replayPort->getReceivedTime() - m_replayPort->getSentTime();
+            break;
+
+        default:
+            break;
+    }
+
+    return time;
+}
+
+void MainWindow::FrameDone(Channel_t channel, Frame_Status_t status)
+{
+    // Completes the round trip of the oldest frame in flight, if there is one
+    if(0 == m_inFlightCount)
+    {
+        return;
+    }
+
+    InFlightFrame sent = m_inFlight[m_inFlightHead];
+    m_inFlightHead = (m_inFlightHead + 1) % m_inFlight.size();
+    m_inFlightCount--;
+    m_frame.index = sent.index;
+    m_frame.payloadSize = sent.size;
+    m_frame.txEnqueue = sent.txEnqueue;
+
+    if(m_expectedHead < m_expected.size())
+    {
+        // Its payload copy is at the head, the next frame's follows
+        m_expectedHead += qMin<int>(sent.size, m_expected.size() - m_expectedHead);
+
+        if(m_expectedHead == m_expected.size())
+        {
+            m_expected.resize(0);
+            m_expectedHead = 0;
+        }
+    }
+
+    if(m_transfer.isOpen())
+    {
+        m_transfer.Completed(Frame_Status_t::OK == status);
+    }
+
+    // Write completion is the frame's own, RX stamps are of the burst the echo completed in
+    m_frame.txComplete = sent.txComplete;
+
+    switch(channel)
+    {
+        case Channel_t::Serial:
+            m_frame.rxFirst = m_serialPort->getRxFirstNs();
+            m_frame.rxComplete = m_serialPort->getRxLastNs();
+            break;
+
+        case Channel_t::TCP:
+            m_frame.rxFirst = m_tcpServer->getRxFirstNs();
+            m_frame.rxComplete = m_tcpServer->getRxLastNs();
+            break;
+
+        case Channel_t::Replay:
+            m_frame.rxFirst = m_replayPort->getRxFirstNs();
+            m_frame.rxComplete = m_replayPort->getRxLastNs();
+            break;
+
+        default:
+            break;
+    }
+
+    if(m_link->isActive())
+    {
+        // The engine sees the burst when the emulated link hands it over
+        m_frame.rxFirst = m_linkRxNs;
+        m_frame.rxComplete = m_linkRxNs;
+    }
+
+    if(m_frame.txComplete < m_frame.txEnqueue)
+    {
+        m_frame.txComplete = 0;
+    }
+
+    if(Frame_Status_t::Timeout == status || m_frame.rxComplete < m_frame.txEnqueue)
+    {
+        m_frame.rxFirst = 0;
+        m_frame.rxComplete = 0;
+    }
+    else
+    {
+        // An echo that began inside the burst of an earlier one has no first byte time of its own
+        bool shared = m_frame.rxFirst == m_rxBurstNs || m_frame.rxFirst < sent.txWritten;
+        m_rxBurstNs = m_frame.rxFirst;
+
+        if(shared)
+        {
+            m_frame.rxFirst = 0;
+        }
+    }
+
+    m_frame.status = status;
+    m_metrics.setInFlight(m_inFlightCount);
+
+    if(Frame_Status_t::OK != status)
+    {
+        m_metrics.Error(status);
+    }
+
+    if(m_frame.rxComplete)
+    {
+        m_metrics.Latency(m_frame.rxComplete - m_frame.txEnqueue);
+        m_latency.Add(m_frame.rxComplete - m_frame.txEnqueue);
+        m_phaseLatency.Add(m_frame.rxComplete - m_frame.txEnqueue);
+        StageStamps stamps = { m_frame.txEnqueue, sent.txWritten, m_frame.txComplete, m_frame.rxFirst, m_frame.rxComplete, monotonicNs() };
+        m_stages.Add(stamps, sent.wireBytes);
+
+        if(Frame_Status_t::OK == status && m_rxExt && m_rxSeq == sent.seq)
+        {
+            m_clock.Add(m_frame.txEnqueue, m_rxTs, m_frame.rxComplete);
+        }
+    }
+
+    m_series.AddFrame(monotonicNs(), m_frame.rxComplete ? m_frame.rxComplete - m_frame.txEnqueue : 0, Frame_Status_t::OK != status);
+
+    m_frameTrace.Append(m_frame);
+    m_frame.txEnqueue = 0;
+}
+
+void MainWindow::SetTestStarted(bool value)
+{
+    m_testStarted = value;
+    m_testIndex = 0;
+    m_testStep = Test_Step_t::step_Idle;
+}
+
+QMovie *MainWindow::MoodMovie(Icon_t icon, const char *file)
+{
+    QMovie *&cached = m_moods[static_cast<int>(icon)];
+
+    // Decoded on first use only, later state changes just swap the pointer
+    if(nullptr == cached)
+    {
+        cached = new QMovie(file, QByteArray(), this);
+        cached->setCacheMode(QMovie::CacheAll);
+    }
+
+    return cached;
+}
+
+void MainWindow::SetMoodIcon(Icon_t icon)
+{
+    if(Icon_t::Connecting == icon)
+    {
+        ui->test_status->setText("Waiting for a connection");
+    }
+
+    // Nothing is drawn without a display, the resources are never loaded
+    if(m_headless)
+    {
+        return;
+    }
+
+    if(movie)
+    {
+        movie->stop();
+        movie = nullptr;
+    }
+
+    switch(icon)
+    {
+        case Icon_t::Disconnected:
+            if(m_moodDisconnected.isNull())
+            {
+                m_moodDisconnected = QPixmap(MOOD_DISCONNECTED);
+            }
+
+            ui->moodicon->setPixmap(m_moodDisconnected);
+            return;
+
+        case Icon_t::Connecting:
+            movie = MoodMovie(icon, MOOD_CONNECTING);
+            break;
+
+        case Icon_t::Testing:
+            movie = MoodMovie(icon, MOOD_TESTING);
+            break;
+
+        case Icon_t::TestSuccess:
+            movie = MoodMovie(icon, MOOD_RESULT_SUCCESS);
+            break;
+
+        case Icon_t::TestFailed:
+            movie = MoodMovie(icon, MOOD_RESULT_FAIL);
+            break;
+    }
+
+    ui->moodicon->setMovie(movie);
+    movie->start();
+}
+
+bool MainWindow::isHeadless()
+{
+    QString platform = QGuiApplication::platformName();
+    return "offscreen" == platform || "minimal" == platform;
+}
+
+void MainWindow::setStartupTime(qint64 ns)
+{
+    Log(QString("Startup %1 ms").arg(ns / 1e6, 0, 'f', 1));
+    m_benchmark.setStartupTime(ns / 1e6);
+}
+
+void MainWindow::Clean_Counters()
+{
+    m_rxCount = 0;
+    m_txCount = 0;
+    m_errorCount = 0;
+    m_rxProgressAt = 0;
+    m_txProgressAt = 0;
+    m_data_size = 0;
+    m_testElapsedTime = 0;
+    UpdateCounters();
+}
+
+void MainWindow::Inc_Error()
+{
+    m_errorCount++;
+}
+
+void MainWindow::Inc_RX()
+{
+    m_rxCount++;
+}
+
+void MainWindow::Inc_TX()
+{
+    m_txCount++;
+}
+
+void MainWindow::UpdateCounters()
+{
+    ui->rx_count->display(static_cast<int>(m_rxCount));
+    ui->rx_progress->setValue(static_cast<int>(qMin<qint64>(m_rxCount - m_rxProgressAt, ui->rx_progress->maximum())));
+    ui->tx_count->display(static_cast<int>(m_txCount));
+    ui->tx_progress->setValue(static_cast<int>(qMin<qint64>(m_txCount - m_txProgressAt, ui->tx_progress->maximum())));
+    ui->error_count->display(static_cast<int>(m_errorCount));
+    ui->error_progress->setValue(static_cast<int>(qMin<qint64>(m_errorCount, ui->error_progress->maximum())));
+
+    if(m_data_size)
+    {
+        ui->test_data_size->setText(QString("%1 KB").arg(m_data_size / 1024));
+    }
+    else
+    {
+        ui->test_data_size->clear();
+    }
+}
+
+void MainWindow::ArmFrameTimeout(qint64 ms)
+{
+    m_testDeadline = monotonicNs() + ms * 1000000;
+
+    // Restarting a QTimer allocates, a running one is left to find the new deadline
+    if(!m_timer_test.isActive() || ms < m_timer_test.remainingTime())
+    {
+        m_timer_test.start(static_cast<int>(ms));
+    }
+}
+
+void MainWindow::CountAllocations()
+{
+    qint64 frames = m_rxCount - ALLOC_WARMUP_FRAMES;
+
+    if(0 < frames)
+    {
+        m_allocations = AllocScope::Count() - m_allocAt;
+        Log(QString("Heap allocations in the frame path : %1 in %2 frames after %3 warm-up")
+            .arg(m_allocations).arg(frames).arg(ALLOC_WARMUP_FRAMES), m_allocations ? Log_Level_t::Error : Log_Level_t::Info);
+    }
+    else
+    {
+        Log(QString("Heap allocations in the frame path : not counted, %1 frames are needed for the warm-up").arg(ALLOC_WARMUP_FRAMES), Log_Level_t::Error);
+    }
+}
+
+RingBuffer &MainWindow::RxBuffer(Channel_t channel)
+{
+    switch(channel)
+    {
+        case Channel_t::Serial:
+            return m_serialPort->getRxBuffer();
+
+        case Channel_t::Replay:
+            return m_replayPort->getRxBuffer();
+
+        case Channel_t::TCP:
+        default:
+            return m_tcpServer->getRxBuffer();
+    }
+}
+
+void MainWindow::Receive(Channel_t channel, RingBuffer &rxBuffer)
+{
+    TRACE_SCOPE("Receive");
+    // Past the warm-up the frame path is expected not to allocate, --alloc-check counts what it does
+    AllocScope allocScope(m_allocCheck && m_testStarted && ALLOC_WARMUP_FRAMES <= m_rxCount);
+    QByteArray *linear = nullptr;
+    qint64 size = rxBuffer.size();
+    const char *frame = rxBuffer.contiguous(0, size);
+
+    if(m_link->isActive() && &rxBuffer != &m_linkRxBuffer)
+    {
+        // The burst crosses the emulated link first and comes back through onLinkDelivered
+        linear = m_framePool.Acquire();
+        linear->resize(size);
+        rxBuffer.copy(linear->data(), 0, size);
+        m_linkChannel = channel;
+        m_link->Push(Link_Direction_t::RX, linear->constData(), size);
+        rxBuffer.consume(size);
+        m_framePool.Release(linear);
+        return;
+    }
+
+    if(Framing_t::None != m_framing)
+    {
+        Deframe(channel, rxBuffer);
+        return;
+    }
+
+    m_metrics.setRxBufferLevel(size);
+
+    // Fast path, the burst is one frame as delimited by the RX idle gap
+    if(0 == m_resyncAt && FrameSize(rxBuffer, 0) == size)
+    {
+        // Decode in place, only a frame that wraps around the ring end is copied
+        if(nullptr == frame)
+        {
+            linear = m_framePool.Acquire();
+            linear->resize(size);
+            rxBuffer.copy(linear->data(), 0, size);
+            frame = linear->constData();
+        }
+
+        Test(channel, frame, size);
+        rxBuffer.consume(size);
+
+        if(linear)
+        {
+            m_framePool.Release(linear);
+        }
+
+        return;
+    }
+
+    rxBuffer.consume(Resync(channel, rxBuffer));
+}
+
+qint64 MainWindow::FrameSize(const RingBuffer &rxBuffer, qint64 offset)
+{
+    qint64 remain = rxBuffer.size() - offset;
+    uchar header;
+    int length;
+
+    if(remain < 1)
+    {
+        return 0;
+    }
+
+    header = rxBuffer.at(offset);
+
+    if(HEADER_CLASSIC != header && !(m_extHeader && HEADER_EXTENDED == (char)header))
+    {
+        return -1;
+    }
+
+    if(remain < 3)
+    {
+        return 0;
+    }
+
+    length = (rxBuffer.at(offset + 1) << 8) | rxBuffer.at(offset + 2);
+
+    if(0 == length || m_maxPayload < length)
+    {
+        return -1;
+    }
+
+    return PROTOCOL_OVERHEAD + (HEADER_EXTENDED == (char)header ? EXT_HEADER_SIZE : 0) + length;
+}
+
+bool MainWindow::FrameValid(const RingBuffer &rxBuffer, qint64 offset, qint64 total)
+{
+    QByteArray *linear = nullptr;
+    const char *b = rxBuffer.contiguous(offset, total);
+    bool valid;
+
+    if(nullptr == b)
+    {
+        linear = m_framePool.Acquire();
+        linear->resize(total);
+        rxBuffer.copy(linear->data(), offset, total);
+        b = linear->constData();
+    }
+
+    valid = ProtocolCrc32(&b[3], total - PROTOCOL_OVERHEAD) == qFromBigEndian<quint32>((const uchar *)&b[total - 4]);
+
+    if(linear)
+    {
+        m_framePool.Release(linear);
+    }
+
+    return valid;
+}
+
+qint64 MainWindow::NextFrame(const RingBuffer &rxBuffer, qint64 from, qint64 &partial)
+{
+    qint64 size = rxBuffer.size();
+    partial = -1;
+
+    while(from < size)
+    {
+        // The header byte is the only fixed byte of a frame, memchr style scans find the candidates
+        qint64 candidate = rxBuffer.indexOf(HEADER_CLASSIC, from);
+
+        if(m_extHeader)
+        {
+            qint64 extended = rxBuffer.indexOf(HEADER_EXTENDED, from);
+
+            if(0 <= extended && (candidate < 0 || extended < candidate))
+            {
+                candidate = extended;
+            }
+        }
+
+        if(candidate < 0)
+        {
+            break;
+        }
+
+        qint64 total = FrameSize(rxBuffer, candidate);
+
+        if(0 < total && candidate + total <= size && FrameValid(rxBuffer, candidate, total))
+        {
+            return candidate;
+        }
+
+        if(partial < 0 && 0 <= total && candidate + total > size)
+        {
+            // Could be the head of a frame whose rest is still on the way
+            partial = candidate;
+        }
+
+        from = candidate + 1;
+    }
+
+    return -1;
+}
+
+qint64 MainWindow::Resync(Channel_t channel, RingBuffer &rxBuffer)
+{
+    TRACE_SCOPE("Resync");
+    qint64 offset = 0;
+
+    while(offset < rxBuffer.size())
+    {
+        qint64 remain = rxBuffer.size() - offset;
+        qint64 total = FrameSize(rxBuffer, offset);
+
+        // A burst that is exactly one frame goes to Protocol_Unwrap as before, unless in a resync
+        if((0 == m_resyncAt && total == remain) || (0 < total && total <= remain && FrameValid(rxBuffer, offset, total)))
+        {
+            QByteArray *linear = nullptr;
+            const char *frame = rxBuffer.contiguous(offset, total);
+
+            if(m_resyncAt)
+            {
+                qint64 ns = monotonicNs() - m_resyncAt;
+                Log(QString("Protocol : Resynchronised after %1 bytes, %2 us").arg(m_resyncPending).arg(ns / 1000.0, 0, 'f', 1));
+                m_metrics.Resync(m_resyncPending, ns);
+                m_resyncLatency.Add(ns);
+                m_resyncAt = 0;
+                m_resyncPending = 0;
+            }
+
+            if(nullptr == frame)
+            {
+                linear = m_framePool.Acquire();
+                linear->resize(total);
+                rxBuffer.copy(linear->data(), offset, total);
+                frame = linear->constData();
+            }
+
+            Test(channel, frame, total);
+            offset += total;
+
+            if(linear)
+            {
+                m_framePool.Release(linear);
+            }
+
+            continue;
+        }
+
+        qint64 partial;
+        qint64 next = NextFrame(rxBuffer, offset + 1, partial);
+
+        if(next < 0 && (0 == total || remain < total))
+        {
+            // Incomplete frame and nothing better behind it, the rest comes with the next burst
+            break;
+        }
+
+        if(0 == m_resyncAt)
+        {
+            // One error per glitch, however many bytes it takes to get back in step
+            Frame_Status_t status = (total < 0) ? Frame_Status_t::Header :
+                                    (remain < total) ? Frame_Status_t::Length : Frame_Status_t::CRC;
+            Log(QString("Protocol : Bad frame (%1), scanning for the next header").arg(QLatin1String(FrameTrace::StatusName(status))), Log_Level_t::Error);
+            Inc_Error();
+            FrameDone(channel, status);
+            m_resyncAt = monotonicNs();
+        }
+
+        qint64 skip = ((0 <= next) ? next : (0 <= partial) ? partial : rxBuffer.size()) - offset;
+        m_resyncSkipped += skip;
+        m_resyncPending += skip;
+        offset += skip;
+    }
+
+    return offset;
+}
+
+void MainWindow::Deframe(Channel_t channel, RingBuffer &rxBuffer)
+{
+    TRACE_SCOPE("Deframe");
+    uchar delimiter = ByteStuffing::Delimiter(m_framing);
+    qint64 start = 0, end;
+
+    m_metrics.setRxBufferLevel(rxBuffer.size());
+
+    // Every delimiter closes a block, a corrupted block costs that block only
+    while(0 <= (end = rxBuffer.indexOf(delimiter, start)))
+    {
+        qint64 size = end - start;
+        m_framingWireBytes += size + 1;
+
+        if(0 < size && size <= m_frameBufferSize)
+        {
+            QByteArray *linear = nullptr;
+            QByteArray *frame = m_framePool.Acquire();
+            const char *block = rxBuffer.contiguous(start, size);
+            qint64 decoded;
+
+            if(nullptr == block)
+            {
+                linear = m_framePool.Acquire();
+                linear->resize(size);
+                rxBuffer.copy(linear->data(), start, size);
+                block = linear->constData();
+            }
+
+            frame->resize(size);
+            decoded = ByteStuffing::Decode(m_framing, (const uchar *)block, size, (uchar *)frame->data());
+
+            if(0 <= decoded)
             {
-                if(PROTOCOL_OVERHEAD + length == dataBuffer.size())
+                m_framingFrameBytes += decoded;
+                Test(channel, frame->constData(), decoded);
+            }
+            else
+            {
+                Log("Framing : Malformed block dropped", Log_Level_t::Error);
+                m_framingErrors++;
+                Inc_Error();
+                FrameDone(channel, Frame_Status_t::Header);
+            }
+
+            if(linear)
+            {
+                m_framePool.Release(linear);
+            }
+
+            m_framePool.Release(frame);
+        }
+        else if(m_frameBufferSize < size)
+        {
+            Log("Framing : Oversized block dropped", Log_Level_t::Error);
+            m_framingErrors++;
+            Inc_Error();
+        }
+
+        start = end + 1;
+    }
+
+    // A partial block stays for the next burst unless no frame can be that long
+    if(m_frameBufferSize < rxBuffer.size() - start)
+    {
+        Log("Framing : No delimiter, buffer dropped", Log_Level_t::Error);
+        m_framingErrors++;
+        Inc_Error();
+        start = rxBuffer.size();
+    }
+
+    rxBuffer.consume(start);
+}
+
+void MainWindow::Test(Channel_t channel, const char *dataBuffer, int dataBufferSize)
+{
+    TRACE_SCOPE("Test");
+    bool ret = false;
+    const char *data = nullptr;
+    int data_size = 0;
+    m_testChannel = channel;
+    Protocol_Unwrap(dataBuffer, dataBufferSize, data, data_size);
+
+    if(data_size)
+    {
+        switch(m_testStep)
+        {
+            case Test_Step_t::step_Idle:
+                if((1 == data_size || 2 == data_size) && 0x00 == data[0])
+                {
+                    // A second byte offers the extended header, replying in it accepts the offer
+                    m_extHeader = m_extAllowed && 2 == data_size && PROTOCOL_VERSION_EXT == data[1];
+                    m_txSeq = 0;
+                    m_seqErrors = 0;
+                    m_clock.Reset();
+                    m_framingFrameBytes = 0;
+                    m_framingWireBytes = 0;
+                    m_framingErrors = 0;
+                    m_resyncSkipped = 0;
+                    m_resyncLatency.Clear();
+                    Clean_Counters();
+                    SetTestStarted(true);
+                    m_session++;
+                    m_framePool.ClearCounters();
+                    m_batcher.ClearCounters();
+                    RxBuffer(channel).ClearCounters();
+                    m_latency.Clear();
+                    m_stages.Clear();
+                    // Serial frames have a wire time to take out of the flight, TCP and replay do not
+                    m_stages.setCharTime(Channel_t::Serial == channel && !m_link->isActive() ? m_serialPort->getCharTimeNs() : 0);
+
+                    m_payload->Reset();
+                    m_expected.resize(0);
+                    m_expectedHead = 0;
+                    m_allocAt = AllocScope::Count();
+                    m_allocations = -1;
+
+                    if(m_berMode)
+                    {
+                        m_prbs.Reset(m_prbsType);
+                        m_ber.Reset();
+                    }
+
+                    m_frame.txEnqueue = 0;
+                    m_inFlightHead = 0;
+                    m_inFlightCount = 0;
+                    m_planResults.clear();
+                    StartPhase(0);
+                    m_testStartAt = QDateTime::currentMSecsSinceEpoch();
+                    Log(m_extHeader ? "Started with extended header" : "Started");
+                    ui->test_status->setText("Testing...");
+                    m_testStep = Test_Step_t::step_Test;
+                    m_testIndex = 1;
+                    SetMoodIcon(Icon_t::Testing);
+                }
+                else
                 {
-                    crc = crc32(&b[3], length);
-                    crcp = qFromBigEndian<quint32>((uchar *)&b[3 + length]);
+                    Log("Wrong start request received", Log_Level_t::Error);
+                    Inc_Error();
+                    break;
+                }
 
-                    if(crc == crcp)
+                [[fallthrough]];
+
+            case Test_Step_t::step_Test:
+                if(m_testStarted && m_testIndex)
+                {
+                    // Measurement
+                    //------------------------------------------------------------
+                    if(m_inFlightCount)
                     {
-                        data = QByteArray(&b[3], length);
+                        m_testElapsedTime += ElapsedTime(channel);
                     }
-                    else
+
+                    //------------------------------------------------------------
+                    // RX
+                    //------------------------------------------------------------
+                    Inc_RX();
+
+                    if(lcFrames().isDebugEnabled())
                     {
-                        Log("Protocol : CRC mismatch");
+                        Log("RX", Log_Level_t::Debug);
+                    }
+
+                    // The start frame answers nothing, any later frame is the echo of the oldest one in flight
+                    if(m_inFlightCount)
+                    {
+                        const InFlightFrame &sent = m_inFlight[m_inFlightHead];
+                        qint32 index = sent.index;
+                        qint32 size = sent.size;
+                        qint64 mismatch = -1;
+                        const char *expected = m_expected.constData() + m_expectedHead;
+                        qint64 expectedSize = m_expected.size() - m_expectedHead;
+
+                        bool acked = m_transfer.isOpen() && m_transfer.isAck();
+
+                        if(m_extHeader && m_rxExt && m_rxSeq != sent.seq)
+                        {
+                            Log(QString("Sequence %1, expected %2").arg(m_rxSeq).arg(sent.seq), Log_Level_t::Warning);
+                            m_seqErrors++;
+                        }
+
+                        if(m_transfer.isOpen())
+                        {
+                            // Checked straight against the mapped file
+                            m_transfer.Received(dataBufferSize);
+                            mismatch = m_transfer.Verify(data, acked ? data_size : qMin(data_size, size));
+                        }
+                        else if(m_berMode && expectedSize)
+                        {
+                            m_ber.Compare((const uchar *)expected, (const uchar *)data,
+                                          qMin<qint64>(qMin(data_size, size), expectedSize), m_prbs);
+                        }
+                        else if(m_verify && expectedSize)
+                        {
+                            mismatch = simd::FirstMismatch((const uchar *)expected, (const uchar *)data,
+                                                           qMin<qint64>(qMin(data_size, size), expectedSize));
+                        }
+
+                        //------------------------------------------------------------
+
+                        // Check Index
+                        //------------------------------------------------------------
+                        m_phaseFrames++;
+
+                        if(size != data_size && !acked)
+                        {
+                            Log("Wrong Index", Log_Level_t::Error);
+                            Inc_Error();
+                            FrameDone(channel, Frame_Status_t::Length);
+                        }
+                        else if(0 <= mismatch)
+                        {
+                            Log(QString("Content mismatch at offset %1").arg(mismatch), Log_Level_t::Error);
+                            Inc_Error();
+                            FrameDone(channel, Frame_Status_t::Content);
+                        }
+                        else
+                        {
+                            m_phaseBytes += size;
+                            FrameDone(channel, Frame_Status_t::OK);
+                        }
+
+                        if(lcFrames().isDebugEnabled())
+                        {
+                            Log(QString("Index %1 / %2").arg(index).arg(data_size), Log_Level_t::Debug);
+                        }
                     }
+
+                    //------------------------------------------------------------
+                    // TX
+                    //------------------------------------------------------------
+                    SendWindow(channel);
                 }
                 else
                 {
-                    Log("Protocol : Length mismatch");
+                    Log("Wrong state", Log_Level_t::Error);
+                    Inc_Error();
+                }
+
+                break;
+
+            default:
+                Log("Wrong case", Log_Level_t::Error);
+                m_testStep = Test_Step_t::step_Idle;
+                m_testIndex = 0;
+                break;
+        }
+    }
+    else
+    {
+        Log("Not a valid packet", Log_Level_t::Error);
+        Inc_Error();
+
+        // A CRC failure is exactly what the BER mode is after, the payload is still counted
+        if(m_berMode && Frame_Status_t::CRC == m_frameStatus && m_expectedHead < m_expected.size() && m_inFlightCount)
+        {
+            int header = (m_extHeader && HEADER_EXTENDED == dataBuffer[0]) ? 3 + EXT_HEADER_SIZE : 3;
+            qint64 expected = qMin<qint64>(m_inFlight[m_inFlightHead].size, m_expected.size() - m_expectedHead);
+            m_ber.Compare((const uchar *)m_expected.constData() + m_expectedHead, (const uchar *)dataBuffer + header,
+                          qMin<qint64>(dataBufferSize - PROTOCOL_OVERHEAD - (header - 3), expected), m_prbs);
+        }
+
+        FrameDone(channel, m_frameStatus);
+    }
+}
+
+void MainWindow::StartPhase(int index)
+{
+    const PlanPhase &phase = m_plan.phase(index);
+    m_phase = index;
+    m_phaseSent = 0;
+    m_phaseStartedAt = monotonicNs();
+    m_phaseErrorsAt = m_errorCount;
+    m_phaseFrames = 0;
+    m_phaseBytes = 0;
+    m_phaseLatency.Clear();
+    m_nextSendAt = 0;
+
+    if(m_phasePayloads[index])
+    {
+        m_phasePayloads[index]->Reset();
+    }
+
+    if(m_transfer.isOpen())
+    {
+        m_transfer.Rewind();
+    }
+
+    if(1 < m_plan.count())
+    {
+        Log(QString("Phase %1 : sizes %2..%3 step %4, %5 each, window %6%7")
+            .arg(phase.name).arg(phase.sizeFrom).arg(phase.sizeTo).arg(phase.sizeStep).arg(phase.repeat).arg(phase.window)
+            .arg(0 < phase.rate ? QString(", %1 frames/s").arg(phase.rate) : QString()));
+    }
+}
+
+void MainWindow::SendWindow(Channel_t channel)
+{
+    const PlanPhase *phase = &m_plan.phase(m_phase);
+
+    while(m_testStarted)
+    {
+        if(phase->Frames() <= m_phaseSent)
+        {
+            AllocPause allocPause;  // Phase results are built once per phase, not per frame
+            bool last = m_phase + 1 == m_plan.count();
+
+            // The device stops after the last frame of the plan, its echo is not awaited
+            if(last && !m_soak && !m_tune.isActive() && !m_transfer.isOpen())
+            {
+                PhaseDone(false);
+                FinishSession();
+                return;
+            }
+
+            if(m_inFlightCount)
+            {
+                // Any other phase ends with its last echo
+                return;
+            }
+
+            PhaseDone(false);
+
+            if(m_tune.isActive())
+            {
+                if(!TuneTrialDone())
+                {
+                    FinishSession();
+                    return;
                 }
             }
+            else if(m_transfer.isOpen() && !m_soak)
+            {
+                // The transfer ends with the last echo or ack
+                FinishSession();
+                return;
+            }
+            else if(last)
+            {
+                // Soak, the plan starts over
+                SweepDone();
+                m_testIndex = 1;
+                StartPhase(0);
+            }
             else
             {
-                Log("Protocol : Zero data length");
+                StartPhase(m_phase + 1);
+            }
+
+            phase = &m_plan.phase(m_phase);
+            continue;
+        }
+
+        if(phase->window <= m_inFlightCount)
+        {
+            return;
+        }
+
+        if(0 < phase->rate)
+        {
+            qint64 now = monotonicNs();
+
+            if(now < m_nextSendAt)
+            {
+                m_timer_pace.start(static_cast<int>((m_nextSendAt - now + 999999) / 1000000));
+                return;
+            }
+
+            m_nextSendAt = qMax(now, m_nextSendAt) + static_cast<qint64>(1e9 / phase->rate);
+        }
+
+        bool ret;
+        qint32 size;
+
+        if(m_transfer.isOpen())
+        {
+            // A view on the mapped file, the only copy made is the one into the wire frame
+            size = m_transfer.FrameSize(m_phaseSent);
+            ret = Send(channel, QByteArray::fromRawData(m_transfer.FrameData(m_phaseSent), size));
+
+            if(ret)
+            {
+                // Echoes are checked against the file, a frame that failed to go out is sent again
+                m_phaseSent++;
             }
         }
         else
         {
-            Log("Protocol : Wrong header byte");
+            size = phase->SizeAt(m_phaseSent);
+            QByteArray *dataToSend = m_framePool.Acquire();
+            dataToSend->resize(size);
+            uchar *payload = (uchar *)dataToSend->data();
+
+            if(m_berMode)
+            {
+                m_prbs.Fill(payload, size);
+            }
+            else
+            {
+                PayloadGenerator *generator = m_phasePayloads[m_phase] ? m_phasePayloads[m_phase] : m_payload;
+                generator->Fill(payload, size, m_testIndex);
+            }
+
+            if(m_berMode || m_verify)
+            {
+                if(m_expectedHead && m_expected.capacity() - m_expected.size() < size)
+                {
+                    // Copies still in flight move to the front, the reserved capacity is kept
+                    int pending = m_expected.size() - m_expectedHead;
+                    memmove(m_expected.data(), m_expected.constData() + m_expectedHead, pending);
+                    m_expected.resize(pending);
+                    m_expectedHead = 0;
+                }
+
+                // The echo of this payload is checked against a copy
+                m_expected.append((const char *)payload, size);
+            }
+
+            ret = Send(channel, *dataToSend);
+            m_framePool.Release(dataToSend);
+            m_phaseSent++;
+        }
+
+        m_testIndex++;
+
+        if(!ret)
+        {
+            if(!m_transfer.isOpen() && (m_berMode || m_verify))
+            {
+                m_expected.chop(size);
+            }
+
+            Log("Send failed", Log_Level_t::Error);
+            Inc_Error();
+            return;
+        }
+
+        ArmFrameTimeout(PacketTimeout(channel, size));
+        Inc_TX();
+
+        if(lcFrames().isDebugEnabled())
+        {
+            Log("TX", Log_Level_t::Debug);
         }
     }
+}
+
+void MainWindow::onTimeoutPace()
+{
+    SendWindow(m_testChannel);
+}
+
+void MainWindow::PhaseDone(bool timedOut)
+{
+    const PlanPhase &phase = m_plan.phase(m_phase);
+    PhaseResult result;
+    result.name = phase.name;
+    result.frames = m_phaseFrames;
+    result.errors = m_errorCount - m_phaseErrorsAt;
+    result.bytes = m_phaseBytes;
+    result.seconds = (monotonicNs() - m_phaseStartedAt) / 1e9;
+    result.throughput = (0 < result.seconds) ? 2.0 * m_phaseBytes / 1024 / result.seconds : 0;
+    result.p50 = m_phaseLatency.Percentile(0.5);
+    result.p99 = m_phaseLatency.Percentile(0.99);
+    result.max = m_phaseLatency.Max();
+    TestPlan::Evaluate(phase, result);
+
+    if(timedOut)
+    {
+        result.passed = false;
+        result.failures << "Timed out";
+    }
+
+    m_planResults.append(result);
+}
+
+void MainWindow::FinishSession()
+{
+    bool passed = true;
+
+    for(const PhaseResult &result : m_planResults)
+    {
+        passed &= result.passed;
+    }
+
+    AllocPause allocPause;  // The results are formatted once per session
+    m_timer_test.stop();
+    m_timer_pace.stop();
+    SetTestStarted(false);
+    m_testFinishAt = QDateTime::currentMSecsSinceEpoch();
+    UpdateCounters();
+
+    if(0 == m_errorCount && passed)
+    {
+        Log("Finished successfully");
+        ui->test_status->setText("Test finished successfully");
+        SetMoodIcon(Icon_t::TestSuccess);
+    }
     else
     {
-        Log("Protocol : Wrong length");
+        Log(passed ? "Finished with errors" : "Finished, test plan limits not met", Log_Level_t::Warning);
+        ui->test_status->setText("Test finished with errors");
+        SetMoodIcon(Icon_t::TestFailed);
+    }
+
+    PrintResults();
+    m_testStep = Test_Step_t::step_Idle;
+    SessionDone(false);
+}
+
+bool MainWindow::TuneTrialDone()
+{
+    const PhaseResult &result = m_planResults.last();
+    Log(QString("Trial %1 at %2 : %3 KB/s, p99 %4 us, %5 errors, %6")
+        .arg(result.name).arg(0 < m_plan.phase(0).rate ? QString("%1 frames/s").arg(m_plan.phase(0).rate, 0, 'f', 0) : QString("max"))
+        .arg(result.throughput, 0, 'f', 1).arg(result.p99, 0, 'f', 1).arg(result.errors)
+        .arg(QLatin1String(result.passed ? "pass" : "fail")));
+
+    if(!m_tune.Next(result))
+    {
+        return false;
     }
 
-    return data;
+    m_plan.setPhase(0, m_tune.Phase());
+    StartPhase(0);
+    return true;
 }
 
-quint32 MainWindow::crc32(const char *data, quint16 length)
+void MainWindow::TuneSessionDone()
 {
-    qint32 i, j;
-    quint32 byte, crc, mask;
-    crc = 0xFFFFFFFF;
+    QString device;
 
-    for(i = 0; i < length; i++)
+    if(m_tune.NextBaud())
     {
-        byte = data[i];
-        crc = crc ^ byte;
+        // The device has to follow on its side and start the next session at the new rate
+        m_plan.setPhase(0, m_tune.Phase());
 
-        for(j = 7; j >= 0; j--)
+        if(m_serialPort->isOpen())
         {
-            mask = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & mask);
+            SerialPort_Configure(m_tune.getBaud());
         }
 
-        i = i + 1;
+        Log(QString("Auto-tune : waiting for the device at %1 baud").arg(m_tune.getBaud()));
+        return;
+    }
+
+    switch(m_testChannel)
+    {
+        case Channel_t::Serial:
+            device = ui->serial_port_name->currentData(PortModel::NameRole).toString();
+            break;
+
+        case Channel_t::TCP:
+            device = "TCP client " + m_tcpServer->getClientIp();
+            break;
+
+        default:
+            device = "replay";
+            break;
+    }
+
+    Log("Auto-tune\n" + m_tune.Report(device));
+    m_tune.Stop();
+    emit autoTuneFinished();
+}
+
+void MainWindow::Protocol_Wrap(const QByteArray &dataBuffer, QByteArray &data)
+{
+    TRACE_SCOPE("Protocol_Wrap");
+    quint32 crc;
+    uchar *b;
+    int length = dataBuffer.size();
+    int header = m_extHeader ? 3 + EXT_HEADER_SIZE : 3;
+    // data is a pooled buffer reserved to the largest frame, resizing does not allocate
+    data.resize(length + PROTOCOL_OVERHEAD + header - 3);
+    b = (uchar *)data.data();
+    b[0] = m_extHeader ? HEADER_EXTENDED : HEADER_CLASSIC;
+    qToBigEndian<quint16>(length, &b[1]);
+
+    if(m_extHeader)
+    {
+        qToBigEndian<quint32>(++m_txSeq, &b[3]);
+        qToBigEndian<qint64>(m_frame.txEnqueue, &b[7]);
+    }
+
+    memcpy(&b[header], dataBuffer.constData(), length);
+    // The extended fields are covered by the CRC too
+    crc = ProtocolCrc32((const char *)&b[3], header - 3 + length);
+    qToBigEndian<quint32>(crc, &b[header + length]);
+    //qDebug() << "Protocol : Wrap -" << QString(data.toHex());
+    m_data_size += data.size();
+    m_series.AddBytes(monotonicNs(), data.size());
+}
+
+bool MainWindow::Protocol_Unwrap(const char *b, int size, const char *&data, int &data_size)
+{
+    TRACE_SCOPE("Protocol_Unwrap");
+    quint16 length;
+    quint32 crc, crcp;
+    data = nullptr;
+    data_size = 0;
+    m_data_size += size;
+    m_frameStatus = Frame_Status_t::OK;
+    m_metrics.RX(size);
+    m_series.AddBytes(monotonicNs(), size);
+    m_rxExt = false;
+    // Once negotiated the device may use either header, the extended one adds seq32 | ts64
+    bool extended = m_extHeader && 0 < size && HEADER_EXTENDED == b[0];
+    int header = extended ? 3 + EXT_HEADER_SIZE : 3;
+
+    if(PROTOCOL_OVERHEAD + header - 3 < size)
+    {
+        if(HEADER_CLASSIC == b[0] || extended)
+        {
+            length = qFromBigEndian<quint16>((const uchar *)&b[1]);
+
+            if(length)
+            {
+                if(PROTOCOL_OVERHEAD + header - 3 + length == size)
+                {
+                    crc = ProtocolCrc32(&b[3], header - 3 + length);
+                    crcp = qFromBigEndian<quint32>((const uchar *)&b[header + length]);
+
+                    if(crc == crcp)
+                    {
+                        // Points into the received frame, no copy is made
+                        data = &b[header];
+                        data_size = length;
+
+                        if(extended)
+                        {
+                            m_rxSeq = qFromBigEndian<quint32>((const uchar *)&b[3]);
+                            m_rxTs = qFromBigEndian<qint64>((const uchar *)&b[7]);
+                            m_rxExt = true;
+                        }
+                    }
+                    else
+                    {
+                        Log("Protocol : CRC mismatch", Log_Level_t::Warning);
+                        m_frameStatus = Frame_Status_t::CRC;
+                    }
+                }
+                else
+                {
+                    Log("Protocol : Length mismatch", Log_Level_t::Warning);
+                    m_frameStatus = Frame_Status_t::Length;
+                }
+            }
+            else
+            {
+                Log("Protocol : Zero data length", Log_Level_t::Warning);
+                m_frameStatus = Frame_Status_t::Length;
+            }
+        }
+        else
+        {
+            Log("Protocol : Wrong header byte", Log_Level_t::Warning);
+            m_frameStatus = Frame_Status_t::Header;
+        }
+    }
+    else
+    {
+        Log("Protocol : Wrong length", Log_Level_t::Warning);
+        m_frameStatus = Frame_Status_t::Length;
     }
 
-    return ~crc;
+    return 0 != data_size;
 }
 
 //---------------------------------------------------------------
@@ -8,8 +8,31 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QPixmap>
 #include "tcp_server.h"
 #include "serial_port.h"
+#include "traffic_capture.h"
+#include "replay_port.h"
+#include "frame_trace.h"
+#include "frame_pool.h"
+#include "test_metrics.h"
+#include "metrics_server.h"
+#include "run_stats.h"
+#include "benchmark.h"
+#include "time_series.h"
+#include "link_emulator.h"
+#include "ber_test.h"
+#include "payload_generator.h"
+#include "clock_offset.h"
+#include "byte_stuffing.h"
+#include "soak_report.h"
+#include "log_model.h"
+#include "port_discovery.h"
+#include "stage_latency.h"
+#include "test_plan.h"
+#include "auto_tune.h"
+#include "file_transfer.h"
+#include "tx_batcher.h"
 
 namespace Ui
 {
@@ -19,7 +42,8 @@ class MainWindow;
 enum class Channel_t
 {
     TCP,
-    Serial
+    Serial,
+    Replay
 };
 enum class Test_Step_t
 {
@@ -32,7 +56,21 @@ enum class Icon_t
     Connecting,
     Testing,
     TestSuccess,
-    TestFailed
+    TestFailed,
+    Count
+};
+
+// A frame sent and not yet answered, oldest first
+struct InFlightFrame
+{
+    qint32  index;
+    qint32  size;           // [bytes] payload
+    quint32 seq;            // Extended header sequence number
+    qint64  txEnqueue;      // [ns]
+    qint64  txWritten;      // [ns] transport write() returned, 0 while the frame waits in a TX batch
+    qint64  txWrite;        // Number of the transport write that carries the frame, 0 before it or behind the link emulator
+    qint64  txComplete;     // [ns] that write was handed to the OS completely, 0 until then
+    qint64  wireBytes;      // [bytes] on the wire
 };
 
 class MainWindow : public QMainWindow
@@ -43,6 +81,38 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
     void startTcpServer(int port);
+    bool startCapture(const QString &path);
+    bool startReplay(const QString &path, bool realtime);
+    bool startFrameTrace(const QString &path, quint32 capacity);
+    bool setRxBufferSize(qint64 size);
+    qint64 getLargestFrame() const;
+    void setSerialBackend(Serial_Backend_t backend, int vmin, int vtime);
+    bool startMetricsServer(int port);
+    void setSocketProfile(Socket_Profile_t profile);
+    void startProfileComparison(const QList<Socket_Profile_t> &profiles);
+    void setStartupTime(qint64 ns);
+    static bool isHeadless();
+    bool setPayload(const QString &spec);
+    void setVerify(bool verify);
+    void setAllocCheck(bool enabled);
+    bool allocCheckPassed() const;
+    void setExtendedHeader(bool allowed);
+    void setFraming(Framing_t framing);
+    void startBerMode(Prbs_t type);
+    void startLinkEmulation(const LinkProfile &profile);
+    void startBenchmark(int runs, int warmup, const QString &baseline, const QString &saveBaseline);
+    void startSoak(int reportSeconds);
+    bool loadPlan(const QString &path);
+    void setPlanResult(const QString &path);
+    bool startAutoTune(const TuneConfig &config);
+    bool startFileTransfer(const QString &path, int frameSize, int window, bool ack);
+    void setTxBatch(const BatchPolicy &policy);
+
+signals:
+    void replayFinished(bool matched);
+    void comparisonFinished();
+    void benchmarkFinished(Baseline_Result_t result);
+    void autoTuneFinished();
 
 private:
     Test_Step_t     m_testStep;
@@ -50,21 +120,119 @@ private:
     QPoint          m_dragPosition;
     bool            m_testStarted;
     qint64          m_data_size = 0;
+    qint64          m_rxCount = 0;          // Shown by UpdateCounters, the frame path leaves the widgets alone
+    qint64          m_txCount = 0;
+    qint64          m_errorCount = 0;
+    qint64          m_rxProgressAt = 0;     // RX count when the progress bars last started over
+    qint64          m_txProgressAt = 0;
     qint64          m_testStartAt;
     qint64          m_testFinishAt;
     qint64          m_testElapsedTime;
+    Channel_t       m_testChannel = Channel_t::TCP;
+    quint32         m_session = 0;
+    Frame_Status_t  m_frameStatus = Frame_Status_t::OK;
+    FrameRecord     m_frame;
+    FrameTrace      m_frameTrace;
+    FramePool       m_framePool;
+    TestMetrics     m_metrics;
+    LatencySamples  m_latency;
+    StageLatency    m_stages;
+    QVector<InFlightFrame> m_inFlight;      // Ring sized to the largest window of the plan
+    int             m_inFlightHead = 0;
+    int             m_inFlightCount = 0;
+    TestPlan        m_plan;
+    QVector<PayloadGenerator *> m_phasePayloads;    // Per phase, nullptr keeps m_payload
+    QString         m_planResultPath;
+    int             m_phase = 0;
+    qint64          m_phaseSent = 0;            // Frames of the phase sent
+    qint64          m_phaseStartedAt = 0;       // [ns]
+    qint64          m_phaseErrorsAt = 0;        // Error count when the phase started
+    qint64          m_phaseFrames = 0;          // Echoes of the phase
+    qint64          m_phaseBytes = 0;           // [bytes] payload echoed in the phase
+    LatencySamples  m_phaseLatency;
+    QVector<PhaseResult> m_planResults;
+    qint64          m_nextSendAt = 0;           // [ns] earliest send under the phase rate
+    int             m_maxPayload = 0;           // [bytes] largest payload of the plan
+    int             m_frameBufferSize = 0;      // [bytes] largest frame after SLIP stuffing
+    AutoTune        m_tune;
+    FileTransfer    m_transfer;
+    TxBatcher       m_batcher;
+    Channel_t       m_batchChannel = Channel_t::TCP;
+    TimeSeriesRing  m_series;
+    RingBuffer      m_linkRxBuffer;
+    Channel_t       m_linkChannel = Channel_t::TCP;
+    qint64          m_linkRxNs = 0;
+    qint64          m_writes = 0;           // Transport writes issued
+    qint64          m_writeDone = 0;        // Number of the last write that completed
+    qint64          m_writeDoneNs = 0;      // [ns] when it completed
+    qint64          m_rxBurstNs = 0;        // [ns] first byte of the burst the last echo came in
+    bool            m_berMode = false;
+    Prbs_t          m_prbsType = Prbs_t::PRBS7;
+    PrbsGenerator   m_prbs;
+    BerCounter      m_ber;
+    QByteArray      m_expected;     // Payloads in flight back to back, each echo is compared against the oldest
+    int             m_expectedHead = 0;     // [bytes] echoed copies at the front, compacted only when the capacity runs out
+    PayloadGenerator *m_payload;
+    bool            m_verify = false;
+    bool            m_extAllowed = false;   // Accept the extended header when the device offers it
+    bool            m_extHeader = false;    // Negotiated for the current session
+    bool            m_rxExt = false;        // Last frame received carried the extended header
+    quint32         m_txSeq = 0;
+    quint32         m_rxSeq = 0;
+    qint64          m_rxTs = 0;             // [ns] device clock
+    qint64          m_seqErrors = 0;
+    ClockOffset     m_clock;
+    Framing_t       m_framing = Framing_t::None;
+    qint64          m_framingFrameBytes = 0;    // [bytes] before stuffing, both directions
+    qint64          m_framingWireBytes = 0;     // [bytes] on the wire, delimiters included
+    qint64          m_framingErrors = 0;        // Blocks that did not decode
+    qint64          m_resyncAt = 0;             // [ns] first bad byte of the current resync, 0 when in step
+    qint64          m_resyncPending = 0;        // [bytes] skipped by the current resync
+    qint64          m_resyncSkipped = 0;        // [bytes] skipped in this session
+    LatencySamples  m_resyncLatency;
+    bool            m_soak = false;
+    qint64          m_soakStartedAt = 0;        // [ns]
+    qint64          m_soakRssStart = -1;        // [bytes] at the first snapshot
+    qint64          m_sweeps = 0;
+    qint64          m_soakTimeouts = 0;         // Frame timeouts ridden through
+    QTimer          m_timer_soak;
+    QList<Socket_Profile_t> m_compareProfiles;
+    int             m_compareRun = 0;
+    QVector<RunSummary> m_compareResults;
+    Benchmark       m_benchmark;
+    QString         m_baseline;
+    QString         m_saveBaseline;
 
     Ui::MainWindow  *ui;
     TcpServer       *m_tcpServer;
     serial_port     *m_serialPort;
+    PortDiscovery   *m_portDiscovery;
+    TrafficCapture  *m_capture;
+    ReplayPort      *m_replayPort;
+    LinkEmulator    *m_link;
+    MetricsServer   *m_metricsServer = nullptr;
     QAction         *usageAction;
     QAction         *aboutAction;
     QAction         *quitAction;
-    QMovie          *movie = nullptr;
+    QMovie          *movie = nullptr;       // Current mood, owned by m_moods
+    QMovie          *m_moods[static_cast<int>(Icon_t::Count)] = {};
+    QPixmap         m_moodDisconnected;
+    bool            m_headless = false;
+    LogModel        *m_log;
+    LogFilter       *m_logFilter;
+    bool            m_logFollow = true;     // The view was at the bottom before the last insert
     QTimer          m_timer_test;
+    QTimer          m_timer_pace;
+    QTimer          m_timer_batch;
+    QTimer          m_timer_ui;
+    qint64          m_testDeadline = 0;     // [ns] frame timeout, m_timer_test is only restarted when it expires early
+    bool            m_allocCheck = false;
+    qint64          m_allocAt = 0;          // Allocation count when the session started
+    qint64          m_allocations = -1;     // In the frame path of the last session, -1 before the warm-up is over
 
     void Form_Init();
-    void Log(const QString &);
+    void Log(const QString &, Log_Level_t level = Log_Level_t::Info);
+    void AddLog(Log_Level_t level, const QString &);
 
     void TcpServer_Init();
     bool TcpServer_Start(int);
@@ -73,24 +241,56 @@ private:
     void SerialPort_Init();
     void SerialPort_Refresh();
     bool SerialPort_Start();
+    void SerialPort_Configure(qint32 rate);
     void SerialPort_Stop();
     void SerialPort_SetEnabled(bool);
 
+    void Replay_Init();
+
     void Clean_Counters();
     void Inc_RX();
     void Inc_TX();
     void Inc_Error();
+    void UpdateCounters();
+    void ArmFrameTimeout(qint64 ms);
+    void CountAllocations();
     void SetTestStarted(bool);
-    bool Send(Channel_t, QByteArray);
-    qint64 PacketTimeout(Channel_t);
+    bool Send(Channel_t, const QByteArray &);
+    bool Write(Channel_t, const QByteArray &);
+    bool WritePort(Channel_t, const QByteArray &);
+    bool FlushBatch();
+    qint64 PacketTimeout(Channel_t, qint32);
     qint64 ElapsedTime(Channel_t);
-    QByteArray Protocol_Wrap(QByteArray);
-    QByteArray Protocol_Unwrap(QByteArray);
-    void Test(Channel_t, QByteArray);
-    quint32 crc32(const char *, quint16);
+    qint64 BytesToWrite(Channel_t);
+    void FrameDone(Channel_t, Frame_Status_t);
+    void Protocol_Wrap(const QByteArray &, QByteArray &);
+    bool Protocol_Unwrap(const char *, int, const char *&, int &);
+    void Receive(Channel_t, RingBuffer &);
+    void Deframe(Channel_t, RingBuffer &);
+    qint64 FrameSize(const RingBuffer &, qint64);
+    bool FrameValid(const RingBuffer &, qint64, qint64);
+    qint64 NextFrame(const RingBuffer &, qint64, qint64 &);
+    qint64 Resync(Channel_t, RingBuffer &);
+    RingBuffer &RxBuffer(Channel_t);
+    void Test(Channel_t, const char *, int);
 
+    QMovie *MoodMovie(Icon_t, const char *);
     void SetMoodIcon(Icon_t);
     void PrintResults();
+    RunSummary Summarize(const QString &label);
+    void SessionDone(bool timedOut);
+    void BenchmarkRunDone(bool timedOut);
+    void SweepDone();
+    void ApplyPlan();
+    qint64 LargestFrame(int payload) const;
+    bool FitsRxBuffer(int payload, const QString &what);
+    void StartPhase(int);
+    void SendWindow(Channel_t);
+    void PhaseDone(bool timedOut);
+    void FinishSession();
+    bool TuneTrialDone();
+    void TuneSessionDone();
+    void SoakSnapshot();
 
 private slots:
     void About();
@@ -103,12 +303,23 @@ private slots:
     void onTcpDataReceivedFromClient();
 
     void onSerialDataReceived();
+    void onSerialPortLost(const QString &error);
+    void onSerialPortsScanned(int count);
+
+    void onReplayDataReceived();
+    void onReplayFinished();
 
     void onTimeoutTest();
+    void onTimeoutPace();
+    void onTimeoutBatch();
+    void onTxDone(qint64 ns);
+    void onLinkDelivered(Link_Direction_t, const QByteArray &);
 
     void on_tabWidget_currentChanged(int);
     void on_serial_open_clicked();
     void on_tcp_listen_clicked();
+    void on_log_level_currentIndexChanged(int);
+    void on_log_search_textChanged(const QString &);
 
 protected:
     void mouseMoveEvent(QMouseEvent *event);
@@ -0,0 +1,142 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "metrics_server.h"
+#include <QHostAddress>
+
+const int METRICS_REQUEST_MAX   = 4096; // [bytes] longer requests are dropped
+
+MetricsEndpoint::MetricsEndpoint(const TestMetrics *metrics, QObject *parent) : QObject(parent),
+    m_metrics(metrics)
+{
+}
+
+bool MetricsEndpoint::isListening() const
+{
+    return m_server && m_server->isListening();
+}
+
+QString MetricsEndpoint::errorString() const
+{
+    return m_server ? m_server->errorString() : QString();
+}
+
+void MetricsEndpoint::listen(int port)
+{
+    if(nullptr == m_server)
+    {
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &MetricsEndpoint::onNewConnection);
+    }
+
+    m_server->close();
+
+    if(m_server->listen(QHostAddress::LocalHost, port))
+    {
+        emit logMessage(QString("Metrics : Serving http://127.0.0.1:%1/metrics").arg(port));
+    }
+}
+
+void MetricsEndpoint::close()
+{
+    if(m_server)
+    {
+        m_server->close();
+    }
+}
+
+void MetricsEndpoint::onNewConnection()
+{
+    while(m_server->hasPendingConnections())
+    {
+        QTcpSocket *socket = m_server->nextPendingConnection();
+        connect(socket, &QTcpSocket::readyRead, this, &MetricsEndpoint::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void MetricsEndpoint::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    QByteArray request, status, body;
+
+    if(nullptr == socket)
+    {
+        return;
+    }
+
+    // Wait for the whole request head, nothing after it is needed
+    if(!socket->peek(METRICS_REQUEST_MAX).contains("\r\n\r\n"))
+    {
+        if(METRICS_REQUEST_MAX <= socket->bytesAvailable())
+        {
+            socket->abort();
+        }
+
+        return;
+    }
+
+    request = socket->readLine(256);
+
+    if(request.startsWith("GET /metrics ") || request.startsWith("GET / "))
+    {
+        status = "200 OK";
+        body = m_metrics->Render();
+    }
+    else
+    {
+        status = "404 Not Found";
+    }
+
+    socket->write("HTTP/1.1 " + status + "\r\n"
+                  "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                  "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                  "Connection: close\r\n\r\n");
+    socket->write(body);
+    socket->disconnectFromHost();
+}
+
+//---------------------------------------------------------------
+
+MetricsServer::MetricsServer(const TestMetrics *metrics, QObject *parent) : QObject(parent)
+{
+    m_endpoint = new MetricsEndpoint(metrics);
+    m_endpoint->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_endpoint, &QObject::deleteLater);
+    // Blocking so that Start() knows whether the port could be bound
+    connect(this, &MetricsServer::startListening, m_endpoint, &MetricsEndpoint::listen, Qt::BlockingQueuedConnection);
+    connect(this, &MetricsServer::stopListening, m_endpoint, &MetricsEndpoint::close, Qt::BlockingQueuedConnection);
+    connect(m_endpoint, &MetricsEndpoint::logMessage, this, &MetricsServer::logMessage);
+}
+
+MetricsServer::~MetricsServer()
+{
+    if(m_thread.isRunning())
+    {
+        emit stopListening();
+        m_thread.quit();
+        m_thread.wait();
+    }
+}
+
+bool MetricsServer::Start(int port)
+{
+    if(!m_thread.isRunning())
+    {
+        m_thread.start(QThread::LowPriority);
+    }
+
+    emit startListening(port);
+
+    // The endpoint is idle until the next queued call, its state can be read here
+    if(!m_endpoint->isListening())
+    {
+        emit logMessage(QString("Metrics : Unable to listen on port %1 : %2").arg(port).arg(m_endpoint->errorString()));
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "test_metrics.h"
+
+// Lives in the server thread, answers scrapes without touching the test engine
+class MetricsEndpoint : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsEndpoint(const TestMetrics *metrics, QObject *parent = nullptr);
+    bool isListening() const;
+    QString errorString() const;
+
+public slots:
+    void listen(int port);
+    void close();
+
+signals:
+    void logMessage(const QString &);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+
+private:
+    const TestMetrics  *m_metrics;
+    QTcpServer         *m_server = nullptr;
+};
+
+// Optional OpenMetrics endpoint on http://127.0.0.1:<port>/metrics
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsServer(const TestMetrics *metrics, QObject *parent = nullptr);
+    ~MetricsServer();
+    bool Start(int port);
+
+signals:
+    void logMessage(const QString &);
+    void startListening(int);
+    void stopListening();
+
+private:
+    QThread             m_thread;
+    MetricsEndpoint    *m_endpoint = nullptr;
+};
+
+#endif // METRICS_SERVER_H
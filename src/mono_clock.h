@@ -0,0 +1,19 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef MONO_CLOCK_H
+#define MONO_CLOCK_H
+
+#include <QtGlobal>
+#include <chrono>
+
+// Monotonic time in nanoseconds, shared by every module that timestamps traffic
+inline qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // MONO_CLOCK_H
@@ -0,0 +1,433 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "native_serial.h"
+
+#if defined(Q_OS_LINUX)
+// termios2 comes from the kernel headers, they cannot be mixed with <termios.h>
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+NativeSerial::NativeSerial(QObject *parent) : QObject(parent)
+{
+}
+
+NativeSerial::~NativeSerial()
+{
+    Close();
+}
+
+bool NativeSerial::isSupported()
+{
+#if defined(Q_OS_LINUX)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void NativeSerial::SetError(const QString &what)
+{
+#if defined(Q_OS_LINUX)
+    m_error = what + " : " + QString::fromLocal8Bit(strerror(errno));
+#else
+    m_error = what;
+#endif
+}
+
+void NativeSerial::HangUp(const QString &what)
+{
+    // The tty stays readable once the device is gone, the notifiers would fire forever
+    SetError(what);
+    m_readNotifier->setEnabled(false);
+    m_writeNotifier->setEnabled(false);
+    emit errorOccurred(QSerialPort::ResourceError);
+}
+
+QString NativeSerial::errorString() const
+{
+    return m_error;
+}
+
+bool NativeSerial::isOpen() const
+{
+    return 0 <= m_fd;
+}
+
+bool NativeSerial::isLowLatency() const
+{
+    return m_lowLatency;
+}
+
+qint64 NativeSerial::getActualRate() const
+{
+    return m_actualRate;
+}
+
+void NativeSerial::setReadTiming(int vmin, int vtime)
+{
+    m_vmin = qBound(0, vmin, 255);
+    m_vtime = qBound(0, vtime, 255);
+}
+
+bool NativeSerial::Open(const QString &path)
+{
+#if defined(Q_OS_LINUX)
+    struct serial_struct serial;
+
+    Close();
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+    if(m_fd < 0)
+    {
+        SetError("open " + path);
+        return false;
+    }
+
+    if(0 != ioctl(m_fd, TIOCEXCL))
+    {
+        SetError("TIOCEXCL");
+        Close();
+        return false;
+    }
+
+    // Makes the driver push every received byte to the tty at once, USB adapters mostly honour it
+    m_lowLatency = false;
+
+    if(0 == ioctl(m_fd, TIOCGSERIAL, &serial))
+    {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        m_lowLatency = (0 == ioctl(m_fd, TIOCSSERIAL, &serial));
+    }
+
+    m_pending.clear();
+    m_written = 0;
+    m_readNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_readNotifier, &QSocketNotifier::activated, this, &NativeSerial::onReadable);
+    m_writeNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Write, this);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QSocketNotifier::activated, this, &NativeSerial::onWritable);
+    return true;
+#else
+    Q_UNUSED(path);
+    m_error = "The native serial backend is only available on Linux";
+    return false;
+#endif
+}
+
+void NativeSerial::Close()
+{
+    // Close may be reached from a notifier's own activation, through a hangup
+    if(m_readNotifier)
+    {
+        m_readNotifier->setEnabled(false);
+        m_readNotifier->deleteLater();
+        m_readNotifier = nullptr;
+    }
+
+    if(m_writeNotifier)
+    {
+        m_writeNotifier->setEnabled(false);
+        m_writeNotifier->deleteLater();
+        m_writeNotifier = nullptr;
+    }
+
+#if defined(Q_OS_LINUX)
+
+    if(0 <= m_fd)
+    {
+        ::close(m_fd);
+    }
+
+#endif
+    m_fd = -1;
+}
+
+bool NativeSerial::Configure(qint32 rate, QSerialPort::DataBits bits, QSerialPort::FlowControl flow, QSerialPort::Parity parity, QSerialPort::StopBits stopBits)
+{
+#if defined(Q_OS_LINUX)
+    struct termios2 tio;
+
+    if(0 != ioctl(m_fd, TCGETS2, &tio))
+    {
+        SetError("TCGETS2");
+        return false;
+    }
+
+    // Raw mode, like cfmakeraw()
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY | INPCK);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CMSPAR | CSTOPB | CRTSCTS | CBAUD | (CBAUD << IBSHIFT));
+    // Exact rate in both directions, no rounding to the nearest Bxxx constant
+    tio.c_cflag |= CREAD | CLOCAL | BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = rate;
+    tio.c_ospeed = rate;
+
+    switch(bits)
+    {
+        case QSerialPort::Data5:
+            tio.c_cflag |= CS5;
+            break;
+
+        case QSerialPort::Data6:
+            tio.c_cflag |= CS6;
+            break;
+
+        case QSerialPort::Data7:
+            tio.c_cflag |= CS7;
+            break;
+
+        default:
+            tio.c_cflag |= CS8;
+            break;
+    }
+
+    switch(parity)
+    {
+        case QSerialPort::EvenParity:
+            tio.c_cflag |= PARENB;
+            break;
+
+        case QSerialPort::OddParity:
+            tio.c_cflag |= PARENB | PARODD;
+            break;
+
+        case QSerialPort::MarkParity:
+            tio.c_cflag |= PARENB | CMSPAR | PARODD;
+            break;
+
+        case QSerialPort::SpaceParity:
+            tio.c_cflag |= PARENB | CMSPAR;
+            break;
+
+        default:
+            break;
+    }
+
+    if(QSerialPort::NoParity != parity)
+    {
+        tio.c_iflag |= INPCK;
+    }
+
+    if(QSerialPort::TwoStop == stopBits)
+    {
+        tio.c_cflag |= CSTOPB;
+    }
+
+    if(QSerialPort::HardwareControl == flow)
+    {
+        tio.c_cflag |= CRTSCTS;
+    }
+    else if(QSerialPort::SoftwareControl == flow)
+    {
+        tio.c_iflag |= IXON | IXOFF;
+    }
+
+    tio.c_cc[VMIN] = static_cast<cc_t>(m_vmin);
+    tio.c_cc[VTIME] = static_cast<cc_t>(m_vtime);
+
+    if(0 != ioctl(m_fd, TCSETS2, &tio))
+    {
+        SetError("TCSETS2");
+        return false;
+    }
+
+    // The driver may pick the closest rate its divisor can make
+    m_actualRate = (0 == ioctl(m_fd, TCGETS2, &tio)) ? tio.c_ospeed : rate;
+    return true;
+#else
+    Q_UNUSED(rate);
+    Q_UNUSED(bits);
+    Q_UNUSED(flow);
+    Q_UNUSED(parity);
+    Q_UNUSED(stopBits);
+    return false;
+#endif
+}
+
+qint64 NativeSerial::Read(char *data, qint64 size)
+{
+#if defined(Q_OS_LINUX)
+    ssize_t n;
+
+    if(m_fd < 0)
+    {
+        return -1;
+    }
+
+    n = ::read(m_fd, data, static_cast<size_t>(size));
+
+    if(0 == n && 0 < size)
+    {
+        // End of file on a tty means the line was hung up
+        HangUp("read : hangup");
+        return -1;
+    }
+
+    if(n < 0)
+    {
+        if(EIO == errno)
+        {
+            HangUp("read");
+            return -1;
+        }
+
+        if(EAGAIN != errno && EINTR != errno)
+        {
+            SetError("read");
+            return -1;
+        }
+
+        return 0;
+    }
+
+    return n;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return -1;
+#endif
+}
+
+qint64 NativeSerial::bytesAvailable() const
+{
+#if defined(Q_OS_LINUX)
+    int available = 0;
+
+    if(0 <= m_fd && 0 == ioctl(m_fd, FIONREAD, &available))
+    {
+        return available;
+    }
+
+#endif
+    return 0;
+}
+
+qint64 NativeSerial::bytesToWrite() const
+{
+    qint64 queued = m_pending.size();
+#if defined(Q_OS_LINUX)
+    int outq = 0;
+
+    // Bytes still in the driver count too, they are not on the wire yet
+    if(0 <= m_fd && 0 == ioctl(m_fd, TIOCOUTQ, &outq))
+    {
+        queued += outq;
+    }
+
+#endif
+    return queued;
+}
+
+qint64 NativeSerial::Write(const char *data, qint64 size)
+{
+#if defined(Q_OS_LINUX)
+    qint64 n = 0;
+
+    if(m_fd < 0)
+    {
+        return -1;
+    }
+
+    if(m_pending.isEmpty())
+    {
+        n = ::write(m_fd, data, static_cast<size_t>(size));
+
+        if(n < 0)
+        {
+            if(EAGAIN != errno && EINTR != errno)
+            {
+                SetError("write");
+                return -1;
+            }
+
+            n = 0;
+        }
+    }
+
+    m_written += n;
+    m_pending.append(data + n, size - n);
+    // Progress is reported from the event loop, as QSerialPort does
+    m_writeNotifier->setEnabled(true);
+    return size;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return -1;
+#endif
+}
+
+void NativeSerial::onReadable()
+{
+#if defined(Q_OS_LINUX)
+
+    if(0 == bytesAvailable())
+    {
+        // Readable with nothing to read, either VMIN/VTIME or the device went away
+        struct pollfd fd;
+        fd.fd = m_fd;
+        fd.events = POLLIN;
+        fd.revents = 0;
+
+        if(0 < poll(&fd, 1, 0) && (fd.revents & (POLLHUP | POLLERR | POLLNVAL)))
+        {
+            HangUp("poll : hangup");
+            return;
+        }
+    }
+
+#endif
+    emit readyRead();
+}
+
+void NativeSerial::onWritable()
+{
+#if defined(Q_OS_LINUX)
+
+    if(!m_pending.isEmpty())
+    {
+        ssize_t n = ::write(m_fd, m_pending.constData(), static_cast<size_t>(m_pending.size()));
+
+        if(0 < n)
+        {
+            m_pending.remove(0, n);
+            m_written += n;
+        }
+        else if(n < 0 && EIO == errno)
+        {
+            m_pending.clear();
+            HangUp("write");
+            return;
+        }
+        else if(n < 0 && EAGAIN != errno && EINTR != errno)
+        {
+            SetError("write");
+            m_pending.clear();
+        }
+    }
+
+    if(m_pending.isEmpty())
+    {
+        m_writeNotifier->setEnabled(false);
+    }
+
+    if(m_written)
+    {
+        qint64 written = m_written;
+        m_written = 0;
+        emit bytesWritten(written);
+    }
+
+#endif
+}
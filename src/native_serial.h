@@ -0,0 +1,68 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef NATIVE_SERIAL_H
+#define NATIVE_SERIAL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QSerialPort>
+#include <QSocketNotifier>
+
+/*
+    Direct tty access on Linux, bypassing the QSerialPort buffering.
+    termios2 / BOTHER sets any baud rate exactly, ASYNC_LOW_LATENCY is asked for where
+    the driver supports it and reads and writes go straight to the non-blocking descriptor.
+    VMIN is the wake-up threshold of the read notifier while VTIME is 0.
+    On other platforms Open() fails and the Qt backend has to be used.
+*/
+class NativeSerial : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NativeSerial(QObject *parent = nullptr);
+    ~NativeSerial();
+    bool Open(const QString &path);
+    void Close();
+    bool isOpen() const;
+    bool Configure(qint32 rate, QSerialPort::DataBits bits, QSerialPort::FlowControl flow, QSerialPort::Parity parity, QSerialPort::StopBits stopBits);
+    void setReadTiming(int vmin, int vtime);
+    qint64 Read(char *data, qint64 size);
+    qint64 Write(const char *data, qint64 size);
+    qint64 bytesAvailable() const;
+    qint64 bytesToWrite() const;
+    qint64 getActualRate() const;
+    bool isLowLatency() const;
+    QString errorString() const;
+
+    static bool isSupported();
+
+signals:
+    void readyRead();
+    void bytesWritten(qint64);
+    void errorOccurred(QSerialPort::SerialPortError);
+
+private slots:
+    void onReadable();
+    void onWritable();
+
+private:
+    void SetError(const QString &what);
+    void HangUp(const QString &what);
+
+    int              m_fd = -1;
+    QSocketNotifier *m_readNotifier = nullptr;
+    QSocketNotifier *m_writeNotifier = nullptr;
+    QByteArray       m_pending;         // Accepted by Write() but not by the kernel yet
+    qint64           m_written = 0;     // [bytes] to report with the next bytesWritten
+    qint64           m_actualRate = 0;
+    int              m_vmin = 1;
+    int              m_vtime = 0;       // [1/10 s]
+    bool             m_lowLatency = false;
+    QString          m_error;
+};
+
+#endif // NATIVE_SERIAL_H
@@ -0,0 +1,231 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "payload_generator.h"
+#include <cstring>
+
+static inline quint64 SplitMix64(quint64 &state)
+{
+    quint64 z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void FillRandom(uchar *out, qint64 n, quint64 &state)
+{
+    qint64 i = 0;
+
+    for(; i + 8 <= n; i += 8)
+    {
+        quint64 v = SplitMix64(state);
+        memcpy(out + i, &v, 8);
+    }
+
+    if(i < n)
+    {
+        quint64 v = SplitMix64(state);
+        memcpy(out + i, &v, n - i);
+    }
+}
+
+PayloadGenerator *PayloadGenerator::Create(const QString &spec, QString &error)
+{
+    QString kind = spec.section(':', 0, 0);
+    QString argument = spec.section(':', 1);
+    Prbs_t prbs;
+    bool ok = true;
+
+    if("ramp" == kind)
+    {
+        return new RampPayload();
+    }
+
+    if("zeros" == kind)
+    {
+        return new FixedPayload(0x00);
+    }
+
+    if("ones" == kind)
+    {
+        return new FixedPayload(0xFF);
+    }
+
+    if("fixed" == kind)
+    {
+        uint value = argument.toUInt(&ok, 0);
+
+        if(ok && value <= 0xFF)
+        {
+            return new FixedPayload(static_cast<uchar>(value));
+        }
+    }
+    else if("random" == kind)
+    {
+        quint64 seed = argument.isEmpty() ? 1 : argument.toULongLong(&ok, 0);
+
+        if(ok)
+        {
+            return new RandomPayload(seed);
+        }
+    }
+    else if("incompressible" == kind)
+    {
+        return new IncompressiblePayload();
+    }
+    else if(PrbsGenerator::FromName(qPrintable(kind), prbs))
+    {
+        return new PrbsPayload(prbs);
+    }
+    else if("file" == kind)
+    {
+        FilePayload *file = new FilePayload();
+
+        if(file->Open(argument))
+        {
+            return file;
+        }
+
+        delete file;
+        error = "Unable to map payload file " + argument;
+        return nullptr;
+    }
+
+    error = "Unknown payload " + spec;
+    return nullptr;
+}
+
+//---------------------------------------------------------------
+
+QString RampPayload::Name() const
+{
+    return "ramp";
+}
+
+void RampPayload::Fill(uchar *out, qint64 n, qint32 index)
+{
+    for(qint64 k = 0; k < n; ++k)
+    {
+        out[k] = (uchar)(index - k);
+    }
+}
+
+FixedPayload::FixedPayload(uchar value) : m_value(value)
+{
+}
+
+QString FixedPayload::Name() const
+{
+    return QString("fixed 0x%1").arg((uint)m_value, 2, 16, QChar('0'));
+}
+
+void FixedPayload::Fill(uchar *out, qint64 n, qint32 index)
+{
+    Q_UNUSED(index);
+    memset(out, m_value, n);
+}
+
+RandomPayload::RandomPayload(quint64 seed) : m_seed(seed)
+{
+}
+
+QString RandomPayload::Name() const
+{
+    return QString("random seed %1").arg(m_seed);
+}
+
+void RandomPayload::Fill(uchar *out, qint64 n, qint32 index)
+{
+    quint64 state = m_seed ^ ((quint64)index << 32);
+    FillRandom(out, n, state);
+}
+
+QString IncompressiblePayload::Name() const
+{
+    return "incompressible";
+}
+
+void IncompressiblePayload::Reset()
+{
+    m_counter = 0;
+}
+
+void IncompressiblePayload::Fill(uchar *out, qint64 n, qint32 index)
+{
+    Q_UNUSED(index);
+    FillRandom(out, n, m_counter);
+}
+
+PrbsPayload::PrbsPayload(Prbs_t type) : m_type(type)
+{
+    m_prbs.Reset(type);
+}
+
+QString PrbsPayload::Name() const
+{
+    return PrbsGenerator::Name(m_type);
+}
+
+void PrbsPayload::Reset()
+{
+    m_prbs.Reset(m_type);
+}
+
+void PrbsPayload::Fill(uchar *out, qint64 n, qint32 index)
+{
+    Q_UNUSED(index);
+    m_prbs.Fill(out, n);
+}
+
+FilePayload::FilePayload()
+{
+}
+
+FilePayload::~FilePayload()
+{
+    if(m_map)
+    {
+        m_file.unmap(m_map);
+    }
+}
+
+bool FilePayload::Open(const QString &path)
+{
+    m_file.setFileName(path);
+
+    if(!m_file.open(QIODevice::ReadOnly) || 0 == m_file.size())
+    {
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_map = m_file.map(0, m_size);
+    return nullptr != m_map;
+}
+
+QString FilePayload::Name() const
+{
+    return "file " + m_file.fileName();
+}
+
+void FilePayload::Reset()
+{
+    m_offset = 0;
+}
+
+void FilePayload::Fill(uchar *out, qint64 n, qint32 index)
+{
+    Q_UNUSED(index);
+
+    while(0 < n)
+    {
+        qint64 chunk = qMin(n, m_size - m_offset);
+        memcpy(out, m_map + m_offset, chunk);
+        m_offset = (m_offset + chunk) % m_size;
+        out += chunk;
+        n -= chunk;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef PAYLOAD_GENERATOR_H
+#define PAYLOAD_GENERATOR_H
+
+#include <QString>
+#include <QFile>
+#include "prbs.h"
+
+// Fills the test payloads, index is the test step the payload is sent for
+class PayloadGenerator
+{
+public:
+    virtual ~PayloadGenerator() {}
+    virtual QString Name() const = 0;
+    virtual void Reset() {}
+    virtual void Fill(uchar *out, qint64 n, qint32 index) = 0;
+
+    // ramp | zeros | ones | fixed:<byte> | random[:seed] | incompressible | prbs7..prbs31 | file:<path>
+    static PayloadGenerator *Create(const QString &spec, QString &error);
+};
+
+// The original pattern, byte k of step i is (i - k)
+class RampPayload : public PayloadGenerator
+{
+public:
+    QString Name() const;
+    void Fill(uchar *out, qint64 n, qint32 index);
+};
+
+class FixedPayload : public PayloadGenerator
+{
+public:
+    explicit FixedPayload(uchar value);
+    QString Name() const;
+    void Fill(uchar *out, qint64 n, qint32 index);
+
+private:
+    uchar m_value;
+};
+
+// Same bytes for the same step and seed on every run
+class RandomPayload : public PayloadGenerator
+{
+public:
+    explicit RandomPayload(quint64 seed);
+    QString Name() const;
+    void Fill(uchar *out, qint64 n, qint32 index);
+
+private:
+    quint64 m_seed;
+};
+
+// One endless random stream, no payload ever repeats
+class IncompressiblePayload : public PayloadGenerator
+{
+public:
+    QString Name() const;
+    void Reset();
+    void Fill(uchar *out, qint64 n, qint32 index);
+
+private:
+    quint64 m_counter = 0;
+};
+
+class PrbsPayload : public PayloadGenerator
+{
+public:
+    explicit PrbsPayload(Prbs_t type);
+    QString Name() const;
+    void Reset();
+    void Fill(uchar *out, qint64 n, qint32 index);
+
+private:
+    Prbs_t          m_type;
+    PrbsGenerator   m_prbs;
+};
+
+// Streams the mapped content of a file, wrapping around at its end
+class FilePayload : public PayloadGenerator
+{
+public:
+    FilePayload();
+    ~FilePayload();
+    bool Open(const QString &path);
+    QString Name() const;
+    void Reset();
+    void Fill(uchar *out, qint64 n, qint32 index);
+
+private:
+    QFile   m_file;
+    uchar  *m_map = nullptr;
+    qint64  m_size = 0;
+    qint64  m_offset = 0;
+};
+
+#endif // PAYLOAD_GENERATOR_H
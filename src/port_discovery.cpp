@@ -0,0 +1,336 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "port_discovery.h"
+
+#if defined(Q_OS_LINUX)
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+const int PORT_SETTLE_TIME  = 250;      // [ms] udev names and links the node after the kernel event
+const int UEVENT_BUFFER     = 8192;     // [bytes]
+
+PortScanner::PortScanner(QObject *parent) : QObject(parent)
+{
+}
+
+void PortScanner::scan()
+{
+    emit scanned(serial_port::Scan());
+}
+
+//---------------------------------------------------------------
+
+PortModel::PortModel(QObject *parent) : QAbstractListModel(parent)
+{
+}
+
+int PortModel::Find(const QString &name) const
+{
+    for(int i = 0; i < m_ports.size(); i++)
+    {
+        if(m_ports[i].name == name)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void PortModel::Apply(const QVector<PortInfo> &ports)
+{
+    // Gone ports first, backwards so the rows in front keep their numbers
+    for(int row = m_ports.size() - 1; 0 <= row; row--)
+    {
+        bool present = false;
+
+        for(const PortInfo &port : ports)
+        {
+            if(port.name == m_ports[row].name)
+            {
+                present = true;
+                break;
+            }
+        }
+
+        if(!present)
+        {
+            PortInfo removed = m_ports[row];
+            beginRemoveRows(QModelIndex(), row, row);
+            m_ports.remove(row);
+            endRemoveRows();
+            emit portRemoved(removed);
+        }
+    }
+
+    for(const PortInfo &port : ports)
+    {
+        int row = Find(port.name);
+
+        if(row < 0)
+        {
+            beginInsertRows(QModelIndex(), m_ports.size(), m_ports.size());
+            m_ports.append(port);
+            endInsertRows();
+            emit portAdded(port);
+        }
+        else if(m_ports[row] != port)
+        {
+            m_ports[row] = port;
+            emit dataChanged(index(row), index(row));
+        }
+    }
+}
+
+const PortInfo &PortModel::port(int row) const
+{
+    return m_ports[row];
+}
+
+int PortModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_ports.size();
+}
+
+QVariant PortModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_ports.size())
+    {
+        return QVariant();
+    }
+
+    const PortInfo &port = m_ports[index.row()];
+
+    switch(role)
+    {
+        case Qt::DisplayRole:
+            return port.description.isEmpty() ? port.name : port.name + " - " + port.description;
+
+        case Qt::ToolTipRole:
+            return QObject::tr("Port: ") + port.name + "\n"
+                   + QObject::tr("Location: ") + port.location + "\n"
+                   + QObject::tr("Description: ") + port.description + "\n"
+                   + QObject::tr("Manufacturer: ") + port.manufacturer + "\n"
+                   + QObject::tr("Serial number: ") + port.serialNumber + "\n"
+                   + QObject::tr("Vendor Identifier: ") + (port.hasVendorId ? QString::number(port.vendorId, 16) : QString()) + "\n"
+                   + QObject::tr("Product Identifier: ") + (port.hasProductId ? QString::number(port.productId, 16) : QString());
+
+        case NameRole:
+            return port.name;
+    }
+
+    return QVariant();
+}
+
+QString PortModel::Describe(const PortInfo &port)
+{
+    QString text = port.name;
+
+    if(port.hasVendorId && port.hasProductId)
+    {
+        text += QString(" %1:%2").arg(port.vendorId, 4, 16, QLatin1Char('0')).arg(port.productId, 4, 16, QLatin1Char('0'));
+    }
+
+    if(!port.description.isEmpty())
+    {
+        text += " " + port.description;
+    }
+
+    if(!port.serialNumber.isEmpty())
+    {
+        text += " S/N " + port.serialNumber;
+    }
+
+    return text;
+}
+
+//---------------------------------------------------------------
+
+PortDiscovery::PortDiscovery(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<QVector<PortInfo>>("QVector<PortInfo>");
+    m_scanner = new PortScanner();
+    m_scanner->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_scanner, &QObject::deleteLater);
+    connect(this, &PortDiscovery::requestScan, m_scanner, &PortScanner::scan);
+    connect(m_scanner, &PortScanner::scanned, this, &PortDiscovery::onScanned);
+    connect(&m_model, &PortModel::portAdded, this, &PortDiscovery::onPortAdded);
+    connect(&m_model, &PortModel::portRemoved, this, &PortDiscovery::onPortRemoved);
+    m_timer_settle.setSingleShot(true);
+    connect(&m_timer_settle, &QTimer::timeout, this, &PortDiscovery::Refresh);
+}
+
+PortDiscovery::~PortDiscovery()
+{
+    m_thread.quit();
+    m_thread.wait();
+#if defined(Q_OS_LINUX)
+
+    if(0 <= m_ueventFd)
+    {
+        ::close(m_ueventFd);
+    }
+
+#endif
+}
+
+void PortDiscovery::Log(const QString &log)
+{
+    emit logMessage("Ports : " + log);
+}
+
+PortModel *PortDiscovery::getModel()
+{
+    return &m_model;
+}
+
+bool PortDiscovery::isScanning() const
+{
+    return m_scanning;
+}
+
+void PortDiscovery::Start()
+{
+    if(!m_thread.isRunning())
+    {
+        m_thread.start(QThread::LowPriority);
+    }
+
+    if(!WatchUevents() && nullptr == m_devWatcher)
+    {
+        // inotify on Linux, kqueue on the BSDs and macOS
+        m_devWatcher = new QFileSystemWatcher(QStringList() << "/dev", this);
+        connect(m_devWatcher, &QFileSystemWatcher::directoryChanged, this, [this]()
+        {
+            m_timer_settle.start(PORT_SETTLE_TIME);
+        });
+        Log(m_devWatcher->directories().isEmpty() ? "No hot-plug notification, refreshed on demand" : "Watching /dev");
+    }
+
+    Refresh();
+}
+
+bool PortDiscovery::WatchUevents()
+{
+#if defined(Q_OS_LINUX)
+    struct sockaddr_nl addr;
+
+    if(0 <= m_ueventFd)
+    {
+        return true;
+    }
+
+    m_ueventFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+
+    if(m_ueventFd < 0)
+    {
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid = 0;
+    addr.nl_groups = 1;     // Kernel uevents, needs no privileges to listen
+
+    if(0 != bind(m_ueventFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)))
+    {
+        ::close(m_ueventFd);
+        m_ueventFd = -1;
+        return false;
+    }
+
+    m_ueventNotifier = new QSocketNotifier(m_ueventFd, QSocketNotifier::Read, this);
+    connect(m_ueventNotifier, &QSocketNotifier::activated, this, &PortDiscovery::onUevent);
+    Log("Watching kernel uevents");
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PortDiscovery::onUevent()
+{
+#if defined(Q_OS_LINUX)
+    char buffer[UEVENT_BUFFER];
+    ssize_t n;
+
+    // "action@devpath" followed by NUL separated KEY=value pairs
+    while(0 < (n = recv(m_ueventFd, buffer, sizeof(buffer) - 1, 0)))
+    {
+        bool tty = false, change = false;
+        buffer[n] = 0;
+
+        for(ssize_t i = 0; i < n; i += strlen(buffer + i) + 1)
+        {
+            const char *field = buffer + i;
+
+            if(0 == strcmp(field, "SUBSYSTEM=tty"))
+            {
+                tty = true;
+            }
+            else if(0 == strcmp(field, "ACTION=add") || 0 == strcmp(field, "ACTION=remove"))
+            {
+                change = true;
+            }
+        }
+
+        if(tty && change)
+        {
+            m_timer_settle.start(PORT_SETTLE_TIME);
+        }
+    }
+
+#endif
+}
+
+void PortDiscovery::Refresh()
+{
+    if(m_scanning)
+    {
+        m_rescan = true;
+        return;
+    }
+
+    if(!m_thread.isRunning())
+    {
+        m_thread.start(QThread::LowPriority);
+    }
+
+    m_scanning = true;
+    m_rescan = false;
+    emit requestScan();
+}
+
+void PortDiscovery::onScanned(const QVector<PortInfo> &ports)
+{
+    m_scanning = false;
+    m_model.Apply(ports);
+    m_scanned = true;
+    emit scanFinished(ports.size());
+
+    if(m_rescan)
+    {
+        Refresh();
+    }
+}
+
+void PortDiscovery::onPortAdded(const PortInfo &port)
+{
+    // The first scan fills the list, only later arrivals are news
+    if(m_scanned)
+    {
+        Log("Added " + PortModel::Describe(port));
+    }
+}
+
+void PortDiscovery::onPortRemoved(const PortInfo &port)
+{
+    Log("Removed " + PortModel::Describe(port));
+}
@@ -0,0 +1,103 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef PORT_DISCOVERY_H
+#define PORT_DISCOVERY_H
+
+#include <QAbstractListModel>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include "serial_port.h"
+
+// Lives in the scanner thread, enumeration may block for a long time
+class PortScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PortScanner(QObject *parent = nullptr);
+
+public slots:
+    void scan();
+
+signals:
+    void scanned(const QVector<PortInfo> &ports);
+};
+
+// Known ports, rows are only inserted, removed or changed so the selection survives a rescan
+class PortModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum
+    {
+        NameRole = Qt::UserRole
+    };
+
+    explicit PortModel(QObject *parent = nullptr);
+    void Apply(const QVector<PortInfo> &ports);
+    const PortInfo &port(int row) const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    static QString Describe(const PortInfo &port);
+
+signals:
+    void portAdded(const PortInfo &port);
+    void portRemoved(const PortInfo &port);
+
+private:
+    int Find(const QString &name) const;
+
+    QVector<PortInfo>   m_ports;
+};
+
+/*
+    Background port enumeration. A rescan is triggered by hot-plug events: kernel uevents
+    of the tty subsystem on Linux, changes of /dev elsewhere. Requests that arrive
+    while a scan runs are folded into one more scan.
+*/
+class PortDiscovery : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PortDiscovery(QObject *parent = nullptr);
+    ~PortDiscovery();
+    void Start();
+    void Refresh();
+    PortModel *getModel();
+    bool isScanning() const;
+
+signals:
+    void logMessage(const QString &);
+    void scanFinished(int count);
+    void requestScan();
+
+private slots:
+    void onScanned(const QVector<PortInfo> &ports);
+    void onUevent();
+    void onPortAdded(const PortInfo &port);
+    void onPortRemoved(const PortInfo &port);
+
+private:
+    void Log(const QString &);
+    bool WatchUevents();
+
+    QThread             m_thread;
+    PortScanner        *m_scanner = nullptr;
+    PortModel           m_model;
+    QFileSystemWatcher *m_devWatcher = nullptr;
+    QSocketNotifier    *m_ueventNotifier = nullptr;
+    int                 m_ueventFd = -1;
+    QTimer              m_timer_settle;
+    bool                m_scanning = false;
+    bool                m_rescan = false;
+    bool                m_scanned = false;
+};
+
+#endif // PORT_DISCOVERY_H
@@ -0,0 +1,131 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "prbs.h"
+#include "simd_ops.h"
+#include <cstring>
+
+struct PrbsPolynomial
+{
+    const char *name;
+    int         degree;     // k
+    int         tap;        // m
+    int         lagA;       // [bytes] k * 2^j / 8
+    int         lagB;       // [bytes] m * 2^j / 8, at least 16 so a whole SIMD block is independent
+};
+
+const PrbsPolynomial PRBS_POLYNOMIALS[] =
+{
+    { "prbs7",  7,  6,  28, 24 },   // j = 5
+    { "prbs15", 15, 14, 30, 28 },   // j = 4
+    { "prbs23", 23, 18, 23, 18 },   // j = 3
+    { "prbs31", 31, 28, 31, 28 },   // j = 3
+};
+
+const qint64 PRBS_BLOCK = 4096;     // [bytes] generated per pass through the work buffer
+
+PrbsGenerator::PrbsGenerator()
+{
+    Reset(Prbs_t::PRBS7);
+}
+
+void PrbsGenerator::Reset(Prbs_t type)
+{
+    const PrbsPolynomial &poly = PRBS_POLYNOMIALS[static_cast<int>(type)];
+    quint32 state = (1u << poly.degree) - 1;   // All ones seed
+
+    m_type = type;
+    m_lagA = poly.lagA;
+    m_lagB = poly.lagB;
+    m_work.assign(m_lagA + PRBS_BLOCK, 0);
+
+    // The first lagA bytes come from the plain bit-serial LFSR
+    for(int i = 0; i < m_lagA; i++)
+    {
+        uchar byte = 0;
+
+        for(int b = 0; b < 8; b++)
+        {
+            quint32 bit = ((state >> (poly.degree - 1)) ^ (state >> (poly.tap - 1))) & 1;
+            state = ((state << 1) | bit) & ((1u << poly.degree) - 1);
+            byte = (byte << 1) | bit;
+        }
+
+        m_work[i] = byte;
+    }
+
+    m_pending = m_lagA;
+}
+
+void PrbsGenerator::Fill(uchar *out, qint64 n)
+{
+    uchar *block = m_work.data() + m_lagA;
+
+    // The seed bytes are the start of the sequence, they go out before anything is generated
+    if(m_pending)
+    {
+        qint64 count = qMin<qint64>(n, m_pending);
+        memcpy(out, m_work.data() + m_lagA - m_pending, count);
+        m_pending -= count;
+        out += count;
+        n -= count;
+    }
+
+    while(0 < n)
+    {
+        qint64 chunk = qMin(n, PRBS_BLOCK);
+        simd::XorLagged(block, chunk, m_lagA, m_lagB);
+        memcpy(out, block, chunk);
+        // The newest lagA bytes become the history of the next block
+        memmove(m_work.data(), block + chunk - m_lagA, m_lagA);
+        out += chunk;
+        n -= chunk;
+    }
+}
+
+bool PrbsGenerator::isSelfConsistent(const uchar *data, qint64 n, qint64 maxErrors) const
+{
+    qint64 errors = 0;
+
+    if(n <= m_lagA)
+    {
+        return false;
+    }
+
+    for(qint64 i = m_lagA; i < n && errors <= maxErrors; i++)
+    {
+        if(data[i] != (data[i - m_lagA] ^ data[i - m_lagB]))
+        {
+            errors++;
+        }
+    }
+
+    return errors <= maxErrors;
+}
+
+int PrbsGenerator::getLagA() const
+{
+    return m_lagA;
+}
+
+bool PrbsGenerator::FromName(const char *name, Prbs_t &type)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        if(0 == strcmp(name, PRBS_POLYNOMIALS[i].name))
+        {
+            type = static_cast<Prbs_t>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char *PrbsGenerator::Name(Prbs_t type)
+{
+    return PRBS_POLYNOMIALS[static_cast<int>(type)].name;
+}
@@ -0,0 +1,47 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef PRBS_H
+#define PRBS_H
+
+#include <QtGlobal>
+#include <vector>
+
+enum class Prbs_t
+{
+    PRBS7 = 0,  // x^7 + x^6 + 1
+    PRBS15,     // x^15 + x^14 + 1
+    PRBS23,     // x^23 + x^18 + 1
+    PRBS31      // x^31 + x^28 + 1
+};
+
+/*
+    Continuous PRBS byte stream, MSB first.
+    Squaring the polynomial 2^j times gives the byte recurrence b[i] = b[i - K] ^ b[i - M],
+    which is generated and checked 16 bytes at a time.
+*/
+class PrbsGenerator
+{
+public:
+    PrbsGenerator();
+    void Reset(Prbs_t type);
+    void Fill(uchar *out, qint64 n);
+    // True when data follows the pattern recurrence on its own, i.e. it is a shifted part of the sequence
+    bool isSelfConsistent(const uchar *data, qint64 n, qint64 maxErrors) const;
+    int getLagA() const;
+
+    static bool FromName(const char *name, Prbs_t &type);
+    static const char *Name(Prbs_t type);
+
+private:
+    Prbs_t              m_type = Prbs_t::PRBS7;
+    int                 m_lagA = 0;     // [bytes] K
+    int                 m_lagB = 0;     // [bytes] M
+    int                 m_pending = 0;  // Seed bytes not handed out yet
+    std::vector<uchar>  m_work;         // lagA history bytes followed by the block being generated
+};
+
+#endif // PRBS_H
@@ -0,0 +1,60 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "protocol.h"
+
+static const quint32 *Crc32Table()
+{
+    static const struct Table
+    {
+        quint32 entry[256];
+
+        Table()
+        {
+            for(quint32 i = 0; i < 256; i++)
+            {
+                quint32 crc = i;
+
+                for(int j = 0; j < 8; j++)
+                {
+                    crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+                }
+
+                entry[i] = crc;
+            }
+        }
+    } table;
+
+    return table.entry;
+}
+
+quint32 ProtocolCrc32(const char *data, quint16 length)
+{
+    const quint32 *table = Crc32Table();
+    quint32 crc = 0xFFFFFFFF;
+
+    for(int i = 0; i < length; i += 2)
+    {
+        // The whole sign extended word is folded in, the table consumes its low byte
+        crc ^= (quint32)(qint32)data[i];
+        crc = (crc >> 8) ^ table[crc & 0xFF];
+    }
+
+    return ~crc;
+}
+
+quint32 Crc32(quint32 crc, const uchar *data, qint64 size)
+{
+    const quint32 *table = Crc32Table();
+    crc = ~crc;
+
+    for(qint64 i = 0; i < size; i++)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
@@ -0,0 +1,23 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <QtGlobal>
+
+// Limits shared by the sweep, test plans, auto-tune and file transfer
+const int PROTOCOL_MAX_PAYLOAD  = 0xFFFF - 16;  // [bytes] the length field and the CRC length are 16 bits
+const int PROTOCOL_MAX_WINDOW   = 64;           // Frames in flight
+
+// Frame checksum as the device computes it : CRC-32 polynomial 0xEDB88320, init and final xor 0xFFFFFFFF,
+// but over every other byte only and with chars sign extended. Not the standard CRC-32, kept for the wire.
+quint32 ProtocolCrc32(const char *data, quint16 length);
+
+// Standard CRC-32 (IEEE 802.3, zlib), pass 0 to start and the last result to continue
+quint32 Crc32(quint32 crc, const uchar *data, qint64 size);
+
+#endif // PROTOCOL_H
@@ -0,0 +1,211 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "replay_port.h"
+#include "mono_clock.h"
+#include "frame_log.h"
+#include <QDebug>
+
+#define REPLAY_TIMEOUT(x) (5 + x/500) // [ms]
+
+const qint64 READ_BUFFER_SIZE = 64 * 1024; // [bytes]
+
+ReplayPort::ReplayPort(QObject *parent) : QObject(parent)
+{
+    connect(&m_timer_next, &QTimer::timeout, this, &ReplayPort::onTimeoutNext);
+    m_timer_next.setSingleShot(true);
+    m_timer_next.setTimerType(Qt::PreciseTimer);
+    m_timer_next.stop();
+    m_rxBuffer.Resize(READ_BUFFER_SIZE);
+}
+
+ReplayPort::~ReplayPort()
+{
+    Close();
+}
+
+void ReplayPort::Log(const QString &log)
+{
+    emit logMessage("Replay : " + log);
+}
+
+qint64 ReplayPort::getReceivedTime()
+{
+    return m_dataReceivedAt;
+}
+
+qint64 ReplayPort::getSentTime()
+{
+    return m_dataSentAt;
+}
+
+qint64 ReplayPort::getRxFirstNs()
+{
+    return m_rxFirstNs;
+}
+
+qint64 ReplayPort::getRxLastNs()
+{
+    return m_rxLastNs;
+}
+
+qint64 ReplayPort::getTimeout(qint64 data_size)
+{
+    return REPLAY_TIMEOUT(data_size);
+}
+
+qint64 ReplayPort::getMismatchCount() const
+{
+    return m_mismatches;
+}
+
+bool ReplayPort::Open(const QString &path)
+{
+    Close();
+
+    if(!TrafficCapture::Load(path, m_content, m_records))
+    {
+        Log("Unable to load " + path);
+        return false;
+    }
+
+    Log(QString("Loaded %1 records from %2").arg(m_records.size()).arg(path));
+    m_open = true;
+    return true;
+}
+
+bool ReplayPort::isOpen() const
+{
+    return m_open;
+}
+
+void ReplayPort::Close()
+{
+    m_timer_next.stop();
+    m_rxBuffer.Clear();
+    m_open = false;
+}
+
+void ReplayPort::Start(bool realtime)
+{
+    m_realtime = realtime;
+    m_position = 0;
+    m_expectedTx = -1;
+    m_txFrames = 0;
+    m_mismatches = 0;
+    m_startedAt = monotonicNs();
+    Log(realtime ? "Started at original speed" : "Started at maximum speed");
+    m_timer_next.start(0);
+}
+
+void ReplayPort::Schedule()
+{
+    qint64 delay = 0;
+
+    if(m_position >= m_records.size())
+    {
+        if(!m_rxBuffer.isEmpty())
+        {
+            emit dataReceived();
+        }
+
+        Log(QString("Finished, %1 responses, %2 mismatches").arg(m_txFrames).arg(m_mismatches));
+        emit finished();
+        return;
+    }
+
+    if(m_realtime)
+    {
+        qint64 due = m_records.at(m_position).timestamp - m_records.at(0).timestamp;
+        delay = qMax<qint64>(0, (due - (monotonicNs() - m_startedAt)) / 1000000);
+    }
+
+    m_timer_next.start(delay);
+}
+
+void ReplayPort::onTimeoutNext()
+{
+    if(!m_open)
+    {
+        return;
+    }
+
+    if(m_position >= m_records.size())
+    {
+        Schedule();
+        return;
+    }
+
+    const CaptureRecord &record = m_records.at(m_position);
+    m_position++;
+
+    if(Capture_Direction_t::RX == record.direction)
+    {
+        m_rxLastNs = monotonicNs();
+
+        if(m_rxBuffer.isEmpty())
+        {
+            m_rxFirstNs = m_rxLastNs;
+        }
+
+        m_rxBuffer.write(m_content.constData() + record.offset, record.length);
+        m_dataReceivedAt = m_rxLastNs / 1000000;
+    }
+    else if(!m_rxBuffer.isEmpty())
+    {
+        // The engine answered here in the recording, so the RX burst is complete
+        if(0 <= m_expectedTx)
+        {
+            Log("No response to the previous burst");
+            m_mismatches++;
+        }
+
+        m_expectedTx = m_position - 1;
+        emit dataReceived();
+    }
+
+    Schedule();
+}
+
+bool ReplayPort::Write(const QByteArray &writeData)
+{
+    m_txDoneNs = monotonicNs();
+    m_dataSentAt = m_txDoneNs / 1000000;
+    emit txDone(m_txDoneNs);
+    m_txFrames++;
+
+    if(0 <= m_expectedTx)
+    {
+        const CaptureRecord &record = m_records.at(m_expectedTx);
+
+        if(record.length != writeData.size() ||
+                0 != memcmp(m_content.constData() + record.offset, writeData.constData(), record.length))
+        {
+            qDebug() << "Replay response differs from the recording at record" << m_expectedTx;
+            m_mismatches++;
+        }
+
+        m_expectedTx = -1;
+    }
+
+    return true;
+}
+
+RingBuffer &ReplayPort::Read()
+{
+    qCDebug(lcFrames) << "Read" << m_rxBuffer.size() << "bytes";
+    return m_rxBuffer;
+}
+
+RingBuffer &ReplayPort::getRxBuffer()
+{
+    return m_rxBuffer;
+}
+
+void ReplayPort::setReadBufferSize(qint64 size)
+{
+    m_rxBuffer.Resize(size);
+}
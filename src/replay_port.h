@@ -0,0 +1,70 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef REPLAY_PORT_H
+#define REPLAY_PORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QTimer>
+#include "traffic_capture.h"
+#include "ring_buffer.h"
+
+// Feeds a recorded capture back to the test engine as if it was a live device
+class ReplayPort : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplayPort(QObject *parent = nullptr);
+    ~ReplayPort();
+    bool Open(const QString &path);
+    void Start(bool realtime);
+    bool isOpen() const;
+    bool Write(const QByteArray &);
+    RingBuffer &Read();
+    RingBuffer &getRxBuffer();
+    void setReadBufferSize(qint64);
+    void Close();
+    qint64 getTimeout(qint64);
+    qint64 getReceivedTime();
+    qint64 getSentTime();
+    qint64 getRxFirstNs();
+    qint64 getRxLastNs();
+    qint64 getMismatchCount() const;
+
+signals:
+    void txDone(qint64 ns);     // A write has been handed to the OS completely
+    void dataReceived();
+    void finished();
+    void logMessage(const QString &);
+
+private slots:
+    void onTimeoutNext();
+
+private:
+    void Log(const QString &);
+    void Schedule();
+
+    QByteArray              m_content;
+    QVector<CaptureRecord>  m_records;
+    int                     m_position = 0;
+    int                     m_expectedTx = -1;
+    bool                    m_open = false;
+    bool                    m_realtime = true;
+    qint64                  m_startedAt = 0;
+    RingBuffer              m_rxBuffer;
+    QTimer                  m_timer_next;
+    qint64                  m_dataReceivedAt = 0;
+    qint64                  m_dataSentAt = 0;
+    qint64                  m_rxFirstNs = 0;
+    qint64                  m_rxLastNs = 0;
+    qint64                  m_txDoneNs = 0;
+    qint64                  m_txFrames = 0;
+    qint64                  m_mismatches = 0;
+};
+
+#endif // REPLAY_PORT_H
@@ -0,0 +1,220 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "ring_buffer.h"
+#include "simd_ops.h"
+#include <cstring>
+
+RingBuffer::RingBuffer(qint64 capacity)
+{
+    Resize(capacity);
+}
+
+void RingBuffer::Resize(qint64 capacity)
+{
+    m_data.assign(static_cast<size_t>(qMax<qint64>(0, capacity)), 0);
+    Clear();
+    ClearCounters();
+}
+
+void RingBuffer::Clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+qint64 RingBuffer::capacity() const
+{
+    return static_cast<qint64>(m_data.size());
+}
+
+qint64 RingBuffer::size() const
+{
+    return m_size;
+}
+
+qint64 RingBuffer::freeSpace() const
+{
+    return capacity() - m_size;
+}
+
+bool RingBuffer::isEmpty() const
+{
+    return 0 == m_size;
+}
+
+char *RingBuffer::writePointer(qint64 &contiguous)
+{
+    qint64 tail;
+
+    if(0 == freeSpace())
+    {
+        contiguous = 0;
+        return nullptr;
+    }
+
+    tail = (m_head + m_size) % capacity();
+    // Free space runs either up to the end of the storage or up to the head
+    contiguous = (tail >= m_head) ? capacity() - tail : m_head - tail;
+    contiguous = qMin(contiguous, freeSpace());
+    return &m_data[static_cast<size_t>(tail)];
+}
+
+void RingBuffer::commit(qint64 bytes)
+{
+    qint64 tail = (m_head + m_size) % qMax<qint64>(1, capacity());
+
+    if(tail + bytes >= capacity())
+    {
+        m_wrapArounds++;
+    }
+
+    m_size += bytes;
+
+    if(m_size > m_highWaterMark)
+    {
+        m_highWaterMark = m_size;
+    }
+}
+
+qint64 RingBuffer::write(const char *data, qint64 size)
+{
+    qint64 written = 0;
+
+    while(written < size)
+    {
+        qint64 contiguous;
+        char *p = writePointer(contiguous);
+
+        if(0 == contiguous)
+        {
+            drop(size - written);
+            break;
+        }
+
+        contiguous = qMin(contiguous, size - written);
+        memcpy(p, data + written, static_cast<size_t>(contiguous));
+        commit(contiguous);
+        written += contiguous;
+    }
+
+    return written;
+}
+
+void RingBuffer::drop(qint64 bytes)
+{
+    m_overflows += bytes;
+}
+
+int RingBuffer::spans(const char *&first, qint64 &firstSize, const char *&second, qint64 &secondSize) const
+{
+    first = second = nullptr;
+    firstSize = secondSize = 0;
+
+    if(0 == m_size)
+    {
+        return 0;
+    }
+
+    first = &m_data[static_cast<size_t>(m_head)];
+    firstSize = qMin(m_size, capacity() - m_head);
+
+    if(firstSize == m_size)
+    {
+        return 1;
+    }
+
+    second = &m_data[0];
+    secondSize = m_size - firstSize;
+    return 2;
+}
+
+const char *RingBuffer::contiguous(qint64 offset, qint64 size) const
+{
+    qint64 start = (m_head + offset) % qMax<qint64>(1, capacity());
+
+    if(offset + size > m_size || start + size > capacity())
+    {
+        return nullptr;
+    }
+
+    return &m_data[static_cast<size_t>(start)];
+}
+
+uchar RingBuffer::at(qint64 offset) const
+{
+    return static_cast<uchar>(m_data[static_cast<size_t>((m_head + offset) % capacity())]);
+}
+
+qint64 RingBuffer::indexOf(uchar c, qint64 from) const
+{
+    const char *span[2];
+    qint64 spanSize[2], base = 0, hit;
+    int count = spans(span[0], spanSize[0], span[1], spanSize[1]);
+
+    for(int i = 0; i < count; i++)
+    {
+        // Skip the part of this span that lies before from
+        qint64 skip = qBound<qint64>(0, from - base, spanSize[i]);
+        hit = simd::FindByte((const uchar *)span[i] + skip, spanSize[i] - skip, c);
+
+        if(0 <= hit)
+        {
+            return base + skip + hit;
+        }
+
+        base += spanSize[i];
+    }
+
+    return -1;
+}
+
+qint64 RingBuffer::copy(char *dest, qint64 offset, qint64 size) const
+{
+    qint64 start, first;
+
+    size = qMin(size, m_size - offset);
+
+    if(size <= 0)
+    {
+        return 0;
+    }
+
+    start = (m_head + offset) % capacity();
+    first = qMin(size, capacity() - start);
+    memcpy(dest, &m_data[static_cast<size_t>(start)], static_cast<size_t>(first));
+    memcpy(dest + first, &m_data[0], static_cast<size_t>(size - first));
+    return size;
+}
+
+void RingBuffer::consume(qint64 bytes)
+{
+    bytes = qMin(bytes, m_size);
+    m_size -= bytes;
+    m_head = (0 == m_size) ? 0 : (m_head + bytes) % capacity();
+}
+
+qint64 RingBuffer::highWaterMark() const
+{
+    return m_highWaterMark;
+}
+
+qint64 RingBuffer::wrapArounds() const
+{
+    return m_wrapArounds;
+}
+
+qint64 RingBuffer::overflows() const
+{
+    return m_overflows;
+}
+
+void RingBuffer::ClearCounters()
+{
+    m_highWaterMark = m_size;
+    m_wrapArounds = 0;
+    m_overflows = 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <QtGlobal>
+#include <vector>
+
+// Fixed capacity byte ring used as the receive buffer of every transport
+class RingBuffer
+{
+public:
+    explicit RingBuffer(qint64 capacity = 0);
+    void Resize(qint64 capacity);
+    void Clear();
+    qint64 capacity() const;
+    qint64 size() const;
+    qint64 freeSpace() const;
+    bool isEmpty() const;
+
+    // Producer side : fill the contiguous free space, then commit what was written
+    char *writePointer(qint64 &contiguous);
+    void commit(qint64 bytes);
+    qint64 write(const char *data, qint64 size);
+    void drop(qint64 bytes);
+
+    // Consumer side : pending data is at most two contiguous spans
+    int spans(const char *&first, qint64 &firstSize, const char *&second, qint64 &secondSize) const;
+    const char *contiguous(qint64 offset, qint64 size) const;
+    uchar at(qint64 offset) const;
+    qint64 indexOf(uchar c, qint64 from = 0) const;
+    qint64 copy(char *dest, qint64 offset, qint64 size) const;
+    void consume(qint64 bytes);
+
+    qint64 highWaterMark() const;
+    qint64 wrapArounds() const;
+    qint64 overflows() const;
+    void ClearCounters();
+
+private:
+    std::vector<char>   m_data;
+    qint64              m_head = 0;     // Read position
+    qint64              m_size = 0;
+    qint64              m_highWaterMark = 0;
+    qint64              m_wrapArounds = 0;
+    qint64              m_overflows = 0; // [bytes] dropped because the ring was full
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,165 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "run_stats.h"
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+void LatencySamples::Reserve(int count)
+{
+    m_samples.reserve(count);
+}
+
+void LatencySamples::Clear()
+{
+    m_samples.resize(0);
+    m_sorted = true;
+}
+
+void LatencySamples::Add(qint64 ns)
+{
+    m_samples.append(ns);
+    m_sorted = false;
+}
+
+int LatencySamples::count() const
+{
+    return m_samples.size();
+}
+
+double LatencySamples::Percentile(double q)
+{
+    int rank;
+
+    if(m_samples.isEmpty())
+    {
+        return 0;
+    }
+
+    if(!m_sorted)
+    {
+        std::sort(m_samples.begin(), m_samples.end());
+        m_sorted = true;
+    }
+
+    rank = static_cast<int>(std::ceil(q * m_samples.size())) - 1;
+    rank = qBound(0, rank, m_samples.size() - 1);
+    return m_samples[rank] / 1000.0;
+}
+
+double LatencySamples::Max()
+{
+    return Percentile(1.0);
+}
+
+QString FormatComparison(const QVector<RunSummary> &runs)
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+          .arg(QLatin1String("run"), -12).arg(QLatin1String("frames"), 7).arg(QLatin1String("errors"), 7).arg(QLatin1String("KB/s"), 9)
+          .arg(QLatin1String("p50 us"), 9).arg(QLatin1String("p90 us"), 9).arg(QLatin1String("p99 us"), 9).arg(QLatin1String("max us"), 9);
+
+    for(const RunSummary &run : runs)
+    {
+        lines << QString("%1 %2 %3 %4 %5 %6 %7 %8")
+              .arg(run.label, -12).arg(run.frames, 7).arg(run.errors, 7).arg(run.throughput, 9, 'f', 1)
+              .arg(run.p50, 9, 'f', 1).arg(run.p90, 9, 'f', 1).arg(run.p99, 9, 'f', 1).arg(run.max, 9, 'f', 1);
+    }
+
+    return lines.join('\n');
+}
+
+SampleStats Describe(const QVector<double> &values)
+{
+    SampleStats stats;
+    double sum = 0;
+    stats.n = values.size();
+
+    if(0 == stats.n)
+    {
+        return stats;
+    }
+
+    for(double v : values)
+    {
+        sum += v;
+    }
+
+    stats.mean = sum / stats.n;
+
+    if(1 < stats.n)
+    {
+        sum = 0;
+
+        for(double v : values)
+        {
+            sum += (v - stats.mean) * (v - stats.mean);
+        }
+
+        stats.stddev = std::sqrt(sum / (stats.n - 1));
+        stats.ci95 = StudentT95(stats.n - 1) * stats.stddev / std::sqrt((double)stats.n);
+    }
+
+    return stats;
+}
+
+double StudentT95(double df)
+{
+    // Two-sided 95 % critical values, df is rounded down so the test stays conservative
+    const double table[30] =
+    {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    int d = static_cast<int>(df);
+
+    if(d < 1)
+    {
+        return table[0];
+    }
+
+    if(d <= 30)
+    {
+        return table[d - 1];
+    }
+
+    if(d <= 60)
+    {
+        return 2.021;
+    }
+
+    if(d <= 120)
+    {
+        return 2.000;
+    }
+
+    return 1.960;
+}
+
+bool SignificantlyDifferent(const SampleStats &a, const SampleStats &b)
+{
+    // Welch's t-test, the two runs may have different variances
+    double va, vb, se, df;
+
+    if(a.n < 2 || b.n < 2)
+    {
+        return false;
+    }
+
+    va = a.stddev * a.stddev / a.n;
+    vb = b.stddev * b.stddev / b.n;
+    se = std::sqrt(va + vb);
+
+    if(0 == se)
+    {
+        return a.mean != b.mean;
+    }
+
+    df = (va + vb) * (va + vb) / (va * va / (a.n - 1) + vb * vb / (b.n - 1));
+    return std::fabs(a.mean - b.mean) / se > StudentT95(df);
+}
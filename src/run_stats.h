@@ -0,0 +1,56 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include <QString>
+#include <QVector>
+
+// Outcome of one test session
+struct RunSummary
+{
+    QString label;
+    qint64  frames = 0;
+    qint64  errors = 0;
+    double  throughput = 0;     // [KB/s]
+    double  p50 = 0;            // [us] frame round trip
+    double  p90 = 0;            // [us]
+    double  p99 = 0;            // [us]
+    double  max = 0;            // [us]
+    bool    timedOut = false;   // Ended on the frame timeout, its figures are partial
+};
+
+// Round trip samples of one session, reserved up front so adding never allocates
+class LatencySamples
+{
+public:
+    void Reserve(int count);
+    void Clear();
+    void Add(qint64 ns);
+    int count() const;
+    double Percentile(double q);    // [us] nearest rank, q in 0..1
+    double Max();                   // [us]
+
+private:
+    QVector<qint64> m_samples;
+    bool            m_sorted = true;
+};
+
+struct SampleStats
+{
+    int     n = 0;
+    double  mean = 0;
+    double  stddev = 0;     // Sample standard deviation
+    double  ci95 = 0;       // Half width of the 95 % confidence interval of the mean
+};
+
+QString FormatComparison(const QVector<RunSummary> &runs);
+SampleStats Describe(const QVector<double> &values);
+double StudentT95(double df);
+bool SignificantlyDifferent(const SampleStats &a, const SampleStats &b);
+
+#endif // RUN_STATS_H
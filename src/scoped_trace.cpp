@@ -0,0 +1,120 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "scoped_trace.h"
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceThreadBuffer
+{
+    int                     tid;
+    std::vector<TraceEvent> events;     // Sized once, never grows
+    size_t                  count = 0;
+    qint64                  dropped = 0;
+};
+
+std::atomic<bool> ScopedTrace::s_enabled(false);
+
+static std::mutex s_buffersLock;        // Taken on thread registration and dump only
+static std::vector<std::unique_ptr<TraceThreadBuffer>> s_buffers;
+const size_t TRACE_EVENTS_PER_THREAD = 1000000;    // 24 MB per traced thread, later events are dropped
+
+void ScopedTrace::Enable()
+{
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void ScopedTrace::Append(const char *name, qint64 start, qint64 duration)
+{
+    static thread_local TraceThreadBuffer *buffer = nullptr;
+
+    if(nullptr == buffer)
+    {
+        std::lock_guard<std::mutex> lock(s_buffersLock);
+        s_buffers.push_back(std::unique_ptr<TraceThreadBuffer>(new TraceThreadBuffer()));
+        buffer = s_buffers.back().get();
+        buffer->tid = static_cast<int>(s_buffers.size());
+        buffer->events.resize(TRACE_EVENTS_PER_THREAD);
+    }
+
+    if(buffer->count < buffer->events.size())
+    {
+        TraceEvent &event = buffer->events[buffer->count++];
+        event.name = name;
+        event.start = start;
+        event.duration = duration;
+    }
+    else
+    {
+        buffer->dropped++;
+    }
+}
+
+bool ScopedTrace::Dump(const QString &path)
+{
+    QFile file(path);
+    qint64 origin = -1;
+    bool first = true;
+
+    // Writers must be idle, the dump is taken once the event loop has stopped
+    s_enabled.store(false, std::memory_order_relaxed);
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        qDebug() << "Unable to write trace events" << path << ":" << file.errorString();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(s_buffersLock);
+    QTextStream out(&file);
+
+    for(size_t b = 0; b < s_buffers.size(); b++)
+    {
+        // Slices are stored when they end, so the earliest start can be anywhere
+        for(size_t i = 0; i < s_buffers[b]->count; i++)
+        {
+            if(origin < 0 || s_buffers[b]->events[i].start < origin)
+            {
+                origin = s_buffers[b]->events[i].start;
+            }
+        }
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    for(size_t b = 0; b < s_buffers.size(); b++)
+    {
+        const TraceThreadBuffer &buffer = *s_buffers[b];
+
+        out << (first ? "" : ",\n")
+            << QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"thread %1\"}}")
+               .arg(buffer.tid);
+        first = false;
+
+        if(buffer.dropped)
+        {
+            qDebug() << "Trace thread" << buffer.tid << "dropped" << buffer.dropped << "events";
+        }
+
+        for(size_t i = 0; i < buffer.count; i++)
+        {
+            const TraceEvent &event = buffer.events[i];
+            // Microseconds with ns resolution, as the format expects
+            out << QString(",\n{\"name\":\"%1\",\"ph\":\"X\",\"pid\":1,\"tid\":%2,\"ts\":%3,\"dur\":%4}")
+                   .arg(QLatin1String(event.name)).arg(buffer.tid)
+                   .arg((event.start - origin) / 1000.0, 0, 'f', 3)
+                   .arg(event.duration / 1000.0, 0, 'f', 3);
+        }
+    }
+
+    out << "\n]}\n";
+    out.flush();
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef SCOPED_TRACE_H
+#define SCOPED_TRACE_H
+
+#include <QString>
+#include <atomic>
+#include "mono_clock.h"
+
+#define TRACE_CONCAT_(a, b)     a##b
+#define TRACE_CONCAT(a, b)      TRACE_CONCAT_(a, b)
+// Records the enclosing scope as one slice, name must be a string literal
+#define TRACE_SCOPE(name)       ScopedTrace TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+struct TraceEvent
+{
+    const char     *name;
+    qint64          start;      // [ns] monotonic
+    qint64          duration;   // [ns]
+};
+
+/*
+    Scoped trace points kept in fixed per-thread buffers, dumped as Chrome trace-event JSON.
+    When tracing is off a trace point costs one relaxed load and a branch.
+*/
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace(const char *name)
+        : m_name(name), m_start(isEnabled() ? monotonicNs() : 0)
+    {
+    }
+
+    ~ScopedTrace()
+    {
+        if(m_start)
+        {
+            Append(m_name, m_start, monotonicNs() - m_start);
+        }
+    }
+
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void Enable();
+    static void Append(const char *name, qint64 start, qint64 duration);
+    static bool Dump(const QString &path);
+
+private:
+    const char     *m_name;
+    qint64          m_start;
+
+    static std::atomic<bool> s_enabled;
+};
+
+#endif // SCOPED_TRACE_H
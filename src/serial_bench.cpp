@@ -0,0 +1,251 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "serial_bench.h"
+#include "mono_clock.h"
+#include <cstdio>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+const Serial_Backend_t BENCH_BACKENDS[] = { Serial_Backend_t::Qt, Serial_Backend_t::Native };
+const int BENCH_RUNS            = 2;
+const int BENCH_MAX_FRAME       = 256;      // [bytes] sizes cycle 1..BENCH_MAX_FRAME
+const int BENCH_FRAME_TIMEOUT   = 1000;     // [ms]
+const qint32 BENCH_BAUD_RATE    = 115200;   // A pty ignores it, it only sizes the RX idle timer
+
+PtyEcho::PtyEcho(int master, QObject *parent) : QThread(parent), m_master(master), m_stop(false)
+{
+}
+
+void PtyEcho::Stop()
+{
+    m_stop = true;
+    wait();
+}
+
+void PtyEcho::run()
+{
+#if defined(Q_OS_UNIX)
+    char buffer[4096];
+    struct pollfd pfd = { m_master, POLLIN, 0 };
+
+    while(!m_stop)
+    {
+        if(0 >= poll(&pfd, 1, 50))
+        {
+            continue;
+        }
+
+        ssize_t n = ::read(m_master, buffer, sizeof(buffer));
+
+        if(n < 0)
+        {
+            // EIO while no slave is open, poll keeps reporting the hangup
+            msleep(1);
+            continue;
+        }
+
+        for(ssize_t done = 0; done < n;)
+        {
+            ssize_t w = ::write(m_master, buffer + done, static_cast<size_t>(n - done));
+
+            if(w <= 0)
+            {
+                break;
+            }
+
+            done += w;
+        }
+    }
+
+#endif
+}
+
+SerialBench::SerialBench(int frames, int vmin, int vtime, QObject *parent) : QObject(parent),
+    m_frames(qMax(1, frames)), m_vmin(vmin), m_vtime(vtime)
+{
+    m_latency.Reserve(m_frames);
+    m_frame.reserve(BENCH_MAX_FRAME);
+    m_timer_frame.setSingleShot(true);
+    connect(&m_timer_frame, &QTimer::timeout, this, &SerialBench::onTimeoutFrame);
+}
+
+SerialBench::~SerialBench()
+{
+    StopRun();
+}
+
+void SerialBench::Start()
+{
+    m_run = 0;
+    m_results.clear();
+
+    if(!StartRun())
+    {
+        emit finished(1);
+    }
+}
+
+bool SerialBench::StartRun()
+{
+#if defined(Q_OS_UNIX)
+    const char *slave;
+
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if(m_master < 0 || 0 != grantpt(m_master) || 0 != unlockpt(m_master) || nullptr == (slave = ptsname(m_master)))
+    {
+        printf("Unable to create a pty pair\n");
+        return false;
+    }
+
+    m_echo = new PtyEcho(m_master);
+    m_echo->start(QThread::HighPriority);
+    m_port = new serial_port(this);
+    m_port->setBackend(BENCH_BACKENDS[m_run], m_vmin, m_vtime);
+    connect(m_port, &serial_port::dataReceived, this, &SerialBench::onDataReceived);
+
+    if(!m_port->Open(QString::fromLocal8Bit(slave)))
+    {
+        printf("Unable to open %s with the %s backend\n", slave, 0 == m_run ? "qt" : "native");
+        StopRun();
+        return false;
+    }
+
+    m_port->Configure(BENCH_BAUD_RATE, QSerialPort::Data8, QSerialPort::NoFlowControl, QSerialPort::NoParity, QSerialPort::OneStop);
+    m_sent = 0;
+    m_lost = 0;
+    m_bytes = 0;
+    m_latency.Clear();
+    m_startedAt = monotonicNs();
+    SendNext();
+    return true;
+#else
+    printf("The serial benchmark needs a pty, it is not available on this platform\n");
+    return false;
+#endif
+}
+
+void SerialBench::StopRun()
+{
+    m_timer_frame.stop();
+
+    if(m_port)
+    {
+        // A run ends inside the port's dataReceived, it is deleted once that returns
+        disconnect(m_port, nullptr, this, nullptr);
+        m_port->Close();
+        m_port->deleteLater();
+        m_port = nullptr;
+    }
+
+    if(m_echo)
+    {
+        m_echo->Stop();
+        delete m_echo;
+        m_echo = nullptr;
+    }
+
+#if defined(Q_OS_UNIX)
+
+    if(0 <= m_master)
+    {
+        ::close(m_master);
+    }
+
+#endif
+    m_master = -1;
+}
+
+void SerialBench::SendNext()
+{
+    int size = 1 + m_sent % BENCH_MAX_FRAME;
+
+    m_frame.resize(size);
+
+    for(int i = 0; i < size; i++)
+    {
+        m_frame[i] = static_cast<char>(i);
+    }
+
+    m_port->getRxBuffer().Clear();
+    m_sentAt = monotonicNs();
+    m_sent++;
+    m_port->Write(m_frame);
+    m_timer_frame.start(BENCH_FRAME_TIMEOUT);
+}
+
+void SerialBench::onDataReceived()
+{
+    RingBuffer &rxBuffer = m_port->getRxBuffer();
+
+    if(rxBuffer.size() < m_frame.size())
+    {
+        // The idle gap split the echo, the rest is still on the way
+        return;
+    }
+
+    m_timer_frame.stop();
+    // Last byte read, the idle timer that delimits frames is not part of the round trip
+    m_latency.Add(m_port->getRxLastNs() - m_sentAt);
+    m_bytes += 2 * m_frame.size();
+    rxBuffer.consume(rxBuffer.size());
+
+    if(m_sent < m_frames)
+    {
+        SendNext();
+    }
+    else
+    {
+        FinishRun();
+    }
+}
+
+void SerialBench::onTimeoutFrame()
+{
+    m_lost++;
+
+    if(m_sent < m_frames)
+    {
+        SendNext();
+    }
+    else
+    {
+        FinishRun();
+    }
+}
+
+void SerialBench::FinishRun()
+{
+    RunSummary summary;
+    double seconds = (monotonicNs() - m_startedAt) / 1e9;
+
+    summary.label = (Serial_Backend_t::Qt == BENCH_BACKENDS[m_run]) ? "qt" : "native";
+    summary.frames = m_latency.count();
+    summary.errors = m_lost;
+    summary.throughput = (0 < seconds) ? m_bytes / 1024.0 / seconds : 0;
+    summary.p50 = m_latency.Percentile(0.5);
+    summary.p90 = m_latency.Percentile(0.9);
+    summary.p99 = m_latency.Percentile(0.99);
+    summary.max = m_latency.Max();
+    m_results.append(summary);
+    StopRun();
+    m_run++;
+
+    if(m_run < BENCH_RUNS && StartRun())
+    {
+        return;
+    }
+
+    printf("Serial backends over a pty, %d frames of 1..%d bytes each\n%s\n", m_frames, BENCH_MAX_FRAME,
+           qPrintable(FormatComparison(m_results)));
+    emit finished(m_results.size() == BENCH_RUNS ? 0 : 1);
+}
@@ -0,0 +1,78 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef SERIAL_BENCH_H
+#define SERIAL_BENCH_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include "serial_port.h"
+#include "run_stats.h"
+
+// Echoes everything written to the pty slave back to it, in its own thread
+class PtyEcho : public QThread
+{
+public:
+    explicit PtyEcho(int master, QObject *parent = nullptr);
+    void Stop();
+
+protected:
+    void run() override;
+
+private:
+    int                 m_master;
+    std::atomic<bool>   m_stop;
+};
+
+/*
+    Round trip of the Qt and the native serial backend over a pseudo terminal pair.
+    Both run the same frame sizes against the same echo, the table shows what each
+    stack adds on top of the kernel tty layer.
+*/
+class SerialBench : public QObject
+{
+    Q_OBJECT
+public:
+    SerialBench(int frames, int vmin, int vtime, QObject *parent = nullptr);
+    ~SerialBench();
+
+public slots:
+    void Start();
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void onDataReceived();
+    void onTimeoutFrame();
+
+private:
+    bool StartRun();
+    void StopRun();
+    void SendNext();
+    void FinishRun();
+
+    int                 m_frames;
+    int                 m_vmin;
+    int                 m_vtime;
+    int                 m_run = 0;
+    int                 m_master = -1;
+    PtyEcho            *m_echo = nullptr;
+    serial_port        *m_port = nullptr;
+    QByteArray          m_frame;
+    int                 m_sent = 0;
+    qint64              m_lost = 0;
+    qint64              m_bytes = 0;
+    qint64              m_sentAt = 0;       // [ns]
+    qint64              m_startedAt = 0;    // [ns]
+    LatencySamples      m_latency;
+    QVector<RunSummary> m_results;
+    QTimer              m_timer_frame;
+};
+
+#endif // SERIAL_BENCH_H
@@ -5,6 +5,11 @@
     Author   : Eray Ozturk  | github.com/diffstorm
 */
 #include "serial_port.h"
+#include "scoped_trace.h"
+#include "mono_clock.h"
+#include "frame_log.h"
+
+const qint64 READ_BUFFER_SIZE = 64 * 1024; // [bytes] default RX ring and driver buffer size
 
 serial_port::serial_port(QObject *parent) : QObject(parent)
 {
@@ -20,6 +25,7 @@ serial_port::serial_port(QObject *parent) : QObject(parent)
     m_timer_rx.stop();
     m_dataReceivedAt = 0;
     m_dataSentAt = 0;
+    setReadBufferSize(READ_BUFFER_SIZE);
 }
 
 serial_port::~serial_port()
@@ -43,25 +49,110 @@ qint64 serial_port::getSentTime()
     return m_dataSentAt;
 }
 
-QList<QString> serial_port::Scan()
+qint64 serial_port::getRxFirstNs()
+{
+    return m_rxFirstNs;
+}
+
+qint64 serial_port::getRxLastNs()
+{
+    return m_rxLastNs;
+}
+
+qint64 serial_port::getBytesToWrite()
+{
+    if(m_native)
+    {
+        return m_native->bytesToWrite();
+    }
+
+    return m_serialPort ? m_serialPort->bytesToWrite() : 0;
+}
+
+void serial_port::setCapture(TrafficCapture *capture)
+{
+    m_capture = capture;
+}
+
+void serial_port::setBackend(Serial_Backend_t backend, int vmin, int vtime)
+{
+    Close();
+
+    if(Serial_Backend_t::Native == backend)
+    {
+        if(nullptr == m_native)
+        {
+            m_native = new NativeSerial(this);
+            connect(m_native, &NativeSerial::readyRead, this, &serial_port::onReadyRead);
+            connect(m_native, &NativeSerial::bytesWritten, this, &serial_port::onBytesWritten);
+            connect(m_native, &NativeSerial::errorOccurred, this, &serial_port::onError);
+        }
+
+        m_native->setReadTiming(vmin, vtime);
+        Log(QString("Native backend, VMIN %1, VTIME %2").arg(vmin).arg(vtime));
+    }
+    else
+    {
+        delete m_native;
+        m_native = nullptr;
+    }
+}
+
+Serial_Backend_t serial_port::getBackend() const
 {
-    QList<QString> ports;
+    return m_native ? Serial_Backend_t::Native : Serial_Backend_t::Qt;
+}
+
+bool serial_port::BackendFromName(const QString &name, Serial_Backend_t &backend)
+{
+    if(0 == name.compare(QLatin1String("qt"), Qt::CaseInsensitive))
+    {
+        backend = Serial_Backend_t::Qt;
+        return true;
+    }
 
+    if(0 == name.compare(QLatin1String("native"), Qt::CaseInsensitive))
+    {
+        backend = Serial_Backend_t::Native;
+        return true;
+    }
+
+    return false;
+}
+
+QString serial_port::ErrorString()
+{
+    return m_native ? m_native->errorString() : m_serialPort->errorString();
+}
+
+qint64 serial_port::BytesAvailable()
+{
+    return m_native ? m_native->bytesAvailable() : m_serialPort->bytesAvailable();
+}
+
+qint64 serial_port::ReadRaw(char *data, qint64 size)
+{
+    return m_native ? m_native->Read(data, size) : m_serialPort->read(data, size);
+}
+
+QVector<PortInfo> serial_port::Scan()
+{
+    QVector<PortInfo> ports;
+
+    // Blocks on the device database, call it from a worker thread
     foreach(const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
     {
-        ports.append(info.portName());
-        /*
-            QString s = QObject::tr("Port:") + info.portName() + "\n"
-                    + QObject::tr("Location:") + info.systemLocation() + "\n"
-                    + QObject::tr("Description:") + info.description() + "\n"
-                    + QObject::tr("Manufacturer:") + info.manufacturer() + "\n"
-                    //+ QObject::tr("Serial number:") + info.serialNumber() + "\n"
-                    + QObject::tr("Vendor Identifier:") + (info.hasVendorIdentifier() ? QString::number(info.vendorIdentifier(), 16) : QString()) + "\n"
-                    + QObject::tr("Product Identifier:") + (info.hasProductIdentifier() ? QString::number(info.productIdentifier(), 16) : QString()) + "\n"
-                    //+ QObject::tr("Busy:") + (info.isBusy() ? QObject::tr("Yes") : QObject::tr("No")) + "\n"
-                    ;
-            qDebug() << s;
-        */
+        PortInfo port;
+        port.name = info.portName();
+        port.location = info.systemLocation();
+        port.description = info.description();
+        port.manufacturer = info.manufacturer();
+        port.serialNumber = info.serialNumber();
+        port.hasVendorId = info.hasVendorIdentifier();
+        port.vendorId = info.vendorIdentifier();
+        port.hasProductId = info.hasProductIdentifier();
+        port.productId = info.productIdentifier();
+        ports.append(port);
     }
 
     return ports;
@@ -71,16 +162,29 @@ bool serial_port::Open(QString name)
 {
     bool ret = false;
 
-    if(m_serialPort->isOpen())
+    if(isOpen())
     {
         Close();
     }
 
     Log(QString("%1").arg(name));
     m_serialPort->setPortName(name);
-    m_serialPort->setReadBufferSize(4096);
+    m_serialPort->setReadBufferSize(m_readBufferSize);
 
-    if(m_serialPort->open(QIODevice::ReadWrite))
+    if(m_native)
+    {
+        // Port names from the scan are relative to /dev
+        if(m_native->Open(name.contains('/') ? name : "/dev/" + name))
+        {
+            Log(QString("Open, low latency %1").arg(QLatin1String(m_native->isLowLatency() ? "on" : "not supported")));
+            ret = true;
+        }
+        else
+        {
+            Log("Open error : " + m_native->errorString());
+        }
+    }
+    else if(m_serialPort->open(QIODevice::ReadWrite))
     {
         Log("Open");
         ret = true;
@@ -95,11 +199,27 @@ bool serial_port::Open(QString name)
 
 bool serial_port::isOpen()
 {
-    return m_serialPort->isOpen();
+    return m_native ? m_native->isOpen() : m_serialPort->isOpen();
 }
 
 void serial_port::Configure(qint32 rate, QSerialPort::DataBits bits, QSerialPort::FlowControl flow, QSerialPort::Parity parity, QSerialPort::StopBits stopBits)
 {
+    if(m_native)
+    {
+        if(m_native->Configure(rate, bits, flow, parity, stopBits))
+        {
+            Log(QString("Baud rate %1 (asked %2)").arg(m_native->getActualRate()).arg(rate));
+        }
+        else
+        {
+            Log("Configure error : " + m_native->errorString());
+        }
+
+        setBaudTimeout(rate, 12);
+        setCharTime(m_native->getActualRate() ? m_native->getActualRate() : rate, bits, parity, stopBits);
+        return;
+    }
+
     if(!m_serialPort->setBaudRate(rate))
     {
         Log("Baud rate error :" + m_serialPort->errorString());
@@ -132,6 +252,35 @@ void serial_port::Configure(qint32 rate, QSerialPort::DataBits bits, QSerialPort
 
     // TODO : calculate the actual frame size
     setBaudTimeout(rate, 12); // Assume that a frame is 12 bits long as worst case
+    setCharTime(rate, bits, parity, stopBits);
+}
+
+void serial_port::setCharTime(qint64 rate, QSerialPort::DataBits bits, QSerialPort::Parity parity, QSerialPort::StopBits stopBits)
+{
+    // Start bit, data bits, parity bit and stop bits
+    double charBits = 1 + static_cast<int>(bits) + (QSerialPort::NoParity == parity ? 0 : 1);
+
+    switch(stopBits)
+    {
+        case QSerialPort::OneAndHalfStop:
+            charBits += 1.5;
+            break;
+
+        case QSerialPort::TwoStop:
+            charBits += 2;
+            break;
+
+        default:
+            charBits += 1;
+            break;
+    }
+
+    m_charTimeNs = (0 < rate) ? charBits * 1e9 / rate : 0;
+}
+
+double serial_port::getCharTimeNs() const
+{
+    return m_charTimeNs;
 }
 
 void serial_port::setBaudTimeout(qint64 baud_rate, qint8 frame_size)
@@ -147,6 +296,12 @@ qint64 serial_port::getBaudTimeout(qint64 data_size)
 
 void serial_port::waitForBytesWritten()
 {
+    if(m_native)
+    {
+        // Queued behind the pending bytes, the write notifier drains them
+        return;
+    }
+
     qint64 bytesToWrite = m_serialPort->bytesToWrite();
 
     if(bytesToWrite)
@@ -158,6 +313,12 @@ void serial_port::waitForBytesWritten()
 
 void serial_port::Close()
 {
+    if(m_native && m_native->isOpen())
+    {
+        m_native->Close();
+        Log("Closed");
+    }
+
     if(m_serialPort->isOpen())
     {
         waitForBytesWritten();
@@ -171,35 +332,40 @@ void serial_port::Close()
 
 bool serial_port::Write(const QByteArray &writeData)
 {
+    TRACE_SCOPE("serial.Write");
     bool ret = true;
     waitForBytesWritten();
 
-    if(m_serialPort->isWritable())
+    if(m_native ? m_native->isOpen() : m_serialPort->isWritable())
     {
-        m_writeData.clear();
-        m_writeData = writeData;
+        m_writeSize = writeData.size();
         m_dataSentAt = QDateTime::currentMSecsSinceEpoch();
-        qDebug() << "Bytes to write :" << writeData.size();
-        qint64 bytesWritten = m_serialPort->write(writeData);
+        qCDebug(lcFrames) << "Bytes to write :" << writeData.size();
+        qint64 bytesWritten = m_native ? m_native->Write(writeData.constData(), writeData.size()) : m_serialPort->write(writeData);
 
         if(bytesWritten == -1)
         {
             ret = false;
-            qDebug() << "Failed to write the data to port" << m_serialPort->portName() << "error:" << m_serialPort->errorString();
+            qDebug() << "Failed to write the data to port" << m_serialPort->portName() << "error:" << ErrorString();
         }
-        else if(bytesWritten != m_writeData.size())
+        else if(bytesWritten != m_writeSize)
         {
             ret = false;
-            qDebug() << "Failed to write all the data to port" << m_serialPort->portName() << "error:" << m_serialPort->errorString();
+            qDebug() << "Failed to write all the data to port" << m_serialPort->portName() << "error:" << ErrorString();
         }
-        else if(bytesWritten == m_writeData.size())
+        else if(bytesWritten == m_writeSize)
         {
-            qDebug() << "Buffer write successful to port" << m_serialPort->portName();
+            qCDebug(lcFrames) << "Buffer write successful to port" << m_serialPort->portName();
         }
 
-        qDebug() << "Remaining bytes to write :" << m_serialPort->bytesToWrite();
-        qDebug() << "Write timeout is set to" << getBaudTimeout(m_writeData.size()) << "ms to write" << m_writeData.size() << "bytes";
-        m_timer_tx.start(getBaudTimeout(m_writeData.size()));
+        if(m_capture && bytesWritten > 0)
+        {
+            m_capture->Record(Capture_Direction_t::TX, writeData.constData(), bytesWritten);
+        }
+
+        qCDebug(lcFrames) << "Remaining bytes to write :" << getBytesToWrite();
+        qCDebug(lcFrames) << "Write timeout is set to" << getBaudTimeout(m_writeSize) << "ms to write" << m_writeSize << "bytes";
+        m_timer_tx.start(getBaudTimeout(m_writeSize));
     }
     else
     {
@@ -210,11 +376,15 @@ bool serial_port::Write(const QByteArray &writeData)
     return ret;
 }
 
-QByteArray serial_port::Read()
+RingBuffer &serial_port::Read()
 {
-    QByteArray readData;
+    TRACE_SCOPE("serial.Read");
 
-    if(m_serialPort->isReadable())
+    if(m_native)
+    {
+        // Nothing is buffered in between, the ring is all there is
+    }
+    else if(m_serialPort->isReadable())
     {
         qint64 bytesAvailable = m_serialPort->bytesAvailable();
 
@@ -229,26 +399,92 @@ QByteArray serial_port::Read()
         qDebug() << "Serial port is not readable";
     }
 
-    readData = m_readData;
-    m_readData.clear();
-    Log(QString("Read %1 bytes").arg(readData.size()));
-    return readData;
+    // The caller decodes straight from the ring and consumes what it used
+    qCDebug(lcFrames) << "Read" << m_rxBuffer.size() << "bytes";
+    return m_rxBuffer;
+}
+
+RingBuffer &serial_port::getRxBuffer()
+{
+    return m_rxBuffer;
+}
+
+void serial_port::setReadBufferSize(qint64 size)
+{
+    m_readBufferSize = size;
+    m_rxBuffer.Resize(size);
+    m_serialPort->setReadBufferSize(size);
 }
 
 void serial_port::onReadyRead()
 {
-    if(m_serialPort->isReadable())
+    TRACE_SCOPE("serial.readyRead");
+
+    if(m_native || m_serialPort->isReadable())
     {
-        qint64 bytesAvailable = m_serialPort->bytesAvailable();
-        qDebug() << bytesAvailable << "bytes are available to read";
+        qint64 bytesAvailable = BytesAvailable();
+        qCDebug(lcFrames) << bytesAvailable << "bytes are available to read";
 
         if(bytesAvailable > 0)
         {
-            m_readData.append(m_serialPort->readAll());
+            bool wasEmpty = m_rxBuffer.isEmpty();
+            qint64 remaining = bytesAvailable;
+
+            // Read straight into the free space of the ring, no intermediate buffer
+            while(remaining > 0)
+            {
+                qint64 contiguous;
+                char *p = m_rxBuffer.writePointer(contiguous);
+                char overflow[256];
+
+                if(0 == contiguous)
+                {
+                    p = overflow;
+                    contiguous = sizeof(overflow);
+                }
+
+                qint64 bytesRead = ReadRaw(p, qMin(contiguous, remaining));
+
+                if(bytesRead <= 0)
+                {
+                    break;
+                }
+
+                if(m_capture)
+                {
+                    m_capture->Record(Capture_Direction_t::RX, p, bytesRead);
+                }
+
+                if(p == overflow)
+                {
+                    qDebug() << "RX buffer is full, dropped" << bytesRead << "bytes";
+                    m_rxBuffer.drop(bytesRead);
+                }
+                else
+                {
+                    m_rxBuffer.commit(bytesRead);
+                }
+
+                remaining -= bytesRead;
+            }
+
+            if(!isOpen())
+            {
+                // The device went away during the read
+                return;
+            }
+
+            m_rxLastNs = monotonicNs();
+
+            if(wasEmpty)
+            {
+                m_rxFirstNs = m_rxLastNs;
+            }
+
             m_dataReceivedAt = QDateTime::currentMSecsSinceEpoch();
         }
 
-        qDebug() << "Read timeout is set to" << getBaudTimeout(bytesAvailable) << "ms to read" << bytesAvailable << "bytes";
+        qCDebug(lcFrames) << "Read timeout is set to" << getBaudTimeout(bytesAvailable) << "ms to read" << bytesAvailable << "bytes";
         m_timer_rx.start(getBaudTimeout(bytesAvailable));
     }
     else
@@ -259,28 +495,31 @@ void serial_port::onReadyRead()
 
 void serial_port::onBytesWritten(qint64 bytes)
 {
+    TRACE_SCOPE("serial.bytesWritten");
+
     m_bytesWritten += bytes;
 
-    if(m_bytesWritten == m_writeData.size())
+    if(m_bytesWritten == m_writeSize)
     {
+        m_txDoneNs = monotonicNs();
         m_timer_tx.stop();
         m_bytesWritten = 0;
-        qDebug() << "Data successfully sent to port" << m_serialPort->portName();
-        Log(QString("Written %1 bytes").arg(m_writeData.size()));
-        //qDebug() << QString("TX:" + m_writeData.toHex());
+        emit txDone(m_txDoneNs);
+        qCDebug(lcFrames) << "Data successfully sent to port" << m_serialPort->portName();
+        qCDebug(lcFrames) << "Written" << m_writeSize << "bytes";
     }
     else
     {
-        qint64 bytesToWrite = m_writeData.size() - m_bytesWritten;
-        qDebug() << "Written" << m_bytesWritten << "/" << m_writeData.size();
-        qDebug() << "Write timeout is set to" << getBaudTimeout(bytesToWrite) << "ms to write" << bytesToWrite << "bytes";
+        qint64 bytesToWrite = m_writeSize - m_bytesWritten;
+        qCDebug(lcFrames) << "Written" << m_bytesWritten << "/" << m_writeSize;
+        qCDebug(lcFrames) << "Write timeout is set to" << getBaudTimeout(bytesToWrite) << "ms to write" << bytesToWrite << "bytes";
         m_timer_tx.start(getBaudTimeout(bytesToWrite));
     }
 }
 
 void serial_port::onTimeoutTX()
 {
-    if(m_bytesWritten != m_writeData.size())
+    if(m_bytesWritten != m_writeSize)
     {
         Log("Write operation timed out");
         qDebug() << "Write operation timed out for port" << m_serialPort->portName();
@@ -298,15 +537,16 @@ void serial_port::onTimeoutTX()
 
 void serial_port::onTimeoutRX()
 {
-    if(m_readData.isEmpty())
+    TRACE_SCOPE("serial.rxIdle");
+
+    if(m_rxBuffer.isEmpty())
     {
-        qDebug() << "No data was currently available for reading from port" << m_serialPort->portName();
+        qCDebug(lcFrames) << "No data was currently available for reading from port" << m_serialPort->portName();
     }
     else
     {
-        qDebug() << "Data successfully received from port" << m_serialPort->portName();
-        qDebug() << m_readData.length() << "bytes received.";
-        //qDebug() << QString("RX:" + m_readData.toHex());
+        qCDebug(lcFrames) << "Data successfully received from port" << m_serialPort->portName();
+        qCDebug(lcFrames) << m_rxBuffer.size() << "bytes received.";
         emit dataReceived();
     }
 }
@@ -320,15 +560,25 @@ void serial_port::onError(QSerialPort::SerialPortError serialPortError)
             break;
 
         case QSerialPort::WriteError:
-            qDebug() << "An I/O error occurred while writing data to port" << m_serialPort->portName() << "error:" << m_serialPort->errorString();
+            qDebug() << "An I/O error occurred while writing data to port" << m_serialPort->portName() << "error:" << ErrorString();
             break;
 
         case QSerialPort::ReadError:
-            qDebug() << "An I/O error occurred while reading data from port" << m_serialPort->portName() << "error:" << m_serialPort->errorString();
+            qDebug() << "An I/O error occurred while reading data from port" << m_serialPort->portName() << "error:" << ErrorString();
             break;
 
+        case QSerialPort::ResourceError:
+        {
+            // Unplugged or hung up, the port is closed instead of polling a dead descriptor
+            QString error = ErrorString();
+            Log("Port lost : " + error);
+            Close();
+            emit portLost(error);
+        }
+        break;
+
         default:
-            qCritical() << "Serial Port error:" << m_serialPort->errorString();
+            qCritical() << "Serial Port error:" << ErrorString();
             break;
     }
 }
@@ -13,6 +13,44 @@
 #include <QByteArray>
 #include <QTimer>
 #include <QtCore>
+#include "traffic_capture.h"
+#include "ring_buffer.h"
+#include "native_serial.h"
+
+enum class Serial_Backend_t
+{
+    Qt = 0,     // QSerialPort
+    Native      // NativeSerial, Linux only
+};
+
+// What the system knows about a port, gathered off the GUI thread by PortDiscovery
+struct PortInfo
+{
+    QString name;
+    QString location;
+    QString description;
+    QString manufacturer;
+    QString serialNumber;
+    quint16 vendorId = 0;
+    quint16 productId = 0;
+    bool    hasVendorId = false;
+    bool    hasProductId = false;
+};
+
+inline bool operator==(const PortInfo &a, const PortInfo &b)
+{
+    return a.name == b.name && a.location == b.location && a.description == b.description &&
+           a.manufacturer == b.manufacturer && a.serialNumber == b.serialNumber &&
+           a.hasVendorId == b.hasVendorId && a.vendorId == b.vendorId &&
+           a.hasProductId == b.hasProductId && a.productId == b.productId;
+}
+
+inline bool operator!=(const PortInfo &a, const PortInfo &b)
+{
+    return !(a == b);
+}
+
+Q_DECLARE_METATYPE(PortInfo)
 
 class serial_port : public QObject
 {
@@ -20,20 +58,33 @@ class serial_port : public QObject
 public:
     explicit serial_port(QObject *parent = nullptr);
     ~serial_port();
-    QList<QString> Scan();
     void Configure(qint32 rate, QSerialPort::DataBits bits, QSerialPort::FlowControl flow, QSerialPort::Parity parity, QSerialPort::StopBits stopBits);
     bool Open(QString);
     bool isOpen();
     bool Write(const QByteArray &);
-    QByteArray Read();
+    RingBuffer &Read();
+    RingBuffer &getRxBuffer();
+    void setReadBufferSize(qint64);
     void Close();
     qint64 getBaudTimeout(qint64);
     qint64 getReceivedTime();
     qint64 getSentTime();
+    qint64 getRxFirstNs();
+    qint64 getRxLastNs();
+    qint64 getBytesToWrite();
+    double getCharTimeNs() const;
+    void setCapture(TrafficCapture *);
+    void setBackend(Serial_Backend_t backend, int vmin, int vtime);
+    Serial_Backend_t getBackend() const;
+
+    static QVector<PortInfo> Scan();
+    static bool BackendFromName(const QString &name, Serial_Backend_t &backend);
 
 signals:
+    void txDone(qint64 ns);     // A write has been handed to the OS completely
     void dataReceived();
     void logMessage(const QString &);
+    void portLost(const QString &error);
 
 public slots:
 
@@ -47,17 +98,28 @@ private slots:
 private:
     void Log(const QString &);
     void setBaudTimeout(qint64, qint8);
+    void setCharTime(qint64 rate, QSerialPort::DataBits bits, QSerialPort::Parity parity, QSerialPort::StopBits stopBits);
     void waitForBytesWritten();
+    qint64 BytesAvailable();
+    qint64 ReadRaw(char *, qint64);
+    QString ErrorString();
 
     QSerialPort     *m_serialPort = nullptr;
-    QByteArray      m_readData;
-    QByteArray      m_writeData;
+    NativeSerial    *m_native = nullptr;    // Set when the native backend is selected
+    RingBuffer      m_rxBuffer;
+    qint64          m_readBufferSize;
+    qint64          m_writeSize = 0;
     qint64          m_bytesWritten = 0;
     QTimer          m_timer_tx;
     QTimer          m_timer_rx;
     qint64          m_dataReceivedAt;
     qint64          m_dataSentAt;
+    qint64          m_rxFirstNs = 0;
+    qint64          m_rxLastNs = 0;
+    qint64          m_txDoneNs = 0;
     qint64          m_baudtimeout;
+    double          m_charTimeNs = 0;       // [ns] one character on the wire at the configured format
+    TrafficCapture  *m_capture = nullptr;
 };
 
 #endif // SERIAL_PORT_H
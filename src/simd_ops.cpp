@@ -0,0 +1,297 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "simd_ops.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_NEON
+#endif
+
+namespace simd
+{
+
+static inline int LowestBit(int mask)
+{
+    int bit = 0;
+
+    while(0 == (mask & (1 << bit)))
+    {
+        bit++;
+    }
+
+    return bit;
+}
+
+static inline int PopCount8(uchar v)
+{
+    v = v - ((v >> 1) & 0x55);
+    v = (v & 0x33) + ((v >> 2) & 0x33);
+    return (v + (v >> 4)) & 0x0F;
+}
+
+void XorLagged(uchar *p, qint64 n, int lagA, int lagB)
+{
+    qint64 i = 0;
+
+#if defined(SIMD_SSE2)
+
+    // A 16 byte block only reads bytes that are already final while 16 <= lagB
+    if(16 <= lagB)
+    {
+        for(; i + 16 <= n; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(p + i - lagA));
+            __m128i b = _mm_loadu_si128((const __m128i *)(p + i - lagB));
+            _mm_storeu_si128((__m128i *)(p + i), _mm_xor_si128(a, b));
+        }
+    }
+
+#elif defined(SIMD_NEON)
+
+    if(16 <= lagB)
+    {
+        for(; i + 16 <= n; i += 16)
+        {
+            vst1q_u8(p + i, veorq_u8(vld1q_u8(p + i - lagA), vld1q_u8(p + i - lagB)));
+        }
+    }
+
+#endif
+
+    for(; i < n; i++)
+    {
+        p[i] = p[i - lagA] ^ p[i - lagB];
+    }
+}
+
+BitErrors CountBitErrors(const uchar *a, const uchar *b, qint64 n, int burstGap)
+{
+    BitErrors errors;
+    qint64 lastError = -1;
+    qint64 i = 0;
+
+    while(i < n)
+    {
+#if defined(SIMD_SSE2)
+
+        // Skip identical 16 byte blocks, the common case on a good link
+        while(i + 16 <= n)
+        {
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+
+            if(0xFFFF != _mm_movemask_epi8(eq))
+            {
+                break;
+            }
+
+            i += 16;
+        }
+
+#elif defined(SIMD_NEON)
+
+        while(i + 16 <= n)
+        {
+            uint8x16_t eq = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+            uint64x2_t lanes = vreinterpretq_u64_u8(eq);
+
+            if(~0ULL != (vgetq_lane_u64(lanes, 0) & vgetq_lane_u64(lanes, 1)))
+            {
+                break;
+            }
+
+            i += 16;
+        }
+
+#else
+
+        while(i + 8 <= n && 0 == memcmp(a + i, b + i, 8))
+        {
+            i += 8;
+        }
+
+#endif
+
+        // Scalar walk through the block holding the difference
+        qint64 end = qMin(n, i + 16);
+
+        for(; i < end; i++)
+        {
+            uchar diff = a[i] ^ b[i];
+
+            if(diff)
+            {
+                if(errors.firstOffset < 0)
+                {
+                    errors.firstOffset = i;
+                }
+
+                if(lastError < 0 || i - lastError > burstGap)
+                {
+                    errors.bursts++;
+                }
+
+                lastError = i;
+                errors.bits += PopCount8(diff);
+            }
+        }
+    }
+
+    return errors;
+}
+
+qint64 FirstMismatch(const uchar *a, const uchar *b, qint64 n)
+{
+    qint64 i = 0;
+
+#if defined(SIMD_SSE2)
+
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+        int mask = _mm_movemask_epi8(eq) ^ 0xFFFF;
+
+        if(mask)
+        {
+            int bit = 0;
+
+            while(0 == (mask & (1 << bit)))
+            {
+                bit++;
+            }
+
+            return i + bit;
+        }
+    }
+
+#elif defined(SIMD_NEON)
+
+    for(; i + 16 <= n; i += 16)
+    {
+        uint64x2_t lanes = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+
+        if(~0ULL != (vgetq_lane_u64(lanes, 0) & vgetq_lane_u64(lanes, 1)))
+        {
+            break;
+        }
+    }
+
+#endif
+
+    for(; i < n; i++)
+    {
+        if(a[i] != b[i])
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+qint64 FindByte(const uchar *p, qint64 n, uchar c)
+{
+    qint64 i = 0;
+
+#if defined(SIMD_SSE2)
+
+    __m128i needle = _mm_set1_epi8((char)c);
+
+    for(; i + 16 <= n; i += 16)
+    {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), needle));
+
+        if(mask)
+        {
+            return i + LowestBit(mask);
+        }
+    }
+
+#elif defined(SIMD_NEON)
+
+    uint8x16_t needle = vdupq_n_u8(c);
+
+    for(; i + 16 <= n; i += 16)
+    {
+        uint64x2_t lanes = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(p + i), needle));
+
+        if(0 != (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)))
+        {
+            break;
+        }
+    }
+
+#endif
+
+    const void *hit = (i < n) ? memchr(p + i, c, static_cast<size_t>(n - i)) : nullptr;
+    return hit ? (const uchar *)hit - p : -1;
+}
+
+qint64 FindEither(const uchar *p, qint64 n, uchar a, uchar b)
+{
+    qint64 i = 0;
+
+#if defined(SIMD_SSE2)
+
+    __m128i needleA = _mm_set1_epi8((char)a);
+    __m128i needleB = _mm_set1_epi8((char)b);
+
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, needleA), _mm_cmpeq_epi8(v, needleB)));
+
+        if(mask)
+        {
+            return i + LowestBit(mask);
+        }
+    }
+
+#elif defined(SIMD_NEON)
+
+    uint8x16_t needleA = vdupq_n_u8(a);
+    uint8x16_t needleB = vdupq_n_u8(b);
+
+    for(; i + 16 <= n; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(p + i);
+        uint64x2_t lanes = vreinterpretq_u64_u8(vorrq_u8(vceqq_u8(v, needleA), vceqq_u8(v, needleB)));
+
+        if(0 != (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)))
+        {
+            break;
+        }
+    }
+
+#endif
+
+    for(; i < n; i++)
+    {
+        if(a == p[i] || b == p[i])
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+const char *Name()
+{
+#if defined(SIMD_SSE2)
+    return "SSE2";
+#elif defined(SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+}
@@ -0,0 +1,39 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef SIMD_OPS_H
+#define SIMD_OPS_H
+
+#include <QtGlobal>
+
+// Byte kernels with SSE2 / NEON paths and a portable fallback, picked at compile time
+namespace simd
+{
+// p[i] = p[i - lagA] ^ p[i - lagB] for i in [0, n), the lag bytes before p must be valid, lagB <= lagA
+void XorLagged(uchar *p, qint64 n, int lagA, int lagB);
+
+// Number of differing bits, and the byte spans they fall in, between a and b
+struct BitErrors
+{
+    qint64 bits = 0;
+    qint64 bursts = 0;          // Error runs separated by at least burstGap clean bytes
+    qint64 firstOffset = -1;    // First differing byte, -1 if none
+};
+BitErrors CountBitErrors(const uchar *a, const uchar *b, qint64 n, int burstGap);
+
+// Offset of the first byte where a and b differ, -1 if they are equal
+qint64 FirstMismatch(const uchar *a, const uchar *b, qint64 n);
+
+// Offset of the first c in p, -1 if there is none
+qint64 FindByte(const uchar *p, qint64 n, uchar c);
+
+// Offset of the first byte equal to a or b, -1 if there is none
+qint64 FindEither(const uchar *p, qint64 n, uchar a, uchar b);
+
+const char *Name();
+}
+
+#endif // SIMD_OPS_H
@@ -0,0 +1,40 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "soak_report.h"
+#include <QFile>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+qint64 ResidentSetBytes()
+{
+#if defined(Q_OS_LINUX)
+    // statm : size resident shared text lib data dt, in pages
+    QFile statm("/proc/self/statm");
+
+    if(statm.open(QIODevice::ReadOnly))
+    {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+
+        if(1 < fields.size())
+        {
+            return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+
+#endif
+    return -1;
+}
+
+QString FormatSoakWindow(const QString &label, const SeriesWindow &window)
+{
+    return QString("%1 %2 frames, %3 errors (%4 %), %5 KB/s, p50 %6 us, p99 %7 us")
+           .arg(label, -10).arg(window.frames).arg(window.errors)
+           .arg(window.frames ? 100.0 * window.errors / window.frames : 0.0, 0, 'f', 3)
+           .arg(window.throughput, 0, 'f', 1).arg(window.p50, 0, 'f', 1).arg(window.p99, 0, 'f', 1);
+}
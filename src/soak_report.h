@@ -0,0 +1,19 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef SOAK_REPORT_H
+#define SOAK_REPORT_H
+
+#include <QString>
+#include "time_series.h"
+
+// [bytes] resident set of this process, -1 where the platform does not tell
+qint64 ResidentSetBytes();
+
+// One line of a soak snapshot : frames, errors, throughput and latency of a window
+QString FormatSoakWindow(const QString &label, const SeriesWindow &window);
+
+#endif // SOAK_REPORT_H
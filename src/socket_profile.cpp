@@ -0,0 +1,163 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "socket_profile.h"
+#include <QStringList>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+const SocketProfile SOCKET_PROFILES[] =
+{
+    // name          noDelay          quickAck         busyPoll         sendBuffer   receiveBuffer keepAlive
+    { "default",     SOCKET_AS_FOUND, SOCKET_AS_FOUND, SOCKET_AS_FOUND, 0,           0,            SOCKET_AS_FOUND },
+    { "low-latency", 1,               1,               50,              0,           0,            1               },
+    { "bulk",        0,               SOCKET_AS_FOUND, SOCKET_AS_FOUND, 1024 * 1024, 1024 * 1024,  1               },
+};
+
+const SocketProfile &GetSocketProfile(Socket_Profile_t profile)
+{
+    return SOCKET_PROFILES[static_cast<int>(profile)];
+}
+
+bool SocketProfileFromName(const QString &name, Socket_Profile_t &profile)
+{
+    const Socket_Profile_t all[] = { Socket_Profile_t::Default, Socket_Profile_t::LowLatency, Socket_Profile_t::Bulk };
+
+    for(Socket_Profile_t p : all)
+    {
+        if(name == QLatin1String(GetSocketProfile(p).name))
+        {
+            profile = p;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SocketProfilesFromList(const QString &list, QList<Socket_Profile_t> &profiles)
+{
+    profiles.clear();
+
+    for(const QString &name : list.split(',', Qt::SkipEmptyParts))
+    {
+        Socket_Profile_t profile;
+
+        if(!SocketProfileFromName(name.trimmed(), profile))
+        {
+            return false;
+        }
+
+        profiles.append(profile);
+    }
+
+    return !profiles.isEmpty();
+}
+
+void ApplySocketProfile(QTcpSocket *socket, const SocketProfile &profile)
+{
+    if(SOCKET_AS_FOUND != profile.noDelay)
+    {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, profile.noDelay);
+    }
+
+    if(SOCKET_AS_FOUND != profile.keepAlive)
+    {
+        socket->setSocketOption(QAbstractSocket::KeepAliveOption, profile.keepAlive);
+    }
+
+    // Linux doubles the size asked for and reports the doubled value, sizes are only ever set from the profile
+    if(profile.sendBuffer)
+    {
+        socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, profile.sendBuffer);
+    }
+
+    if(profile.receiveBuffer)
+    {
+        socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, profile.receiveBuffer);
+    }
+
+#ifdef Q_OS_LINUX
+    int fd = static_cast<int>(socket->socketDescriptor());
+    int busyPoll = profile.busyPoll;
+    int quickAck = profile.quickAck;
+
+    if(0 <= fd && SOCKET_AS_FOUND != busyPoll)
+    {
+        // SO_BUSY_POLL may need CAP_NET_ADMIN to be raised, failure leaves it off
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll));
+    }
+
+    if(0 <= fd && SOCKET_AS_FOUND != quickAck)
+    {
+        setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &quickAck, sizeof(quickAck));
+    }
+#endif
+}
+
+SocketProfile ReadSocketProfile(QTcpSocket *socket)
+{
+    SocketProfile found = { "as found", SOCKET_AS_FOUND, SOCKET_AS_FOUND, SOCKET_AS_FOUND, 0, 0, SOCKET_AS_FOUND };
+    QVariant noDelay = socket->socketOption(QAbstractSocket::LowDelayOption);
+    QVariant keepAlive = socket->socketOption(QAbstractSocket::KeepAliveOption);
+
+    if(noDelay.isValid())
+    {
+        found.noDelay = noDelay.toInt() ? 1 : 0;
+    }
+
+    if(keepAlive.isValid())
+    {
+        found.keepAlive = keepAlive.toInt() ? 1 : 0;
+    }
+
+    found.sendBuffer = qMax(0, socket->socketOption(QAbstractSocket::SendBufferSizeSocketOption).toInt());
+    found.receiveBuffer = qMax(0, socket->socketOption(QAbstractSocket::ReceiveBufferSizeSocketOption).toInt());
+
+#ifdef Q_OS_LINUX
+    int fd = static_cast<int>(socket->socketDescriptor());
+    int option;
+    socklen_t length = sizeof(option);
+
+    // Linux reports twice the size that was set, halved so that setting it again gives the same buffer
+    found.sendBuffer /= 2;
+    found.receiveBuffer /= 2;
+
+    if(0 <= fd && 0 == getsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &option, &length))
+    {
+        found.busyPoll = option;
+    }
+
+    length = sizeof(option);
+
+    if(0 <= fd && 0 == getsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &option, &length))
+    {
+        found.quickAck = option ? 1 : 0;
+    }
+#endif
+
+    return found;
+}
+
+void RearmQuickAck(QTcpSocket *socket)
+{
+#ifdef Q_OS_LINUX
+    // The kernel drops back to delayed ACKs on its own, so the flag is set again after each read
+    int fd = static_cast<int>(socket->socketDescriptor());
+    int quickAck = 1;
+
+    if(0 <= fd)
+    {
+        setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &quickAck, sizeof(quickAck));
+    }
+#else
+    Q_UNUSED(socket);
+#endif
+}
@@ -0,0 +1,43 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef SOCKET_PROFILE_H
+#define SOCKET_PROFILE_H
+
+#include <QString>
+#include <QList>
+#include <QTcpSocket>
+
+enum class Socket_Profile_t
+{
+    Default,    // Options as found on the accepted socket
+    LowLatency, // No Nagle, quick ACKs, busy polling
+    Bulk        // Nagle on, large kernel buffers
+};
+
+const int SOCKET_AS_FOUND       = -1;   // Option left as the accepted socket has it
+
+// Only the options a profile sets are applied, SOCKET_AS_FOUND (or 0 for a buffer) leaves one alone
+struct SocketProfile
+{
+    const char *name;
+    int         noDelay;        // TCP_NODELAY, 0 or 1
+    int         quickAck;       // TCP_QUICKACK, 0 or 1, Linux only, re-armed after every read
+    int         busyPoll;       // [us] SO_BUSY_POLL, Linux only, 0 = off
+    int         sendBuffer;     // [bytes] SO_SNDBUF, 0 = as found
+    int         receiveBuffer;  // [bytes] SO_RCVBUF, 0 = as found
+    int         keepAlive;      // SO_KEEPALIVE, 0 or 1
+};
+
+const SocketProfile &GetSocketProfile(Socket_Profile_t profile);
+bool SocketProfileFromName(const QString &name, Socket_Profile_t &profile);
+bool SocketProfilesFromList(const QString &list, QList<Socket_Profile_t> &profiles);
+
+void ApplySocketProfile(QTcpSocket *socket, const SocketProfile &profile);
+SocketProfile ReadSocketProfile(QTcpSocket *socket);    // Options as the socket has them, applying the result restores them
+void RearmQuickAck(QTcpSocket *socket);
+
+#endif // SOCKET_PROFILE_H
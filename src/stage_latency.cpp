@@ -0,0 +1,120 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "stage_latency.h"
+#include <QStringList>
+
+void StageLatency::Reserve(int frames)
+{
+    for(LatencySamples &samples : m_stages)
+    {
+        samples.Reserve(frames);
+    }
+
+    m_think.Reserve(frames);
+}
+
+void StageLatency::Clear()
+{
+    for(LatencySamples &samples : m_stages)
+    {
+        samples.Clear();
+    }
+
+    m_think.Clear();
+    m_sharedBursts = 0;
+}
+
+void StageLatency::setCharTime(double ns)
+{
+    m_charTime = ns;
+}
+
+int StageLatency::count() const
+{
+    return m_stages[static_cast<int>(Stage_t::Queue)].count();
+}
+
+void StageLatency::Add(const StageStamps &stamps, qint64 txBytes)
+{
+    const qint64 points[] = { stamps.enqueue, stamps.written, stamps.sent, stamps.rxFirst, stamps.rxLast, stamps.decoded };
+
+    for(int i = 0; i < static_cast<int>(Stage_t::Count); i++)
+    {
+        // A stage counts only when both of its ends were seen in order
+        if(points[i] && points[i + 1] >= points[i])
+        {
+            m_stages[i].Add(points[i + 1] - points[i]);
+        }
+    }
+
+    if(stamps.rxLast && !stamps.rxFirst)
+    {
+        m_sharedBursts++;
+    }
+
+    if(0 < m_charTime && stamps.sent && stamps.rxFirst >= stamps.sent)
+    {
+        // Negative when the UART was already shifting out before bytesWritten, kept to show the model's error
+        m_think.Add(stamps.rxFirst - stamps.sent - static_cast<qint64>((txBytes + 1) * m_charTime));
+    }
+}
+
+QString StageLatency::Report()
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5")
+          .arg(QLatin1String("stage"), -12).arg(QLatin1String("frames"), 7)
+          .arg(QLatin1String("p50 us"), 9).arg(QLatin1String("p99 us"), 9).arg(QLatin1String("max us"), 9);
+
+    for(int i = 0; i < static_cast<int>(Stage_t::Count); i++)
+    {
+        lines << QString("%1 %2 %3 %4 %5")
+              .arg(QLatin1String(Name(static_cast<Stage_t>(i))), -12).arg(m_stages[i].count(), 7)
+              .arg(m_stages[i].Percentile(0.5), 9, 'f', 1).arg(m_stages[i].Percentile(0.99), 9, 'f', 1).arg(m_stages[i].Max(), 9, 'f', 1);
+    }
+
+    if(m_think.count())
+    {
+        lines << QString("%1 %2 %3 %4 %5")
+              .arg(QLatin1String("think"), -12).arg(m_think.count(), 7)
+              .arg(m_think.Percentile(0.5), 9, 'f', 1).arg(m_think.Percentile(0.99), 9, 'f', 1).arg(m_think.Max(), 9, 'f', 1);
+        lines << QString("Device think time is the flight minus %1 us per wire character").arg(m_charTime / 1000.0, 0, 'f', 2);
+    }
+
+    if(m_sharedBursts)
+    {
+        lines << QString("%1 echoes arrived in the burst of an earlier one, their flight and receive stages are left out").arg(m_sharedBursts);
+    }
+
+    return lines.join('\n');
+}
+
+const char *StageLatency::Name(Stage_t stage)
+{
+    switch(stage)
+    {
+        case Stage_t::Queue:
+            return "queue";
+
+        case Stage_t::Write:
+            return "write";
+
+        case Stage_t::Flight:
+            return "flight";
+
+        case Stage_t::Receive:
+            return "receive";
+
+        case Stage_t::Decode:
+            return "decode";
+
+        default:
+            break;
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,58 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef STAGE_LATENCY_H
+#define STAGE_LATENCY_H
+
+#include <QString>
+#include "run_stats.h"
+
+enum class Stage_t : quint8
+{
+    Queue = 0,      // Send() to write() return : wrapping, stuffing, the transport's own buffering
+    Write,          // write() return to bytesWritten : handed to the kernel
+    Flight,         // bytesWritten to the first RX byte : wire, device and the way back
+    Receive,        // First to last RX byte
+    Decode,         // Last RX byte to the frame checked : RX idle timer, unwrap, test
+    Count
+};
+
+// Monotonic timestamps [ns] of one round trip, 0 where a stage was not reached
+struct StageStamps
+{
+    qint64  enqueue;
+    qint64  written;
+    qint64  sent;
+    qint64  rxFirst;
+    qint64  rxLast;
+    qint64  decoded;
+};
+
+/*
+    Per stage round trip distributions. With a character time set (serial links) the
+    device think time is estimated as the flight time minus the wire time of the frame
+    and of the first reply character.
+*/
+class StageLatency
+{
+public:
+    void Reserve(int frames);
+    void Clear();
+    void setCharTime(double ns);
+    void Add(const StageStamps &stamps, qint64 txBytes);
+    int count() const;
+    QString Report();
+
+    static const char *Name(Stage_t stage);
+
+private:
+    LatencySamples  m_stages[static_cast<int>(Stage_t::Count)];
+    LatencySamples  m_think;
+    double          m_charTime = 0;     // [ns] one character on the wire, 0 without a wire model
+    int             m_sharedBursts = 0; // Echoes without a first RX byte of their own
+};
+
+#endif // STAGE_LATENCY_H
@@ -5,10 +5,15 @@
     Author   : Eray Ozturk  | github.com/diffstorm
 */
 #include "tcp_server.h"
+#include "scoped_trace.h"
+#include "mono_clock.h"
+#include "frame_log.h"
 
 // TODO : Adaptive timeout determined by network latency measurement
 #define TCP_TIMEOUT(x) (5 + x/500) // [ms]
 
+const qint64 READ_BUFFER_SIZE = 64 * 1024; // [bytes] default RX ring and driver buffer size
+
 TcpServer::TcpServer()
 {
     m_socket = nullptr;
@@ -25,6 +30,7 @@ TcpServer::TcpServer()
     m_timer_rx.stop();
     m_dataReceivedAt = 0;
     m_dataSentAt = 0;
+    setReadBufferSize(READ_BUFFER_SIZE);
 }
 
 TcpServer::~TcpServer()
@@ -49,6 +55,45 @@ qint64 TcpServer::getSentTime()
     return m_dataSentAt;
 }
 
+qint64 TcpServer::getRxFirstNs()
+{
+    return m_rxFirstNs;
+}
+
+qint64 TcpServer::getRxLastNs()
+{
+    return m_rxLastNs;
+}
+
+qint64 TcpServer::getBytesToWrite()
+{
+    return m_socket ? m_socket->bytesToWrite() : 0;
+}
+
+void TcpServer::setSocketProfile(Socket_Profile_t profile)
+{
+    m_profile = profile;
+
+    if(nullptr != m_socket && m_socket->isValid())
+    {
+        // Options of the previous profile are undone first, a profile only sets what it names
+        ApplySocketProfile(m_socket, m_found);
+        ApplySocketProfile(m_socket, GetSocketProfile(profile));
+    }
+
+    Log(QString("Socket profile %1").arg(GetSocketProfile(profile).name));
+}
+
+Socket_Profile_t TcpServer::getSocketProfile() const
+{
+    return m_profile;
+}
+
+void TcpServer::setCapture(TrafficCapture *capture)
+{
+    m_capture = capture;
+}
+
 qint64 TcpServer::getTimeout(qint64 data_size)
 {
     return TCP_TIMEOUT(data_size);
@@ -142,9 +187,10 @@ void TcpServer::onNewClientConnection()
     }
 
     m_socket = m_tcpServer->nextPendingConnection();
-    //m_socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    m_found = ReadSocketProfile(m_socket);
+    ApplySocketProfile(m_socket, GetSocketProfile(m_profile));
     m_socket->flush();
-    m_socket->setReadBufferSize(4096);
+    m_socket->setReadBufferSize(m_readBufferSize);
 
     if(m_socket->isValid())
     {
@@ -175,6 +221,7 @@ void TcpServer::onClientDisconnectedSlot()
 
 bool TcpServer::Write(const QByteArray &writeData)
 {
+    TRACE_SCOPE("tcp.Write");
     bool ret = false;
 
     if(!m_socket->isValid())
@@ -188,29 +235,33 @@ bool TcpServer::Write(const QByteArray &writeData)
         if(m_socket->state() == QTcpSocket::ConnectedState &&
                 m_socket->isWritable())
         {
-            m_writeData.clear();
-            m_writeData = writeData;
+            m_writeSize = writeData.size();
             m_dataSentAt = QDateTime::currentMSecsSinceEpoch();
-            qDebug() << "Bytes to write :" << writeData.size();
+            qCDebug(lcFrames) << "Bytes to write :" << writeData.size();
             qint64 bytesWritten = m_socket->write(writeData);
 
             if(bytesWritten == -1)
             {
                 qDebug() << "Failed to write the data -" << "error:" << m_socket->errorString();
             }
-            else if(bytesWritten != m_writeData.size())
+            else if(bytesWritten != m_writeSize)
             {
                 qDebug() << "Failed to write all the data -" << "error:" << m_socket->errorString();
             }
-            else if(bytesWritten == m_writeData.size())
+            else if(bytesWritten == m_writeSize)
             {
                 ret = true;
-                qDebug() << "Buffer write successful";
+                qCDebug(lcFrames) << "Buffer write successful";
+            }
+
+            if(m_capture && bytesWritten > 0)
+            {
+                m_capture->Record(Capture_Direction_t::TX, writeData.constData(), bytesWritten);
             }
 
-            qDebug() << "Remaining bytes to write :" << m_socket->bytesToWrite();
-            qDebug() << "Write timeout is set to" << TCP_TIMEOUT(m_writeData.size()) << "ms to write" << m_writeData.size() << "bytes";
-            m_timer_tx.start(TCP_TIMEOUT(m_writeData.size()));
+            qCDebug(lcFrames) << "Remaining bytes to write :" << m_socket->bytesToWrite();
+            qCDebug(lcFrames) << "Write timeout is set to" << TCP_TIMEOUT(m_writeSize) << "ms to write" << m_writeSize << "bytes";
+            m_timer_tx.start(TCP_TIMEOUT(m_writeSize));
         }
         else
         {
@@ -221,9 +272,9 @@ bool TcpServer::Write(const QByteArray &writeData)
     return ret;
 }
 
-QByteArray TcpServer::Read()
+RingBuffer &TcpServer::Read()
 {
-    QByteArray readData;
+    TRACE_SCOPE("tcp.Read");
 
     if(m_socket->isReadable())
     {
@@ -240,15 +291,32 @@ QByteArray TcpServer::Read()
         qDebug() << "Socket is not readable";
     }
 
-    readData = m_readData;
-    m_readData.clear();
-    Log(QString("Read %1 bytes").arg(readData.size()));
-    return readData;
+    // The caller decodes straight from the ring and consumes what it used
+    qCDebug(lcFrames) << "Read" << m_rxBuffer.size() << "bytes";
+    return m_rxBuffer;
+}
+
+RingBuffer &TcpServer::getRxBuffer()
+{
+    return m_rxBuffer;
+}
+
+void TcpServer::setReadBufferSize(qint64 size)
+{
+    m_readBufferSize = size;
+    m_rxBuffer.Resize(size);
+
+    if(nullptr != m_socket)
+    {
+        m_socket->setReadBufferSize(size);
+    }
 }
 
 void TcpServer::dataReceivedSlot()
 {
-    qDebug() << "Data received.";
+    TRACE_SCOPE("tcp.readyRead");
+
+    qCDebug(lcFrames) << "Data received.";
 
     if(!m_socket->isValid())
     {
@@ -260,15 +328,67 @@ void TcpServer::dataReceivedSlot()
             m_socket->isReadable())
     {
         qint64 bytesAvailable = m_socket->bytesAvailable();
-        qDebug() << bytesAvailable << "bytes are available to read";
+        qCDebug(lcFrames) << bytesAvailable << "bytes are available to read";
 
         if(bytesAvailable > 0)
         {
-            m_readData.append(m_socket->readAll());
+            bool wasEmpty = m_rxBuffer.isEmpty();
+            qint64 remaining = bytesAvailable;
+
+            // Read straight into the free space of the ring, no intermediate buffer
+            while(remaining > 0)
+            {
+                qint64 contiguous;
+                char *p = m_rxBuffer.writePointer(contiguous);
+                char overflow[256];
+
+                if(0 == contiguous)
+                {
+                    p = overflow;
+                    contiguous = sizeof(overflow);
+                }
+
+                qint64 bytesRead = m_socket->read(p, qMin(contiguous, remaining));
+
+                if(bytesRead <= 0)
+                {
+                    break;
+                }
+
+                if(m_capture)
+                {
+                    m_capture->Record(Capture_Direction_t::RX, p, bytesRead);
+                }
+
+                if(p == overflow)
+                {
+                    qDebug() << "RX buffer is full, dropped" << bytesRead << "bytes";
+                    m_rxBuffer.drop(bytesRead);
+                }
+                else
+                {
+                    m_rxBuffer.commit(bytesRead);
+                }
+
+                remaining -= bytesRead;
+            }
+
+            if(0 < GetSocketProfile(m_profile).quickAck)
+            {
+                RearmQuickAck(m_socket);
+            }
+
+            m_rxLastNs = monotonicNs();
+
+            if(wasEmpty)
+            {
+                m_rxFirstNs = m_rxLastNs;
+            }
+
             m_dataReceivedAt = QDateTime::currentMSecsSinceEpoch();
         }
 
-        qDebug() << "Read timeout is set to" << TCP_TIMEOUT(bytesAvailable) << "ms to read" << bytesAvailable << "bytes";
+        qCDebug(lcFrames) << "Read timeout is set to" << TCP_TIMEOUT(bytesAvailable) << "ms to read" << bytesAvailable << "bytes";
         m_timer_rx.start(TCP_TIMEOUT(bytesAvailable));
     }
     else
@@ -279,28 +399,31 @@ void TcpServer::dataReceivedSlot()
 
 void TcpServer::onBytesWritten(qint64 bytes)
 {
+    TRACE_SCOPE("tcp.bytesWritten");
+
     m_bytesWritten += bytes;
 
-    if(m_bytesWritten == m_writeData.size())
+    if(m_bytesWritten == m_writeSize)
     {
+        m_txDoneNs = monotonicNs();
         m_timer_tx.stop();
         m_bytesWritten = 0;
-        qDebug() << "Data successfully sent";
-        Log(QString("Written %1 bytes").arg(m_writeData.size()));
-        //qDebug() << QString("TX:" + m_writeData.toHex());
+        emit txDone(m_txDoneNs);
+        qCDebug(lcFrames) << "Data successfully sent";
+        qCDebug(lcFrames) << "Written" << m_writeSize << "bytes";
     }
     else
     {
-        qint64 bytesToWrite = m_writeData.size() - m_bytesWritten;
-        qDebug() << "Written" << m_bytesWritten << "/" << m_writeData.size();
-        qDebug() << "Write timeout is set to" << TCP_TIMEOUT(bytesToWrite) << "ms to write" << bytesToWrite << "bytes";
+        qint64 bytesToWrite = m_writeSize - m_bytesWritten;
+        qCDebug(lcFrames) << "Written" << m_bytesWritten << "/" << m_writeSize;
+        qCDebug(lcFrames) << "Write timeout is set to" << TCP_TIMEOUT(bytesToWrite) << "ms to write" << bytesToWrite << "bytes";
         m_timer_tx.start(TCP_TIMEOUT(bytesToWrite));
     }
 }
 
 void TcpServer::onTimeoutTX()
 {
-    if(m_bytesWritten != m_writeData.size())
+    if(m_bytesWritten != m_writeSize)
     {
         Log("Write operation timed out");
         qDebug() << "Write operation timed out";
@@ -314,15 +437,16 @@ void TcpServer::onTimeoutTX()
 
 void TcpServer::onTimeoutRX()
 {
-    if(m_readData.isEmpty())
+    TRACE_SCOPE("tcp.rxIdle");
+
+    if(m_rxBuffer.isEmpty())
     {
-        qDebug() << "No data was currently available for reading";
+        qCDebug(lcFrames) << "No data was currently available for reading";
     }
     else
     {
-        qDebug() << "Data successfully received";
-        qDebug() << m_readData.length() << "bytes received.";
-        //qDebug() << QString("RX:" + m_readData.toHex());
+        qCDebug(lcFrames) << "Data successfully received";
+        qCDebug(lcFrames) << m_rxBuffer.size() << "bytes received.";
         emit dataReceived();
     }
 }
@@ -13,6 +13,9 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QtCore>
+#include "traffic_capture.h"
+#include "ring_buffer.h"
+#include "socket_profile.h"
 
 class TcpServer: public QObject
 {
@@ -29,13 +32,22 @@ public:
     bool isListenning();
     bool isClientConnected() const;
     bool Write(const QByteArray &writeData);
-    QByteArray Read();
+    RingBuffer &Read();
+    RingBuffer &getRxBuffer();
+    void setReadBufferSize(qint64);
     void stopServer();
     qint64 getTimeout(qint64 data_size);
     qint64 getReceivedTime();
     qint64 getSentTime();
+    qint64 getRxFirstNs();
+    qint64 getRxLastNs();
+    qint64 getBytesToWrite();
+    void setCapture(TrafficCapture *);
+    void setSocketProfile(Socket_Profile_t);
+    Socket_Profile_t getSocketProfile() const;
 
 signals:
+    void txDone(qint64 ns);     // A write has been handed to the OS completely
     void dataReceived();
     void clientConnected();
     void clientDisconnected();
@@ -61,12 +73,19 @@ private:
     int             m_serverPort;
     qint64          m_dataReceivedAt;
     qint64          m_dataSentAt;
+    qint64          m_rxFirstNs = 0;
+    qint64          m_rxLastNs = 0;
+    qint64          m_txDoneNs = 0;
     bool            m_clientConnected;
-    QByteArray      m_readData;
-    QByteArray      m_writeData;
+    RingBuffer      m_rxBuffer;
+    qint64          m_readBufferSize;
+    qint64          m_writeSize = 0;
     qint64          m_bytesWritten = 0;
     QTimer          m_timer_tx;
     QTimer          m_timer_rx;
+    TrafficCapture *m_capture = nullptr;
+    Socket_Profile_t m_profile = Socket_Profile_t::Default;
+    SocketProfile   m_found = GetSocketProfile(Socket_Profile_t::Default);  // Options of the accepted socket before any profile
 };
 
 #endif // TCP_SERVER_H
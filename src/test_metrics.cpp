@@ -0,0 +1,219 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "test_metrics.h"
+#include <QByteArray>
+
+// Upper bounds of the latency histogram buckets, the last one is +Inf
+const qint64 LATENCY_BUCKET_NS[METRICS_LATENCY_BUCKETS - 1] =
+{
+    100000, 250000, 500000, 1000000, 2500000, 5000000,
+    10000000, 25000000, 50000000, 100000000, 500000000
+};
+
+const char *ERROR_TYPE_NAMES[METRICS_ERROR_TYPES] =
+{
+    "ok", "crc", "length", "header", "timeout", "content", "send"
+};
+
+MetricsShard::MetricsShard()
+{
+    rxFrames = 0;
+    rxBytes = 0;
+    txFrames = 0;
+    txBytes = 0;
+    latencyCount = 0;
+    latencySumNs = 0;
+    resyncs = 0;
+    resyncSkippedBytes = 0;
+    resyncSumNs = 0;
+
+    for(int i = 0; i < METRICS_ERROR_TYPES; i++)
+    {
+        errors[i] = 0;
+    }
+
+    for(int i = 0; i < METRICS_LATENCY_BUCKETS; i++)
+    {
+        latency[i] = 0;
+    }
+}
+
+TestMetrics::TestMetrics()
+{
+    m_rttEstimateNs = 0;
+    m_inFlight = 0;
+    m_rxBufferLevel = 0;
+    m_txBufferLevel = 0;
+}
+
+MetricsShard &TestMetrics::Local()
+{
+    static thread_local MetricsShard *shard = nullptr;
+    static thread_local const TestMetrics *owner = nullptr;
+
+    if(owner != this)
+    {
+        std::lock_guard<std::mutex> lock(m_shardsLock);
+        m_shards.push_back(std::unique_ptr<MetricsShard>(new MetricsShard()));
+        shard = m_shards.back().get();
+        owner = this;
+    }
+
+    return *shard;
+}
+
+void TestMetrics::Add(std::atomic<quint64> &counter, quint64 value)
+{
+    // Single writer per shard, a plain store is enough and avoids a locked add
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void TestMetrics::RX(qint64 bytes)
+{
+    MetricsShard &shard = Local();
+    Add(shard.rxFrames, 1);
+    Add(shard.rxBytes, bytes);
+}
+
+void TestMetrics::TX(qint64 bytes)
+{
+    MetricsShard &shard = Local();
+    Add(shard.txFrames, 1);
+    Add(shard.txBytes, bytes);
+}
+
+void TestMetrics::Error(Frame_Status_t status)
+{
+    Add(Local().errors[static_cast<int>(status)], 1);
+}
+
+void TestMetrics::SendError()
+{
+    Add(Local().errors[METRICS_ERROR_TYPES - 1], 1);
+}
+
+void TestMetrics::Resync(qint64 skippedBytes, qint64 ns)
+{
+    MetricsShard &shard = Local();
+    Add(shard.resyncs, 1);
+    Add(shard.resyncSkippedBytes, skippedBytes);
+    Add(shard.resyncSumNs, ns);
+}
+
+void TestMetrics::Latency(qint64 ns)
+{
+    MetricsShard &shard = Local();
+    int bucket = 0;
+    qint64 estimate;
+
+    while(bucket < METRICS_LATENCY_BUCKETS - 1 && ns > LATENCY_BUCKET_NS[bucket])
+    {
+        bucket++;
+    }
+
+    Add(shard.latency[bucket], 1);
+    Add(shard.latencyCount, 1);
+    Add(shard.latencySumNs, ns);
+    // Smoothed like the TCP SRTT, gain 1/8
+    estimate = m_rttEstimateNs.load(std::memory_order_relaxed);
+    estimate = (0 == estimate) ? ns : estimate + (ns - estimate) / 8;
+    m_rttEstimateNs.store(estimate, std::memory_order_relaxed);
+}
+
+void TestMetrics::setInFlight(qint64 frames)
+{
+    m_inFlight.store(frames, std::memory_order_relaxed);
+}
+
+void TestMetrics::setRxBufferLevel(qint64 bytes)
+{
+    m_rxBufferLevel.store(bytes, std::memory_order_relaxed);
+}
+
+void TestMetrics::setTxBufferLevel(qint64 bytes)
+{
+    m_txBufferLevel.store(bytes, std::memory_order_relaxed);
+}
+
+QByteArray TestMetrics::Render() const
+{
+    MetricsShard sum;
+    QByteArray out;
+    quint64 cumulative = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_shardsLock);
+
+        for(size_t s = 0; s < m_shards.size(); s++)
+        {
+            const MetricsShard &shard = *m_shards[s];
+            Add(sum.rxFrames, shard.rxFrames.load(std::memory_order_relaxed));
+            Add(sum.rxBytes, shard.rxBytes.load(std::memory_order_relaxed));
+            Add(sum.txFrames, shard.txFrames.load(std::memory_order_relaxed));
+            Add(sum.txBytes, shard.txBytes.load(std::memory_order_relaxed));
+            Add(sum.latencyCount, shard.latencyCount.load(std::memory_order_relaxed));
+            Add(sum.latencySumNs, shard.latencySumNs.load(std::memory_order_relaxed));
+            Add(sum.resyncs, shard.resyncs.load(std::memory_order_relaxed));
+            Add(sum.resyncSkippedBytes, shard.resyncSkippedBytes.load(std::memory_order_relaxed));
+            Add(sum.resyncSumNs, shard.resyncSumNs.load(std::memory_order_relaxed));
+
+            for(int i = 0; i < METRICS_ERROR_TYPES; i++)
+            {
+                Add(sum.errors[i], shard.errors[i].load(std::memory_order_relaxed));
+            }
+
+            for(int i = 0; i < METRICS_LATENCY_BUCKETS; i++)
+            {
+                Add(sum.latency[i], shard.latency[i].load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    out.reserve(4096);
+    out += "# TYPE qcommtest_rx_frames counter\n";
+    out += "qcommtest_rx_frames_total " + QByteArray::number(sum.rxFrames.load()) + "\n";
+    out += "# TYPE qcommtest_rx_bytes counter\n";
+    out += "qcommtest_rx_bytes_total " + QByteArray::number(sum.rxBytes.load()) + "\n";
+    out += "# TYPE qcommtest_tx_frames counter\n";
+    out += "qcommtest_tx_frames_total " + QByteArray::number(sum.txFrames.load()) + "\n";
+    out += "# TYPE qcommtest_tx_bytes counter\n";
+    out += "qcommtest_tx_bytes_total " + QByteArray::number(sum.txBytes.load()) + "\n";
+    out += "# TYPE qcommtest_errors counter\n";
+
+    for(int i = 1; i < METRICS_ERROR_TYPES; i++)
+    {
+        out += QByteArray("qcommtest_errors_total{type=\"") + ERROR_TYPE_NAMES[i] + "\"} " + QByteArray::number(sum.errors[i].load()) + "\n";
+    }
+
+    out += "# TYPE qcommtest_resyncs counter\n";
+    out += "qcommtest_resyncs_total " + QByteArray::number(sum.resyncs.load()) + "\n";
+    out += "# TYPE qcommtest_resync_skipped_bytes counter\n";
+    out += "qcommtest_resync_skipped_bytes_total " + QByteArray::number(sum.resyncSkippedBytes.load()) + "\n";
+    out += "# TYPE qcommtest_resync_seconds counter\n";
+    out += "qcommtest_resync_seconds_total " + QByteArray::number(sum.resyncSumNs.load() / 1e9, 'g', 12) + "\n";
+    out += "# TYPE qcommtest_rtt_estimate_seconds gauge\n";
+    out += "qcommtest_rtt_estimate_seconds " + QByteArray::number(m_rttEstimateNs.load() / 1e9, 'g', 9) + "\n";
+    out += "# TYPE qcommtest_frame_latency_seconds histogram\n";
+
+    for(int i = 0; i < METRICS_LATENCY_BUCKETS; i++)
+    {
+        QByteArray le = (i < METRICS_LATENCY_BUCKETS - 1) ? QByteArray::number(LATENCY_BUCKET_NS[i] / 1e9, 'g', 9) : QByteArray("+Inf");
+        cumulative += sum.latency[i].load();
+        out += "qcommtest_frame_latency_seconds_bucket{le=\"" + le + "\"} " + QByteArray::number(cumulative) + "\n";
+    }
+
+    out += "qcommtest_frame_latency_seconds_sum " + QByteArray::number(sum.latencySumNs.load() / 1e9, 'g', 12) + "\n";
+    out += "qcommtest_frame_latency_seconds_count " + QByteArray::number(sum.latencyCount.load()) + "\n";
+    out += "# TYPE qcommtest_inflight_frames gauge\n";
+    out += "qcommtest_inflight_frames " + QByteArray::number(m_inFlight.load()) + "\n";
+    out += "# TYPE qcommtest_rx_buffer_bytes gauge\n";
+    out += "qcommtest_rx_buffer_bytes " + QByteArray::number(m_rxBufferLevel.load()) + "\n";
+    out += "# TYPE qcommtest_tx_buffer_bytes gauge\n";
+    out += "qcommtest_tx_buffer_bytes " + QByteArray::number(m_txBufferLevel.load()) + "\n";
+    out += "# EOF\n";
+    return out;
+}
@@ -0,0 +1,69 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef TEST_METRICS_H
+#define TEST_METRICS_H
+
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "frame_trace.h"
+
+const int METRICS_ERROR_TYPES       = 7;    // Frame_Status_t values and send failures
+const int METRICS_LATENCY_BUCKETS   = 12;
+
+// Counters of one writer thread, only that thread stores into them
+struct MetricsShard
+{
+    std::atomic<quint64>    rxFrames;
+    std::atomic<quint64>    rxBytes;
+    std::atomic<quint64>    txFrames;
+    std::atomic<quint64>    txBytes;
+    std::atomic<quint64>    errors[METRICS_ERROR_TYPES];
+    std::atomic<quint64>    latency[METRICS_LATENCY_BUCKETS];
+    std::atomic<quint64>    latencyCount;
+    std::atomic<quint64>    latencySumNs;
+    std::atomic<quint64>    resyncs;
+    std::atomic<quint64>    resyncSkippedBytes;
+    std::atomic<quint64>    resyncSumNs;
+
+    MetricsShard();
+};
+
+/*
+    Live test counters. The hot path only does relaxed loads and stores on its own
+    shard, the scraper sums all shards without ever blocking the writers.
+*/
+class TestMetrics
+{
+public:
+    TestMetrics();
+    void RX(qint64 bytes);
+    void TX(qint64 bytes);
+    void Error(Frame_Status_t status);
+    void SendError();
+    void Latency(qint64 ns);
+    void Resync(qint64 skippedBytes, qint64 ns);
+    void setInFlight(qint64 frames);
+    void setRxBufferLevel(qint64 bytes);
+    void setTxBufferLevel(qint64 bytes);
+    QByteArray Render() const;
+
+private:
+    MetricsShard &Local();
+    static void Add(std::atomic<quint64> &counter, quint64 value);
+
+    mutable std::mutex                          m_shardsLock;   // Taken on shard registration and scrape only
+    std::vector<std::unique_ptr<MetricsShard>>  m_shards;
+    std::atomic<qint64>                         m_rttEstimateNs;
+    std::atomic<qint64>                         m_inFlight;
+    std::atomic<qint64>                         m_rxBufferLevel;
+    std::atomic<qint64>                         m_txBufferLevel;
+};
+
+#endif // TEST_METRICS_H
@@ -0,0 +1,265 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "test_plan.h"
+#include "protocol.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+const int PLAN_RESULT_VERSION   = 1;
+
+int PlanPhase::Sizes() const
+{
+    return qAbs(sizeTo - sizeFrom) / sizeStep + 1;
+}
+
+qint64 PlanPhase::Frames() const
+{
+    return (qint64)Sizes() * repeat;
+}
+
+int PlanPhase::SizeAt(qint64 frame) const
+{
+    int step = static_cast<int>(frame / repeat) * sizeStep;
+    return (sizeTo < sizeFrom) ? sizeFrom - step : sizeFrom + step;
+}
+
+TestPlan TestPlan::Default()
+{
+    // The built-in sweep, one frame of every size from 1 to 400 bytes
+    TestPlan plan;
+    PlanPhase phase;
+    phase.name = "sweep";
+    plan.m_name = "default";
+    plan.m_phases.append(phase);
+    return plan;
+}
+
+TestPlan TestPlan::FromPhase(const QString &name, const PlanPhase &phase)
+{
+    TestPlan plan;
+    plan.m_name = name;
+    plan.m_phases.append(phase);
+    return plan;
+}
+
+bool TestPlan::Load(const QString &path, QString &error)
+{
+    QFile file(path);
+    QJsonParseError parseError;
+    QJsonDocument document;
+    QJsonArray phases;
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        error = "Unable to open test plan " + path + " : " + file.errorString();
+        return false;
+    }
+
+    document = QJsonDocument::fromJson(file.readAll(), &parseError);
+
+    if(!document.isObject())
+    {
+        error = QString("Test plan %1 : %2 at offset %3").arg(path).arg(parseError.errorString()).arg(parseError.offset);
+        return false;
+    }
+
+    m_name = document.object()["name"].toString(path);
+    m_phases.clear();
+    phases = document.object()["phases"].toArray();
+
+    for(int i = 0; i < phases.size(); i++)
+    {
+        QJsonObject object = phases[i].toObject();
+        QJsonObject size = object["size"].toObject();
+        QJsonObject pass = object["pass"].toObject();
+        PlanPhase phase;
+
+        phase.name = object["name"].toString(QString("phase %1").arg(i + 1));
+        phase.sizeFrom = size["from"].toInt(phase.sizeFrom);
+        phase.sizeTo = size["to"].toInt(phase.sizeTo);
+        phase.sizeStep = size["step"].toInt(phase.sizeStep);
+        phase.repeat = object["repeat"].toInt(phase.repeat);
+        phase.window = object["window"].toInt(phase.window);
+        phase.rate = object["rate"].toDouble(phase.rate);
+        phase.payload = object["payload"].toString();
+        phase.frameTimeout = object["frame_timeout_ms"].toInt(phase.frameTimeout);
+        phase.maxErrors = static_cast<qint64>(pass["max_errors"].toDouble(phase.maxErrors));
+        phase.maxP99 = pass["max_p99_us"].toDouble(phase.maxP99);
+        phase.minThroughput = pass["min_throughput_kbps"].toDouble(phase.minThroughput);
+
+        if(phase.sizeFrom < 1 || PROTOCOL_MAX_PAYLOAD < phase.sizeFrom || phase.sizeTo < 1 || PROTOCOL_MAX_PAYLOAD < phase.sizeTo)
+        {
+            error = QString("Test plan phase \"%1\" : sizes must be 1..%2").arg(phase.name).arg(PROTOCOL_MAX_PAYLOAD);
+            return false;
+        }
+
+        if(phase.sizeStep < 1 || phase.repeat < 1 || phase.frameTimeout < 1 || phase.rate < 0)
+        {
+            error = QString("Test plan phase \"%1\" : step, repeat and frame_timeout_ms must be positive").arg(phase.name);
+            return false;
+        }
+
+        if(phase.window < 1 || PROTOCOL_MAX_WINDOW < phase.window)
+        {
+            error = QString("Test plan phase \"%1\" : window must be 1..%2").arg(phase.name).arg(PROTOCOL_MAX_WINDOW);
+            return false;
+        }
+
+        m_phases.append(phase);
+    }
+
+    if(m_phases.isEmpty())
+    {
+        error = "Test plan " + path + " has no phases";
+        return false;
+    }
+
+    return true;
+}
+
+const QString &TestPlan::getName() const
+{
+    return m_name;
+}
+
+int TestPlan::count() const
+{
+    return m_phases.size();
+}
+
+const PlanPhase &TestPlan::phase(int index) const
+{
+    return m_phases[index];
+}
+
+void TestPlan::setPhase(int index, const PlanPhase &phase)
+{
+    m_phases[index] = phase;
+}
+
+qint64 TestPlan::TotalFrames() const
+{
+    qint64 frames = 0;
+
+    for(const PlanPhase &phase : m_phases)
+    {
+        frames += phase.Frames();
+    }
+
+    return frames;
+}
+
+int TestPlan::MaxSize() const
+{
+    int size = 0;
+
+    for(const PlanPhase &phase : m_phases)
+    {
+        size = qMax(size, qMax(phase.sizeFrom, phase.sizeTo));
+    }
+
+    return size;
+}
+
+int TestPlan::MaxWindow() const
+{
+    int window = 1;
+
+    for(const PlanPhase &phase : m_phases)
+    {
+        window = qMax(window, phase.window);
+    }
+
+    return window;
+}
+
+void TestPlan::Evaluate(const PlanPhase &phase, PhaseResult &result)
+{
+    result.failures.clear();
+
+    if(0 <= phase.maxErrors && phase.maxErrors < result.errors)
+    {
+        result.failures << QString("%1 errors, at most %2 allowed").arg(result.errors).arg(phase.maxErrors);
+    }
+
+    if(0 < phase.maxP99 && phase.maxP99 < result.p99)
+    {
+        result.failures << QString("p99 %1 us above %2 us").arg(result.p99, 0, 'f', 1).arg(phase.maxP99, 0, 'f', 1);
+    }
+
+    if(0 < phase.minThroughput && result.throughput < phase.minThroughput)
+    {
+        result.failures << QString("%1 KB/s below %2 KB/s").arg(result.throughput, 0, 'f', 1).arg(phase.minThroughput, 0, 'f', 1);
+    }
+
+    result.passed = result.failures.isEmpty();
+}
+
+QString TestPlan::FormatResults(const QVector<PhaseResult> &results)
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6 %7")
+          .arg(QLatin1String("phase"), -16).arg(QLatin1String("frames"), 7).arg(QLatin1String("errors"), 7)
+          .arg(QLatin1String("KB/s"), 9).arg(QLatin1String("p50 us"), 9).arg(QLatin1String("p99 us"), 9).arg(QLatin1String("result"), 7);
+
+    for(const PhaseResult &result : results)
+    {
+        lines << QString("%1 %2 %3 %4 %5 %6 %7")
+              .arg(result.name, -16).arg(result.frames, 7).arg(result.errors, 7).arg(result.throughput, 9, 'f', 1)
+              .arg(result.p50, 9, 'f', 1).arg(result.p99, 9, 'f', 1).arg(QLatin1String(result.passed ? "pass" : "FAIL"), 7);
+
+        for(const QString &failure : result.failures)
+        {
+            lines << "    " + failure;
+        }
+    }
+
+    return lines.join('\n');
+}
+
+bool TestPlan::SaveResults(const QString &path, const QString &planName, const QVector<PhaseResult> &results)
+{
+    QJsonObject root;
+    QJsonArray phases;
+    QFile file(path);
+    bool passed = true;
+
+    for(const PhaseResult &result : results)
+    {
+        QJsonObject phase;
+        phase["name"] = result.name;
+        phase["frames"] = result.frames;
+        phase["errors"] = result.errors;
+        phase["bytes"] = result.bytes;
+        phase["seconds"] = result.seconds;
+        phase["throughput_kbps"] = result.throughput;
+        phase["p50_us"] = result.p50;
+        phase["p99_us"] = result.p99;
+        phase["max_us"] = result.max;
+        phase["passed"] = result.passed;
+        phase["failures"] = QJsonArray::fromStringList(result.failures);
+        phases.append(phase);
+        passed &= result.passed;
+    }
+
+    root["version"] = PLAN_RESULT_VERSION;
+    root["plan"] = planName;
+    root["passed"] = passed;
+    root["phases"] = phases;
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Unable to write plan results" << path << ":" << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+    return true;
+}
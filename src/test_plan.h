@@ -0,0 +1,80 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef TEST_PLAN_H
+#define TEST_PLAN_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// One step of a test plan, every size of the range is sent repeat times
+struct PlanPhase
+{
+    QString name;
+    int     sizeFrom = 1;           // [bytes] payload
+    int     sizeTo = 400;           // [bytes] payload, below sizeFrom for a falling sweep
+    int     sizeStep = 1;           // [bytes]
+    int     repeat = 1;             // Frames per size
+    int     window = 1;             // Frames in flight
+    double  rate = 0;               // [frames/s] 0 sends as fast as the echoes allow
+    QString payload;                // Payload spec, empty keeps the session pattern
+    int     frameTimeout = 500;     // [ms] on top of the wire time of the frame
+    qint64  maxErrors = 0;          // -1 for no limit
+    double  maxP99 = 0;             // [us] 0 for no limit
+    double  minThroughput = 0;      // [KB/s] 0 for no limit
+
+    int Sizes() const;
+    qint64 Frames() const;
+    int SizeAt(qint64 frame) const;
+};
+
+struct PhaseResult
+{
+    QString     name;
+    qint64      frames = 0;
+    qint64      errors = 0;
+    qint64      bytes = 0;          // Payload bytes echoed
+    double      seconds = 0;
+    double      throughput = 0;     // [KB/s] payload both ways
+    double      p50 = 0;            // [us]
+    double      p99 = 0;            // [us]
+    double      max = 0;            // [us]
+    bool        passed = false;
+    QStringList failures;
+};
+
+/*
+    Declarative test plan, a JSON file with a list of phases:
+    { "name": "...", "phases": [ { "name": "...", "size": { "from": 1, "to": 400, "step": 1 },
+      "repeat": 1, "window": 1, "rate": 0, "payload": "ramp", "frame_timeout_ms": 500,
+      "pass": { "max_errors": 0, "max_p99_us": 0, "min_throughput_kbps": 0 } } ] }
+    Every key is optional, missing ones take the defaults of PlanPhase.
+*/
+class TestPlan
+{
+public:
+    static TestPlan Default();
+    static TestPlan FromPhase(const QString &name, const PlanPhase &phase);
+    bool Load(const QString &path, QString &error);
+    const QString &getName() const;
+    int count() const;
+    const PlanPhase &phase(int index) const;
+    void setPhase(int index, const PlanPhase &phase);
+    qint64 TotalFrames() const;
+    int MaxSize() const;
+    int MaxWindow() const;
+
+    static void Evaluate(const PlanPhase &phase, PhaseResult &result);
+    static QString FormatResults(const QVector<PhaseResult> &results);
+    static bool SaveResults(const QString &path, const QString &planName, const QVector<PhaseResult> &results);
+
+private:
+    QString             m_name;
+    QVector<PlanPhase>  m_phases;
+};
+
+#endif // TEST_PLAN_H
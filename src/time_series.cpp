@@ -0,0 +1,227 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "time_series.h"
+#include <cmath>
+
+const qint64 LEVEL_WIDTH_NS[SERIES_LEVELS] =
+{
+    1000000000LL, 10000000000LL, 60000000000LL
+};
+
+const int LEVEL_LENGTH[SERIES_LEVELS] =
+{
+    300, 360, 1440
+};
+
+TimeSeriesRing::TimeSeriesRing()
+{
+    for(int level = 0; level < SERIES_LEVELS; level++)
+    {
+        m_levels[level].resize(LEVEL_LENGTH[level]);
+    }
+}
+
+SeriesBucket &TimeSeriesRing::Bucket(int level, qint64 nowNs)
+{
+    qint64 index = nowNs / LEVEL_WIDTH_NS[level];
+    SeriesBucket &bucket = m_levels[level][index % LEVEL_LENGTH[level]];
+
+    // A slot still holding an older bucket is recycled in place
+    if(bucket.index != index)
+    {
+        bucket = SeriesBucket();
+        bucket.index = index;
+    }
+
+    return bucket;
+}
+
+void TimeSeriesRing::AddBytes(qint64 nowNs, qint64 bytes)
+{
+    for(int level = 0; level < SERIES_LEVELS; level++)
+    {
+        Bucket(level, nowNs).bytes += bytes;
+    }
+
+    m_total.bytes += bytes;
+}
+
+void TimeSeriesRing::AddFrame(qint64 nowNs, qint64 latencyNs, bool error)
+{
+    int bin = -1;
+
+    if(0 < latencyNs)
+    {
+        // Quarter octave bins starting at 1 us
+        bin = qBound(0, (int)(4 * std::log2(qMax(1.0, latencyNs / 1000.0))), SERIES_LATENCY_BINS - 1);
+    }
+
+    for(int level = 0; level < SERIES_LEVELS; level++)
+    {
+        SeriesBucket &bucket = Bucket(level, nowNs);
+        bucket.frames++;
+
+        if(error)
+        {
+            bucket.errors++;
+        }
+
+        if(0 <= bin)
+        {
+            bucket.latency[bin]++;
+        }
+    }
+
+    m_total.frames++;
+    m_total.errors += error ? 1 : 0;
+
+    if(0 <= bin)
+    {
+        m_total.latency[bin]++;
+    }
+}
+
+int TimeSeriesRing::getLength(Series_Level_t level) const
+{
+    return LEVEL_LENGTH[static_cast<int>(level)];
+}
+
+qint64 TimeSeriesRing::getWidthNs(Series_Level_t level) const
+{
+    return LEVEL_WIDTH_NS[static_cast<int>(level)];
+}
+
+template<typename Count>
+double TimeSeriesRing::Percentile(const Count (&latency)[SERIES_LATENCY_BINS], double q)
+{
+    quint64 total = 0, seen = 0;
+
+    for(int i = 0; i < SERIES_LATENCY_BINS; i++)
+    {
+        total += latency[i];
+    }
+
+    if(0 == total)
+    {
+        return 0;
+    }
+
+    for(int i = 0; i < SERIES_LATENCY_BINS; i++)
+    {
+        seen += latency[i];
+
+        if(seen >= q * total)
+        {
+            // Upper edge of the bin
+            return std::exp2((i + 1) / 4.0);
+        }
+    }
+
+    return std::exp2(SERIES_LATENCY_BINS / 4.0);
+}
+
+SeriesPoint TimeSeriesRing::getPoint(Series_Level_t level, qint64 nowNs, int age) const
+{
+    int l = static_cast<int>(level);
+    qint64 index = nowNs / LEVEL_WIDTH_NS[l] - age;
+    SeriesPoint point = { false, 0, 0, 0, 0 };
+
+    if(index < 0 || age >= LEVEL_LENGTH[l])
+    {
+        return point;
+    }
+
+    const SeriesBucket &bucket = m_levels[l][index % LEVEL_LENGTH[l]];
+
+    if(bucket.index != index)
+    {
+        // Nothing happened in that interval
+        point.valid = true;
+        return point;
+    }
+
+    point.valid = true;
+    point.throughput = bucket.bytes / 1024.0 / (LEVEL_WIDTH_NS[l] / 1e9);
+    point.p50 = Percentile(bucket.latency, 0.5);
+    point.p99 = Percentile(bucket.latency, 0.99);
+    point.errorRate = bucket.frames ? 100.0 * bucket.errors / bucket.frames : 0;
+    return point;
+}
+
+SeriesWindow TimeSeriesRing::getWindow(Series_Level_t level, qint64 nowNs, int buckets) const
+{
+    int l = static_cast<int>(level);
+    qint64 index = nowNs / LEVEL_WIDTH_NS[l];
+    SeriesSum merged;
+
+    buckets = qMin(buckets, LEVEL_LENGTH[l]);
+
+    for(int age = 0; age < buckets && 0 <= index - age; age++)
+    {
+        const SeriesBucket &bucket = m_levels[l][(index - age) % LEVEL_LENGTH[l]];
+
+        if(bucket.index == index - age)
+        {
+            Merge(merged, bucket);
+        }
+    }
+
+    return Summarize(merged, buckets * (LEVEL_WIDTH_NS[l] / 1e9));
+}
+
+SeriesWindow TimeSeriesRing::getTotal(qint64 nowNs) const
+{
+    return Summarize(m_total, (nowNs - m_totalSince) / 1e9);
+}
+
+void TimeSeriesRing::ResetTotal(qint64 nowNs)
+{
+    m_total = SeriesSum();
+    m_totalSince = nowNs;
+}
+
+void TimeSeriesRing::Merge(SeriesSum &into, const SeriesBucket &bucket)
+{
+    into.frames += bucket.frames;
+    into.bytes += bucket.bytes;
+    into.errors += bucket.errors;
+
+    for(int i = 0; i < SERIES_LATENCY_BINS; i++)
+    {
+        into.latency[i] += bucket.latency[i];
+    }
+}
+
+SeriesWindow TimeSeriesRing::Summarize(const SeriesSum &sum, double seconds)
+{
+    SeriesWindow window;
+    window.frames = sum.frames;
+    window.bytes = sum.bytes;
+    window.errors = sum.errors;
+    window.seconds = seconds;
+    window.throughput = (0 < seconds) ? sum.bytes / 1024.0 / seconds : 0;
+    window.p50 = Percentile(sum.latency, 0.5);
+    window.p99 = Percentile(sum.latency, 0.99);
+    return window;
+}
+
+const char *TimeSeriesRing::LevelName(Series_Level_t level)
+{
+    switch(level)
+    {
+        case Series_Level_t::Second:
+            return "1 s";
+
+        case Series_Level_t::TenSeconds:
+            return "10 s";
+
+        case Series_Level_t::Minute:
+            return "1 min";
+    }
+
+    return "";
+}
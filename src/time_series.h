@@ -0,0 +1,95 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+#include <QtGlobal>
+#include <vector>
+
+const int SERIES_LATENCY_BINS   = 94;   // Quarter octaves from 1 us to about 12 s, the last bin holds everything above
+const int SERIES_LEVELS         = 3;
+
+enum class Series_Level_t
+{
+    Second = 0,     // 1 s buckets, 5 minutes
+    TenSeconds,     // 10 s buckets, 1 hour
+    Minute          // 1 min buckets, 24 hours
+};
+
+struct SeriesBucket
+{
+    qint64  index = -1;         // Bucket number since the clock epoch, -1 = never used
+    quint64 frames = 0;
+    quint64 bytes = 0;
+    quint64 errors = 0;
+    quint32 latency[SERIES_LATENCY_BINS] = {};
+};
+
+// Buckets merged over a window or the whole run, 64-bit bins as a day at 50k frames/s overflows 32 bits
+struct SeriesSum
+{
+    quint64 frames = 0;
+    quint64 bytes = 0;
+    quint64 errors = 0;
+    quint64 latency[SERIES_LATENCY_BINS] = {};
+};
+
+struct SeriesPoint
+{
+    bool    valid;
+    double  throughput;         // [KB/s]
+    double  p50;                // [us]
+    double  p99;                // [us]
+    double  errorRate;          // [%] of frames
+};
+
+// Several buckets merged into one, or everything since ResetTotal()
+struct SeriesWindow
+{
+    quint64 frames = 0;
+    quint64 bytes = 0;
+    quint64 errors = 0;
+    double  seconds = 0;        // [s] span covered
+    double  throughput = 0;     // [KB/s]
+    double  p50 = 0;            // [us]
+    double  p99 = 0;            // [us]
+};
+
+/*
+    Fixed-size multi-resolution time series, every level is a ring of buckets.
+    Adding touches one bucket per level, memory never grows however long the run.
+*/
+class TimeSeriesRing
+{
+public:
+    TimeSeriesRing();
+    void AddBytes(qint64 nowNs, qint64 bytes);
+    void AddFrame(qint64 nowNs, qint64 latencyNs, bool error);
+    int getLength(Series_Level_t level) const;
+    qint64 getWidthNs(Series_Level_t level) const;
+    // age 0 is the bucket covering nowNs, higher ages go back in time
+    SeriesPoint getPoint(Series_Level_t level, qint64 nowNs, int age) const;
+    // The last buckets of a level, the one covering nowNs included
+    SeriesWindow getWindow(Series_Level_t level, qint64 nowNs, int buckets) const;
+    SeriesWindow getTotal(qint64 nowNs) const;
+    void ResetTotal(qint64 nowNs);
+
+    static const char *LevelName(Series_Level_t level);
+
+private:
+    SeriesBucket &Bucket(int level, qint64 nowNs);
+    template<typename Count>
+    static double Percentile(const Count (&latency)[SERIES_LATENCY_BINS], double q);
+    static void Merge(SeriesSum &into, const SeriesBucket &bucket);
+    static SeriesWindow Summarize(const SeriesSum &sum, double seconds);
+
+    std::vector<SeriesBucket>   m_levels[SERIES_LEVELS];   // Sized once in the constructor
+    SeriesSum                   m_total;
+    qint64                      m_totalSince = 0;           // [ns]
+};
+
+#endif // TIME_SERIES_H
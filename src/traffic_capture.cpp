@@ -0,0 +1,226 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "traffic_capture.h"
+#include "mono_clock.h"
+#include <QDateTime>
+#include <QtEndian>
+#include <QDebug>
+
+const char CAPTURE_MAGIC[]          = "QCAP";
+const quint16 CAPTURE_VERSION       = 1;
+const int CAPTURE_HEADER_SIZE       = 16;       // [bytes]
+const int CAPTURE_RECORD_HEADER     = 13;       // [bytes]
+const int CAPTURE_FLUSH_SIZE        = 64 * 1024;  // [bytes] handed to the writer thread at once
+
+CaptureWriter::CaptureWriter(QObject *parent) : QObject(parent)
+{
+}
+
+void CaptureWriter::open(const QString &path)
+{
+    m_file.setFileName(path);
+
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered))
+    {
+        emit error("Unable to open " + path + " : " + m_file.errorString());
+    }
+}
+
+bool CaptureWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void CaptureWriter::write(const QByteArray &chunk)
+{
+    if(m_file.isOpen() && m_file.write(chunk) != chunk.size())
+    {
+        emit error("Write error : " + m_file.errorString());
+    }
+}
+
+void CaptureWriter::close()
+{
+    if(m_file.isOpen())
+    {
+        m_file.close();
+    }
+}
+
+//---------------------------------------------------------------
+
+TrafficCapture::TrafficCapture(QObject *parent) : QObject(parent)
+{
+    m_writer = new CaptureWriter();
+    m_writer->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_writer, &QObject::deleteLater);
+    // Blocking so that Start() knows whether the file could be created
+    connect(this, &TrafficCapture::openFile, m_writer, &CaptureWriter::open, Qt::BlockingQueuedConnection);
+    connect(this, &TrafficCapture::writeChunk, m_writer, &CaptureWriter::write);
+    // Blocking so that every queued chunk is on disk when Stop() returns
+    connect(this, &TrafficCapture::closeFile, m_writer, &CaptureWriter::close, Qt::BlockingQueuedConnection);
+    connect(m_writer, &CaptureWriter::error, this, &TrafficCapture::Log);
+}
+
+TrafficCapture::~TrafficCapture()
+{
+    Stop();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void TrafficCapture::Log(const QString &log)
+{
+    emit logMessage("Capture : " + log);
+}
+
+bool TrafficCapture::isActive() const
+{
+    return m_active;
+}
+
+bool TrafficCapture::Start(const QString &path)
+{
+    uchar header[CAPTURE_HEADER_SIZE];
+
+    if(m_active)
+    {
+        Stop();
+    }
+
+    if(!m_thread.isRunning())
+    {
+        m_thread.start(QThread::LowPriority);
+    }
+
+    emit openFile(path);
+
+    // The writer is idle until the next queued call, its state can be read here
+    if(!m_writer->isOpen())
+    {
+        Log("Unable to record to " + path);
+        return false;
+    }
+
+    memcpy(header, CAPTURE_MAGIC, 4);
+    qToLittleEndian<quint16>(CAPTURE_VERSION, &header[4]);
+    qToLittleEndian<quint16>(0, &header[6]);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), &header[8]);
+    m_buffer.clear();
+    m_buffer.reserve(CAPTURE_FLUSH_SIZE + CAPTURE_RECORD_HEADER);
+    m_buffer.append((const char *)header, CAPTURE_HEADER_SIZE);
+    m_startedAt = monotonicNs();
+    m_records = 0;
+    m_bytes = 0;
+    m_active = true;
+    Log("Recording to " + path);
+    return true;
+}
+
+void TrafficCapture::Stop()
+{
+    if(m_active)
+    {
+        Flush();
+        emit closeFile();
+        m_active = false;
+        Log(QString("Stopped, %1 records, %2 bytes").arg(m_records).arg(m_bytes));
+    }
+}
+
+void TrafficCapture::Record(Capture_Direction_t direction, const QByteArray &data)
+{
+    Record(direction, data.constData(), data.size());
+}
+
+void TrafficCapture::Record(Capture_Direction_t direction, const char *data, qint64 size)
+{
+    uchar header[CAPTURE_RECORD_HEADER];
+
+    if(!m_active || size <= 0)
+    {
+        return;
+    }
+
+    qToLittleEndian<qint64>(monotonicNs() - m_startedAt, &header[0]);
+    header[8] = static_cast<uchar>(direction);
+    qToLittleEndian<quint32>(static_cast<quint32>(size), &header[9]);
+    m_buffer.append((const char *)header, CAPTURE_RECORD_HEADER);
+    m_buffer.append(data, size);
+    m_records++;
+    m_bytes += size;
+
+    if(CAPTURE_FLUSH_SIZE <= m_buffer.size())
+    {
+        Flush();
+    }
+}
+
+void TrafficCapture::Flush()
+{
+    if(m_buffer.size())
+    {
+        // The writer thread takes the shared buffer, a fresh one is used from here on
+        emit writeChunk(m_buffer);
+        m_buffer = QByteArray();
+        m_buffer.reserve(CAPTURE_FLUSH_SIZE + CAPTURE_RECORD_HEADER);
+    }
+}
+
+bool TrafficCapture::Load(const QString &path, QByteArray &content, QVector<CaptureRecord> &records)
+{
+    QFile file(path);
+    const uchar *b;
+    qint64 pos;
+
+    records.clear();
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Unable to open capture" << path << ":" << file.errorString();
+        return false;
+    }
+
+    content = file.readAll();
+    b = (const uchar *)content.constData();
+
+    if(content.size() != file.size())
+    {
+        // Beyond what a QByteArray holds on Qt 5, or a read error
+        qDebug() << "Unable to read capture" << path << ":" << file.size() << "bytes";
+        return false;
+    }
+
+    if(content.size() < CAPTURE_HEADER_SIZE || 0 != memcmp(b, CAPTURE_MAGIC, 4) ||
+            CAPTURE_VERSION != qFromLittleEndian<quint16>(&b[4]))
+    {
+        qDebug() << "Not a capture file" << path;
+        return false;
+    }
+
+    pos = CAPTURE_HEADER_SIZE;
+
+    while(pos + CAPTURE_RECORD_HEADER <= content.size())
+    {
+        CaptureRecord record;
+        record.timestamp = qFromLittleEndian<qint64>(&b[pos]);
+        record.direction = static_cast<Capture_Direction_t>(b[pos + 8]);
+        record.length = static_cast<qint32>(qFromLittleEndian<quint32>(&b[pos + 9]));
+        record.offset = pos + CAPTURE_RECORD_HEADER;
+
+        if(record.length < 0 || content.size() - record.offset < record.length)
+        {
+            qDebug() << "Truncated capture record at" << pos;
+            break;
+        }
+
+        records.append(record);
+        pos = record.offset + record.length;
+    }
+
+    return true;
+}
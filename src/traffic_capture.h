@@ -0,0 +1,88 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef TRAFFIC_CAPTURE_H
+#define TRAFFIC_CAPTURE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QThread>
+#include <QFile>
+
+/*
+    Capture file layout (little endian)
+    Header  : "QCAP" | version16 | reserved16 | start time64 [ms since epoch]
+    Record  : timestamp64 [ns since capture start] | direction8 | length32 | data
+*/
+enum class Capture_Direction_t : quint8
+{
+    RX = 0,
+    TX = 1
+};
+
+struct CaptureRecord
+{
+    qint64              timestamp;  // [ns] since capture start
+    Capture_Direction_t direction;
+    qint64              offset;     // Data offset in the loaded capture
+    qint32              length;
+};
+
+// Lives in the writer thread, owns the file
+class CaptureWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CaptureWriter(QObject *parent = nullptr);
+    bool isOpen() const;
+
+public slots:
+    void open(const QString &path);
+    void write(const QByteArray &chunk);
+    void close();
+
+signals:
+    void error(const QString &);
+
+private:
+    QFile           m_file;
+};
+
+class TrafficCapture : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TrafficCapture(QObject *parent = nullptr);
+    ~TrafficCapture();
+    bool Start(const QString &path);
+    void Stop();
+    bool isActive() const;
+    void Record(Capture_Direction_t direction, const char *data, qint64 size);
+    void Record(Capture_Direction_t direction, const QByteArray &data);
+    void Flush();
+
+    static bool Load(const QString &path, QByteArray &content, QVector<CaptureRecord> &records);
+
+signals:
+    void logMessage(const QString &);
+    void openFile(const QString &);
+    void writeChunk(const QByteArray &);
+    void closeFile();
+
+private:
+    void Log(const QString &);
+
+    QThread         m_thread;
+    CaptureWriter  *m_writer = nullptr;
+    QByteArray      m_buffer;
+    qint64          m_startedAt = 0;
+    qint64          m_records = 0;
+    qint64          m_bytes = 0;
+    bool            m_active = false;
+};
+
+#endif // TRAFFIC_CAPTURE_H
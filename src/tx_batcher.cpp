@@ -0,0 +1,165 @@
+/*
+    qCommTest - Serial Communication Test Tool
+    Version  : 1.0
+    Date     : 20.11.2017
+    Author   : Eray Ozturk  | github.com/diffstorm
+*/
+#include "tx_batcher.h"
+#include "mono_clock.h"
+#include <QStringList>
+
+const int BATCH_MAX_FRAMES      = 1024;
+const int BATCH_MAX_BYTES       = 1024 * 1024;  // [bytes]
+const int BATCH_MAX_LINGER      = 1000000;      // [us]
+
+bool BatchPolicy::Parse(const QString &spec, BatchPolicy &policy, QString &error)
+{
+    policy = BatchPolicy();
+
+    for(const QString &item : spec.split(',', Qt::SkipEmptyParts))
+    {
+        QStringList pair = item.split('=');
+        QString key = pair.value(0).trimmed();
+        QString value = pair.value(1).trimmed();
+        bool ok = (2 == pair.size());
+
+        if(ok && "frames" == key)
+        {
+            policy.frames = value.toInt(&ok);
+        }
+        else if(ok && "bytes" == key)
+        {
+            policy.bytes = value.toInt(&ok);
+        }
+        else if(ok && "us" == key)
+        {
+            policy.linger = value.toInt(&ok);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if(!ok)
+        {
+            error = "Invalid batch parameter " + item;
+            return false;
+        }
+    }
+
+    if(policy.frames < 0 || BATCH_MAX_FRAMES < policy.frames || policy.bytes < 0 || BATCH_MAX_BYTES < policy.bytes ||
+            policy.linger < 0 || BATCH_MAX_LINGER < policy.linger)
+    {
+        error = "Batch parameter out of range";
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------
+
+void TxBatcher::setPolicy(const BatchPolicy &policy)
+{
+    m_policy = policy;
+    // A single frame per write is what the engine does without a batcher
+    m_enabled = 1 != policy.frames;
+}
+
+const BatchPolicy &TxBatcher::getPolicy() const
+{
+    return m_policy;
+}
+
+bool TxBatcher::isEnabled() const
+{
+    return m_enabled;
+}
+
+void TxBatcher::Reserve(int frameSize)
+{
+    if(!m_enabled)
+    {
+        return;
+    }
+
+    int frames = m_policy.frames ? m_policy.frames : 1;
+    // A frame that does not fit the byte limit goes alone, so one frame more than the limit
+    m_batch.reserve(qMax(frames * frameSize, m_policy.bytes + frameSize));
+}
+
+bool TxBatcher::Fits(int size) const
+{
+    return m_batch.isEmpty() || 0 == m_policy.bytes || m_batch.size() + size <= m_policy.bytes;
+}
+
+void TxBatcher::Append(const QByteArray &frame)
+{
+    qint64 now = monotonicNs();
+
+    if(m_batch.isEmpty())
+    {
+        m_firstAt = now;
+    }
+
+    m_batch.append(frame);
+    m_batchFrames++;
+    // Relative to the oldest frame, absolute nanosecond times added up would overflow
+    m_appendedSum += now - m_firstAt;
+}
+
+bool TxBatcher::isFull() const
+{
+    return (m_policy.frames && m_policy.frames <= m_batchFrames) || (m_policy.bytes && m_policy.bytes <= m_batch.size());
+}
+
+bool TxBatcher::isEmpty() const
+{
+    return m_batch.isEmpty();
+}
+
+const QByteArray &TxBatcher::getBatch() const
+{
+    return m_batch;
+}
+
+int TxBatcher::getFrames() const
+{
+    return m_batchFrames;
+}
+
+void TxBatcher::Written(bool ok)
+{
+    qint64 now = monotonicNs();
+
+    m_writes++;
+    m_failed += ok ? 0 : 1;
+    m_frames += m_batchFrames;
+    m_bytes += m_batch.size();
+    // Sum of now - appended over the frames of the batch
+    m_lingerSum += m_batchFrames * (now - m_firstAt) - m_appendedSum;
+    m_lingerMax = qMax(m_lingerMax, now - m_firstAt);
+    // Keeps the reserved capacity
+    m_batch.resize(0);
+    m_batchFrames = 0;
+    m_appendedSum = 0;
+}
+
+void TxBatcher::ClearCounters()
+{
+    m_frames = 0;
+    m_bytes = 0;
+    m_writes = 0;
+    m_failed = 0;
+    m_lingerSum = 0;
+    m_lingerMax = 0;
+}
+
+QString TxBatcher::Report() const
+{
+    return QString("TX batching frames %1, bytes %2, linger %3 us : %4 frames in %5 writes (%6 failed), "
+                   "%7 writes per frame, %8 bytes per write, held back mean %9 us, max %10 us")
+           .arg(m_policy.frames).arg(m_policy.bytes).arg(m_policy.linger).arg(m_frames).arg(m_writes).arg(m_failed)
+           .arg(m_frames ? (double)m_writes / m_frames : 0, 0, 'f', 3).arg(m_writes ? m_bytes / m_writes : 0)
+           .arg(m_frames ? m_lingerSum / 1e3 / m_frames : 0, 0, 'f', 1).arg(m_lingerMax / 1e3, 0, 'f', 1);
+}
@@ -0,0 +1,61 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+#ifndef TX_BATCHER_H
+#define TX_BATCHER_H
+
+#include <QByteArray>
+#include <QString>
+
+// A batch is written when any limit is reached, 0 disables the limit
+struct BatchPolicy
+{
+    int     frames = 0;             // Frames per write
+    int     bytes = 0;              // [bytes] per write
+    int     linger = 0;             // [us] oldest frame waits at most this long, 0 until the send burst ends
+
+    // key=value list, e.g. frames=8,bytes=4096,us=500
+    static bool Parse(const QString &spec, BatchPolicy &policy, QString &error);
+};
+
+/*
+    Coalesces wire frames into one transport write. Each write is one write() call, one
+    bytesWritten event and one TX timer restart in the port, so the report counts writes
+    per frame next to how long the frames were held back.
+*/
+class TxBatcher
+{
+public:
+    void setPolicy(const BatchPolicy &policy);
+    const BatchPolicy &getPolicy() const;
+    bool isEnabled() const;
+    void Reserve(int frameSize);
+    bool Fits(int size) const;
+    void Append(const QByteArray &frame);
+    bool isFull() const;
+    bool isEmpty() const;
+    const QByteArray &getBatch() const;
+    int getFrames() const;
+    void Written(bool ok);
+    void ClearCounters();
+    QString Report() const;
+
+private:
+    BatchPolicy     m_policy;
+    bool            m_enabled = false;
+    QByteArray      m_batch;
+    int             m_batchFrames = 0;
+    qint64          m_appendedSum = 0;      // [ns] append times of the batch after the oldest one, added up
+    qint64          m_firstAt = 0;          // [ns] append time of the oldest frame
+    qint64          m_frames = 0;
+    qint64          m_bytes = 0;
+    qint64          m_writes = 0;
+    qint64          m_failed = 0;
+    qint64          m_lingerSum = 0;        // [ns] over all frames
+    qint64          m_lingerMax = 0;        // [ns]
+};
+
+#endif // TX_BATCHER_H
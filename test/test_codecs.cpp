@@ -0,0 +1,329 @@
+/*
+ * qCommTest - Serial Communication Test Tool
+ * Version 	: 1.0
+ * Date 	: 20.11.2017
+ * Author	: Eray Ozturk  | github.com/diffstorm
+*/
+// Behaviour checks of the pure codecs : byte stuffing, PRBS, ring buffer, test plan loading and the wire CRC
+#include "byte_stuffing.h"
+#include "prbs.h"
+#include "protocol.h"
+#include "ring_buffer.h"
+#include "test_plan.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { if(!(condition)) { printf("FAIL %s:%d : %s\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+typedef std::vector<uchar> Bytes;
+
+static Bytes Encode(Framing_t framing, const Bytes &data)
+{
+    Bytes out(static_cast<size_t>(ByteStuffing::MaxEncodedSize(framing, static_cast<qint64>(data.size()))));
+    qint64 n = ByteStuffing::Encode(framing, data.data(), static_cast<qint64>(data.size()), out.data());
+
+    CHECK(0 <= n && n <= static_cast<qint64>(out.size()));
+    out.resize(static_cast<size_t>(n));
+    return out;
+}
+
+// Decodes the block between the delimiters of an encoded frame
+static bool Decode(Framing_t framing, const Bytes &encoded, Bytes &out)
+{
+    size_t begin = (Framing_t::SLIP == framing) ? 1 : 0;
+    qint64 n;
+
+    out.resize(encoded.size());
+    n = ByteStuffing::Decode(framing, encoded.data() + begin, static_cast<qint64>(encoded.size() - begin - 1), out.data());
+
+    if(n < 0)
+    {
+        return false;
+    }
+
+    out.resize(static_cast<size_t>(n));
+    return true;
+}
+
+static void RoundTrip(Framing_t framing, const Bytes &data)
+{
+    uchar delimiter = ByteStuffing::Delimiter(framing);
+    Bytes encoded = Encode(framing, data), decoded;
+
+    CHECK(encoded.size() >= 2 && delimiter == encoded.back());
+    // The delimiter only ends the frame, and opens it for SLIP
+    for(size_t i = (Framing_t::SLIP == framing) ? 1 : 0; i + 1 < encoded.size(); i++)
+    {
+        CHECK(delimiter != encoded[i]);
+    }
+
+    CHECK(Decode(framing, encoded, decoded));
+    CHECK(data == decoded);
+}
+
+static void TestCobs()
+{
+    Bytes decoded;
+
+    CHECK(Encode(Framing_t::COBS, Bytes{}) == (Bytes{0x01, 0x00}));
+    CHECK(Encode(Framing_t::COBS, Bytes{0x00}) == (Bytes{0x01, 0x01, 0x00}));
+    CHECK(Encode(Framing_t::COBS, Bytes{0x11, 0x22, 0x00, 0x33}) == (Bytes{0x03, 0x11, 0x22, 0x02, 0x33, 0x00}));
+    CHECK(Encode(Framing_t::COBS, Bytes{0x11, 0x00, 0x00}) == (Bytes{0x02, 0x11, 0x01, 0x01, 0x00}));
+
+    // 254 non zero bytes fill one block, the 255th starts the next one
+    for(size_t n : {253, 254, 255, 508, 509})
+    {
+        Bytes data(n);
+
+        for(size_t i = 0; i < n; i++)
+        {
+            data[i] = static_cast<uchar>(1 + i % 255);
+        }
+
+        RoundTrip(Framing_t::COBS, data);
+    }
+
+    CHECK(Encode(Framing_t::COBS, Bytes(254, 0x01))[0] == 0xFF);
+
+    // A code byte pointing past the end of the block is malformed
+    CHECK(!Decode(Framing_t::COBS, Bytes{0x05, 0x11, 0x22, 0x00}, decoded));
+    CHECK(!Decode(Framing_t::COBS, Bytes{0x02, 0x11, 0x05, 0x00}, decoded));
+}
+
+static void TestSlip()
+{
+    Bytes decoded;
+
+    CHECK(Encode(Framing_t::SLIP, Bytes{0x01, 0xC0, 0xDB, 0x02}) == (Bytes{0xC0, 0x01, 0xDB, 0xDC, 0xDB, 0xDD, 0x02, 0xC0}));
+    CHECK(Encode(Framing_t::SLIP, Bytes{}) == (Bytes{0xC0, 0xC0}));
+    RoundTrip(Framing_t::SLIP, Bytes(300, 0xC0));
+    RoundTrip(Framing_t::SLIP, Bytes(300, 0xDB));
+
+    // An escape must be followed by ESC_END or ESC_ESC
+    CHECK(!Decode(Framing_t::SLIP, Bytes{0xC0, 0x01, 0xDB, 0x02, 0xC0}, decoded));
+    CHECK(!Decode(Framing_t::SLIP, Bytes{0xC0, 0x01, 0xDB, 0xC0}, decoded));
+}
+
+static void TestStuffingRandom()
+{
+    quint32 seed = 12345;
+
+    for(int round = 0; round < 500; round++)
+    {
+        Bytes data(static_cast<size_t>(round * 3));
+
+        for(uchar &b : data)
+        {
+            seed = seed * 1103515245 + 12345;
+            // Bias towards the special bytes
+            b = (seed >> 16) % 4 ? static_cast<uchar>(seed >> 24) : static_cast<uchar>((seed >> 8) % 2 ? 0x00 : 0xC0);
+        }
+
+        RoundTrip(Framing_t::COBS, data);
+        RoundTrip(Framing_t::SLIP, data);
+    }
+}
+
+// Bit serial LFSR as the pattern is specified, seed all ones, MSB first
+static Bytes ReferencePrbs(int degree, int tap, size_t n)
+{
+    quint32 mask = (1u << degree) - 1, state = mask;
+    Bytes out(n);
+
+    for(uchar &byte : out)
+    {
+        byte = 0;
+
+        for(int bit = 0; bit < 8; bit++)
+        {
+            quint32 b = ((state >> (degree - 1)) ^ (state >> (tap - 1))) & 1;
+            state = ((state << 1) | b) & mask;
+            byte = static_cast<uchar>((byte << 1) | b);
+        }
+    }
+
+    return out;
+}
+
+static void TestPrbs()
+{
+    const struct { Prbs_t type; int degree; int tap; } patterns[] =
+    {
+        {Prbs_t::PRBS7, 7, 6}, {Prbs_t::PRBS15, 15, 14}, {Prbs_t::PRBS23, 23, 18}, {Prbs_t::PRBS31, 31, 28}
+    };
+    PrbsGenerator generator;
+    Prbs_t type;
+
+    for(const auto &pattern : patterns)
+    {
+        const size_t n = 5000;
+        Bytes expected = ReferencePrbs(pattern.degree, pattern.tap, n), whole(n), pieces(n);
+        size_t done = 0;
+
+        generator.Reset(pattern.type);
+        generator.Fill(whole.data(), static_cast<qint64>(n));
+        CHECK(expected == whole);
+        CHECK(generator.isSelfConsistent(whole.data(), static_cast<qint64>(n), 0));
+
+        // Uneven fills continue the same stream
+        generator.Reset(pattern.type);
+
+        for(size_t chunk = 1; done < n; chunk = chunk * 3 + 1)
+        {
+            chunk = qMin(chunk, n - done);
+            generator.Fill(pieces.data() + done, static_cast<qint64>(chunk));
+            done += chunk;
+        }
+
+        CHECK(expected == pieces);
+
+        // A shifted part of the stream is consistent, a flipped bit breaks up to three checks
+        CHECK(generator.isSelfConsistent(whole.data() + 77, static_cast<qint64>(n - 77), 0));
+        whole[1000] ^= 0x10;
+        CHECK(!generator.isSelfConsistent(whole.data(), static_cast<qint64>(n), 0));
+        CHECK(generator.isSelfConsistent(whole.data(), static_cast<qint64>(n), 3));
+
+        CHECK(PrbsGenerator::FromName(PrbsGenerator::Name(pattern.type), type) && type == pattern.type);
+    }
+
+    // PRBS7 repeats every 127 bits, so every 127 bytes
+    {
+        Bytes stream(400);
+
+        generator.Reset(Prbs_t::PRBS7);
+        generator.Fill(stream.data(), static_cast<qint64>(stream.size()));
+        CHECK(0 == memcmp(stream.data(), stream.data() + 127, stream.size() - 127));
+    }
+
+    CHECK(!PrbsGenerator::FromName("prbs9", type));
+}
+
+static void TestRingBuffer()
+{
+    RingBuffer ring(16);
+    char out[16];
+    const char *first, *second;
+    qint64 firstSize, secondSize;
+
+    CHECK(16 == ring.capacity() && ring.isEmpty());
+    CHECK(10 == ring.write("0123456789", 10));
+    ring.consume(8);
+    // Wraps at the end of the storage
+    CHECK(10 == ring.write("abcdefghij", 10));
+    CHECK(12 == ring.size() && 4 == ring.freeSpace());
+    CHECK(1 == ring.wrapArounds());
+    CHECK(2 == ring.spans(first, firstSize, second, secondSize));
+    CHECK(8 == firstSize && 4 == secondSize);
+    CHECK(0 == memcmp(first, "89abcdef", 8) && 0 == memcmp(second, "ghij", 4));
+
+    CHECK(nullptr != ring.contiguous(0, 8));
+    CHECK(nullptr == ring.contiguous(6, 4));
+    CHECK(4 == ring.copy(out, 6, 4) && 0 == memcmp(out, "efgh", 4));
+    CHECK('i' == ring.at(10));
+    CHECK(9 == ring.indexOf('h'));
+    CHECK(9 == ring.indexOf('h', 9));
+    CHECK(-1 == ring.indexOf('h', 10));
+    CHECK(-1 == ring.indexOf('z'));
+    CHECK(12 == ring.highWaterMark());
+
+    // What does not fit is counted and dropped
+    CHECK(4 == ring.write("klmnop", 6));
+    CHECK(2 == ring.overflows() && 0 == ring.freeSpace());
+    CHECK(4 == ring.copy(out, 12, 8) && 0 == memcmp(out, "klmn", 4));
+
+    ring.consume(16);
+    CHECK(ring.isEmpty() && nullptr == ring.contiguous(0, 1));
+    CHECK(0 == ring.copy(out, 0, 4));
+}
+
+static bool LoadPlan(const QTemporaryDir &dir, const char *json, TestPlan &plan, QString &error)
+{
+    QFile file(dir.filePath("plan.json"));
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    file.write(json);
+    file.close();
+    return plan.Load(file.fileName(), error);
+}
+
+static void TestPlanLoad()
+{
+    QTemporaryDir dir;
+    TestPlan plan;
+    QString error;
+
+    CHECK(dir.isValid());
+    CHECK(LoadPlan(dir, "{ \"name\": \"smoke\", \"phases\": [ {},"
+                        " { \"name\": \"burst\", \"size\": { \"from\": 64, \"to\": 8, \"step\": 8 }, \"repeat\": 3, \"window\": 4,"
+                        " \"rate\": 100, \"payload\": \"prbs7\", \"frame_timeout_ms\": 50,"
+                        " \"pass\": { \"max_errors\": 2, \"max_p99_us\": 900, \"min_throughput_kbps\": 10 } } ] }", plan, error));
+    CHECK("smoke" == plan.getName());
+    CHECK(2 == plan.count());
+
+    if(2 == plan.count())
+    {
+        const PlanPhase &defaults = plan.phase(0), &burst = plan.phase(1);
+        PlanPhase expected;
+
+        CHECK("phase 1" == defaults.name);
+        CHECK(expected.sizeFrom == defaults.sizeFrom && expected.sizeTo == defaults.sizeTo && expected.window == defaults.window);
+        CHECK("burst" == burst.name);
+        CHECK(64 == burst.sizeFrom && 8 == burst.sizeTo && 8 == burst.sizeStep);
+        CHECK(3 == burst.repeat && 4 == burst.window && 100 == burst.rate && 50 == burst.frameTimeout);
+        CHECK("prbs7" == burst.payload);
+        CHECK(2 == burst.maxErrors && 900 == burst.maxP99 && 10 == burst.minThroughput);
+        // A falling sweep of 64, 56 .. 8 bytes
+        CHECK(8 == burst.Sizes() && 24 == burst.Frames());
+        CHECK(64 == burst.SizeAt(0) && 56 == burst.SizeAt(3) && 8 == burst.SizeAt(23));
+        CHECK(64 == plan.MaxSize() && 4 == plan.MaxWindow());
+    }
+
+    CHECK(!plan.Load(dir.filePath("missing.json"), error) && !error.isEmpty());
+    CHECK(!LoadPlan(dir, "[ 1, 2 ]", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"size\": { \"from\": 1, \"to\": 400 ", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"size\": { \"from\": 0 } } ] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"size\": { \"to\": 70000 } } ] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"size\": { \"step\": 0 } } ] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"repeat\": 0 } ] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"rate\": -1 } ] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"frame_timeout_ms\": 0 } ] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"window\": 0 } ] }", plan, error));
+    CHECK(!LoadPlan(dir, "{ \"phases\": [ { \"window\": 65 } ] }", plan, error));
+    CHECK(error.contains("window"));
+}
+
+static void TestCrc()
+{
+    const char start[] = {0x00};
+    const uchar check[] = "123456789";
+
+    // The start frame of the protocol, 00 00 01 00 d2 02 ef 8d
+    CHECK(0xd202ef8d == ProtocolCrc32(start, 1));
+    CHECK(0xCBF43926 == Crc32(0, check, 9));
+    CHECK(0xCBF43926 == Crc32(Crc32(0, check, 4), check + 4, 5));
+}
+
+int main()
+{
+    TestCobs();
+    TestSlip();
+    TestStuffingRandom();
+    TestPrbs();
+    TestRingBuffer();
+    TestPlanLoad();
+    TestCrc();
+
+    printf("%s, %d failures\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
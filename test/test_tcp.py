@@ -1,3 +1,4 @@
+import argparse
 import socket
 import time
 
@@ -8,9 +9,169 @@ SEND_RECEIVE_TIMEOUT = 0.5  # 500 ms timeout for sending/receiving
 TEST_INDEX_MAX = 400
 FAIL_TRY_MAX = 100
 
+PROTOCOL_OVERHEAD = 7       # Header byte, 16-bit length and 32-bit CRC
+HEADER_CLASSIC = 0x00
+HEADER_EXTENDED = 0x01      # seq32 | timestamp64 follow the length
+EXT_HEADER_SIZE = 12
+PROTOCOL_VERSION_EXT = 0x02 # Second start payload byte offering the extended header
+COBS_DELIMITER = 0x00
+SLIP_END = 0xC0
+SLIP_ESC = 0xDB
+SLIP_ESC_END = 0xDC
+SLIP_ESC_ESC = 0xDD
+
 # The initial data sequence to start communication
 START_DATA = bytes([0x00, 0x00, 0x01, 0x00, 0xd2, 0x02, 0xef, 0x8d])
 
+def protocol_crc32(data):
+    """Frame checksum as the device computes it: every other byte, chars sign extended."""
+    crc = 0xFFFFFFFF
+    for i in range(0, len(data), 2):
+        byte = data[i]
+        if byte & 0x80:
+            byte |= 0xFFFFFF00
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0xEDB88320 if crc & 1 else 0)
+    return ~crc & 0xFFFFFFFF
+
+def wrap(payload, extended=False, seq=0):
+    """Builds a frame, the extended header carries the sequence number and the send time."""
+    frame = bytearray([HEADER_EXTENDED if extended else HEADER_CLASSIC])
+    frame += len(payload).to_bytes(2, 'big')
+    if extended:
+        frame += seq.to_bytes(4, 'big')
+        frame += time.monotonic_ns().to_bytes(8, 'big')
+    frame += payload
+    frame += protocol_crc32(frame[3:]).to_bytes(4, 'big')
+    return bytes(frame)
+
+def unwrap(frame):
+    """Returns (extended, seq, payload) of a valid frame, None otherwise."""
+    extended = len(frame) > 0 and frame[0] == HEADER_EXTENDED
+    header = 3 + (EXT_HEADER_SIZE if extended else 0)
+    if len(frame) < header + 4 or frame[0] not in (HEADER_CLASSIC, HEADER_EXTENDED):
+        return None
+    length = int.from_bytes(frame[1:3], 'big')
+    if len(frame) != header + length + 4:
+        return None
+    if protocol_crc32(frame[3:header + length]) != int.from_bytes(frame[header + length:], 'big'):
+        return None
+    seq = int.from_bytes(frame[3:7], 'big') if extended else 0
+    return extended, seq, frame[header:header + length]
+
+def cobs_encode(data):
+    """COBS with a trailing 0x00 delimiter."""
+    out = bytearray()
+    i = 0
+    while True:
+        block = data[i:i + 254]
+        zero = block.find(COBS_DELIMITER)
+        if zero >= 0:
+            out.append(zero + 1)
+            out += block[:zero]
+            i += zero + 1
+            continue
+        out.append(len(block) + 1)
+        out += block
+        i += len(block)
+        if i >= len(data):
+            break
+    out.append(COBS_DELIMITER)
+    return bytes(out)
+
+def cobs_decode(block):
+    """Decodes one block between delimiters, None if it is malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(block):
+            return None
+        out += block[i:i + code - 1]
+        i += code - 1
+        if code != 255 and i < len(block):
+            out.append(COBS_DELIMITER)
+    return bytes(out)
+
+def slip_encode(data):
+    """RFC 1055 with an END on both ends."""
+    out = bytearray([SLIP_END])
+    for byte in data:
+        if byte == SLIP_END:
+            out += bytes([SLIP_ESC, SLIP_ESC_END])
+        elif byte == SLIP_ESC:
+            out += bytes([SLIP_ESC, SLIP_ESC_ESC])
+        else:
+            out.append(byte)
+    out.append(SLIP_END)
+    return bytes(out)
+
+def slip_decode(block):
+    """Decodes one block between END bytes, None if an escape is malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        byte = block[i]
+        i += 1
+        if byte == SLIP_ESC:
+            if i >= len(block) or block[i] not in (SLIP_ESC_END, SLIP_ESC_ESC):
+                return None
+            byte = SLIP_END if block[i] == SLIP_ESC_END else SLIP_ESC
+            i += 1
+        out.append(byte)
+    return bytes(out)
+
+def encode(frame, framing):
+    """Stuffs a frame for the wire, as is without framing."""
+    if framing == 'cobs':
+        return cobs_encode(frame)
+    if framing == 'slip':
+        return slip_encode(frame)
+    return frame
+
+class FrameReader:
+    """Reads whole frames from the socket, by the length field or between the framing delimiters."""
+    def __init__(self, sock, framing='none'):
+        self.sock = sock
+        self.framing = framing
+        self.buffer = bytearray()
+
+    def fill(self, length):
+        while len(self.buffer) < length:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise RuntimeError("Socket connection broken")
+            self.buffer.extend(chunk)
+
+    def read(self):
+        if self.framing != 'none':
+            return self.read_stuffed()
+        self.fill(3)
+        total = PROTOCOL_OVERHEAD + int.from_bytes(self.buffer[1:3], 'big')
+        if self.buffer[0] == HEADER_EXTENDED:
+            total += EXT_HEADER_SIZE
+        self.fill(total)
+        frame = bytes(self.buffer[:total])
+        del self.buffer[:total]
+        return frame
+
+    def read_stuffed(self):
+        delimiter = SLIP_END if self.framing == 'slip' else COBS_DELIMITER
+        decode = slip_decode if self.framing == 'slip' else cobs_decode
+        while True:
+            end = self.buffer.find(delimiter)
+            if end < 0:
+                self.fill(len(self.buffer) + 1)
+                continue
+            block = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            # SLIP frames open with an END too, the empty block between them is skipped
+            if block:
+                frame = decode(block)
+                return frame if frame is not None else b''
+
 def connect_to_server(ip, port, timeout):
     """Establishes a TCP connection to the server."""
     sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
@@ -23,88 +184,109 @@ def connect_to_server(ip, port, timeout):
         print(f"Connection failed: {e}")
         return None
 
-def recv_all(sock, length):
-    """Receives the exact amount of data specified by 'length' from the socket."""
-    data = bytearray()
-    while len(data) < length:
-        chunk = sock.recv(length - len(data))
-        if not chunk:
-            raise RuntimeError("Socket connection broken")
-        data.extend(chunk)
-    return bytes(data)
-
-def send_receive(sock, send_data, expected_recv_length):
-    """Sends data to the server and waits for the expected amount of response data."""
-    if send_data is None:
-        print("No data to send")
+def echo(frame):
+    """The device's answer to a host frame in the same header, None if the frame is not valid."""
+    fields = unwrap(frame)
+    if fields is None:
         return None
+    extended, seq, payload = fields
+    if not extended:
+        return frame
+    # Same sequence number and payload, the device's own send time
+    return wrap(payload, True, seq)
 
-    try:
-        sock.sendall(send_data)
-        print(f"Sent {len(send_data)} bytes")
-
-        received_data = recv_all(sock, expected_recv_length)
-        print(f"Received {len(received_data)} bytes")
-
-        return received_data
-    except (socket.timeout, socket.error) as e:
-        print(f"Communication error: {e}")
-        return None
-
-def run_communication_test():
+def run_communication_test(args):
     """Runs the communication test with the server, retrying on failure up to a limit."""
-    test_index = 1
     fail_try = FAIL_TRY_MAX
-    response = None
+    frames = args.frames if args.frames else TEST_INDEX_MAX
+    start = wrap(bytes([0x00, PROTOCOL_VERSION_EXT])) if args.ext_header else START_DATA
+    sock = None
+    reader = None
+    frame = None
 
     # Attempt to establish a connection and start the test
     while fail_try > 0:
-        sock = connect_to_server(SERVER_IP, SERVER_PORT, SEND_RECEIVE_TIMEOUT)
+        sock = connect_to_server(SERVER_IP, args.port, SEND_RECEIVE_TIMEOUT)
         if sock is None:
             fail_try -= 1
             time.sleep(0.002)
             continue
 
-        # Send initial data to start the test
-        response = send_receive(sock, START_DATA, 7 + test_index)
-        if response and len(response) == 7 + test_index:
+        # Send the start frame, the host answers with the first test frame
+        try:
+            sock.sendall(encode(start, args.framing))
+            reader = FrameReader(sock, args.framing)
+            frame = reader.read()
             print("Test started successfully")
-            test_index += 1
             break
-        else:
+        except (socket.timeout, socket.error, RuntimeError) as e:
+            print(f"Communication error: {e}")
             fail_try -= 1
             sock.close()
             time.sleep(0.002)
 
     if fail_try == 0:
         print("Failed to start communication test")
-        return
+        return 1
 
-    # Main communication loop
+    # Main communication loop, the host does not wait for the echo of its last frame
+    test_index = 1
     total_time = 0
-    while test_index <= TEST_INDEX_MAX and fail_try > 0:
-        expected_rx_length = 7 + test_index
-
-        start_time = time.time()
-        response = send_receive(sock, response, expected_rx_length)
-        elapsed_time = (time.time() - start_time) * 1e6  # Convert to microseconds
-
-        if response and len(response) == expected_rx_length:
+    elapsed_time = 0
+    while test_index <= frames and fail_try > 0:
+        fields = unwrap(frame)
+        if fields is None:
+            fail_try -= 1
+            print(f"Fail {fail_try}, invalid frame")
+        elif fields[0] != args.ext_header:
+            fail_try -= 1
+            print(f"Fail {fail_try}, extended header {'expected' if args.ext_header else 'not negotiated'}")
+        elif not args.frames and len(fields[2]) != test_index:
+            fail_try -= 1
+            print(f"Fail {fail_try}, {len(fields[2])} bytes, expected {test_index}")
+        else:
             print(f"Success {test_index}, Time: {elapsed_time:.0f} us")
             total_time += elapsed_time
             test_index += 1
-        else:
-            fail_try -= 1
-            print(f"Fail {fail_try}")
+
+        if test_index > frames:
+            break
+
+        start_time = time.time()
+        reply = echo(frame)
+        frame = None
+        while frame is None and fail_try > 0:
+            try:
+                if reply is not None:
+                    sock.sendall(encode(reply, args.framing))
+                    reply = None
+                frame = reader.read()
+            except (socket.timeout, socket.error, RuntimeError) as e:
+                fail_try -= 1
+                print(f"Communication error: {e}")
+        if frame is None:
+            break
+        elapsed_time = (time.time() - start_time) * 1e6  # Convert to microseconds
         time.sleep(0.002)
 
     # Test result
-    if test_index > TEST_INDEX_MAX and fail_try > 0:
+    if test_index > frames and fail_try > 0:
         print("Test passed")
         return 0
     else:
         print("Test failed")
         return 1
 
+def parse_args():
+    parser = argparse.ArgumentParser(description="Device side of the qCommTest echo protocol over TCP.")
+    parser.add_argument('--port', type=int, default=SERVER_PORT)
+    parser.add_argument('--framing', choices=['none', 'cobs', 'slip'], default='none',
+                        help="byte stuffing, as given to qCommTest --framing")
+    parser.add_argument('--ext-header', action='store_true',
+                        help="offer the extended header and answer with sequence number and send time")
+    parser.add_argument('--frames', type=int, default=0,
+                        help="frames of a test plan, sizes are not checked (default the 1..400 byte sweep)")
+    return parser.parse_args()
+
 if __name__ == "__main__":
-    exit(run_communication_test())
+    exit(run_communication_test(parse_args()))